@@ -0,0 +1,552 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "host.h"
+#include "planter_utils.h"
+#include "rest_api.h"
+#include "sensor.h"
+
+// Reference time at boot, 2025-08-10 06:00:00 UTC
+#define BENCH_EPOCH 1754805600
+
+// Cycles timed per case
+#define BENCH_CYCLES 1000
+
+// Device stack of the task running a case, large enough for host frames
+#define BENCH_STACK 16384
+
+#define BENCH_MAX_SENSORS 64
+#define BENCH_MAX_ROWS 32
+#define BENCH_JSON_SIZE 128
+
+// Bytes handed to the parameter parser at a time, as read from a response
+#define BENCH_CHUNK 64
+
+// Raw samples cycled through the filters, a reading with ADC jitter
+#define BENCH_SAMPLES 64
+
+/**
+ * @brief Case run in its own task
+ *
+ */
+typedef struct {
+    const char* name;
+    int (*run)(int num_sensors);    // One cycle, -1 on failure
+    int num_sensors;                // 0 for cases independent of sensors
+} bench_case;
+
+/**
+ * @brief Figures of one case
+ *
+ */
+typedef struct {
+    const char* name;
+    int num_sensors;
+    double ns_per_sensor;
+    double allocs_per_cycle;
+    int stack_bytes;
+    double bytes_per_cycle;
+    double requests_per_cycle;
+    double body_per_sensor;         // Request body or encoded bytes
+} bench_row;
+
+/**
+ * @brief Filter state of the double precision reference
+ *
+ */
+typedef struct {
+    double os_sum;
+    int os_count;
+    double window[FILTER_MEDIAN_MAX];
+    int win_len;
+    int win_pos;
+    double ema;
+    bool ema_ready;
+} double_filter;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+static const int sensor_counts[] = { 4, 16, 64 };
+static const int num_counts = sizeof(sensor_counts) / sizeof(sensor_counts[0]);
+
+// Parameters as returned by the Firebase GET
+static const char params_doc[] =
+    "{\"Moisture_High_Set\":60,\"Moisture_Low_Set\":35,"
+    "\"Valve_Times_Set\":{\"VALVE_1\":[6,18],\"VALVE_2\":[7,12,19]},"
+    "\"Water_Duration_Set\":45,\"Water_Times_Set\":[6,12,18]}";
+
+static sensor sensors[BENCH_MAX_SENSORS];
+static sensor_record records[BENCH_MAX_SENSORS];
+static adc_reader* reader = NULL;
+static double_filter double_filters[BENCH_MAX_SENSORS];
+static int samples[BENCH_SAMPLES];
+static volatile int sink = 0;
+
+static bench_row rows[BENCH_MAX_ROWS];
+static int num_rows = 0;
+static TaskHandle_t main_handle = NULL;
+
+// Allocations by the firmware, not the stand-in server
+static bool counting = false;
+static unsigned long body_bytes = 0;
+static unsigned long allocs = 0;
+
+void* __wrap_malloc(size_t size) {
+    allocs += counting;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t nmemb, size_t size) {
+    allocs += counting;
+    return __real_calloc(nmemb, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    allocs += counting;
+    return __real_realloc(ptr, size);
+}
+
+static void http_handler(const host_http_request* request,
+    host_http_response* response, void* ctx) {
+        bool was_counting = counting;
+        if (counting) {
+            body_bytes += request->body_len;
+        }
+        counting = false;
+        host_firebase_handler(request, response, NULL);
+        counting = was_counting;
+}
+
+static void init_sensors(void) {
+    // Channels of ADC1 then ADC2, larger sets share them
+    for (int i = 0; i < BENCH_MAX_SENSORS; i++) {
+        snprintf(sensors[i].name, sizeof(sensors[i].name), "SENSOR_%d", i + 1);
+        sensors[i].unit = (i / ADC_MAX_CHANNELS) % ADC_MAX_UNITS;
+        sensors[i].channel = i % ADC_MAX_CHANNELS;
+        sensors[i].mean_dry = 2712;
+        sensors[i].mean_wet = 970;
+        sensors[i].filter = (sens_filter){ .config = { .oversample = 4,
+            .median = 5, .ema_shift = 2 } };
+        host_adc_set_level(sensors[i].unit, sensors[i].channel,
+            1000 + 170 * sensors[i].channel);
+    }
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        samples[i] = 2000 + (i * 37) % 61 - 30;
+    }
+}
+
+static void read_sensors(int num_sensors) {
+    time_t now = time(NULL);
+    for (int i = 0; i < num_sensors; i++) {
+        records[i].name = sensors[i].name;
+        records[i].sensor_id = i;
+        records[i].timestamp = now;
+        records[i].moisture = map(&sensors[i],
+            read_filtered(reader, &sensors[i]));
+    }
+}
+
+static int run_read(int num_sensors) {
+    read_sensors(num_sensors);
+
+    return 0;
+}
+
+static int run_batch(int num_sensors) {
+    read_sensors(num_sensors);
+
+    esp_http_client_handle_t client = acquire_client("sensor_data",
+        FIREBASE_URL, FIREBASE_API_KEY);
+    int status = patch_records(client, records, num_sensors);
+    release_client(client, status == -1);
+
+    return status;
+}
+
+static int run_post(int num_sensors) {
+    read_sensors(num_sensors);
+
+    // Body of each reading as written by the report task
+    struct tm timeinfo;
+    get_local_time(&timeinfo);
+    esp_http_client_handle_t client = acquire_client("sensor_data",
+        FIREBASE_URL, FIREBASE_API_KEY);
+    int status = 0;
+    for (int i = 0; i < num_sensors && status == 0; i++) {
+        char json[BENCH_JSON_SIZE];
+        snprintf(json, sizeof(json),
+            "{\"Name\": \"%s\", "
+            "\"Month\": %d, "
+            "\"Day\": %d, "
+            "\"Hour\": %d, "
+            "\"Moisture\": %d.%02d}",
+            records[i].name,
+            timeinfo.tm_mon+1,
+            timeinfo.tm_mday,
+            timeinfo.tm_hour,
+            records[i].moisture / 100,
+            records[i].moisture % 100
+        );
+        status = post_data(client, json);
+    }
+    release_client(client, status == -1);
+
+    return status;
+}
+
+static int run_upload_packed(int num_sensors) {
+    read_sensors(num_sensors);
+
+    esp_http_client_handle_t client = acquire_client("sensor_data",
+        FIREBASE_URL, FIREBASE_API_KEY);
+    int status = send_records(client, &packed_codec, records, num_sensors,
+        REST_ENCODING_IDENTITY);
+    release_client(client, status == -1);
+
+    return status;
+}
+
+static int run_pack(int num_sensors) {
+    // Encoding alone, as for the offline queue
+    static uint8_t buffer[TELEMETRY_HEADER_SIZE +
+        BENCH_MAX_SENSORS * TELEMETRY_RECORD_MAX];
+    telemetry_packer packer;
+    pack_init(&packer, buffer, sizeof(buffer));
+    uint32_t now = (uint32_t)time(NULL);
+    for (int i = 0; i < num_sensors; i++) {
+        telemetry_record record = {
+            .timestamp = now,
+            .moisture = (uint16_t)map(&sensors[i], samples[i % BENCH_SAMPLES]),
+            .sensor_id = (uint8_t)i
+        };
+        if (pack_record(&packer, &record) != 0) {
+            return -1;
+        }
+    }
+    body_bytes += packer.len;
+
+    return 0;
+}
+
+static int run_params(int num_sensors) {
+    return parameter_comms();
+}
+
+static int run_json(int num_sensors) {
+    static params_binder binder;
+    int len = sizeof(params_doc) - 1;
+    params_begin(&binder, 0);
+    for (int pos = 0; pos < len; pos += BENCH_CHUNK) {
+        int chunk = len - pos < BENCH_CHUNK ? len - pos : BENCH_CHUNK;
+        if (params_feed(&binder, params_doc + pos, chunk) == -1) {
+            return -1;
+        }
+    }
+
+    return params_end(&binder);
+}
+
+static int run_filter(int num_sensors) {
+    for (int i = 0; i < num_sensors; i++) {
+        sens_filter* filter = &sensors[i].filter;
+        filter_reset(filter);
+        int burst = filter_burst_len(filter);
+        for (int j = 0; j < burst; j++) {
+            filter_push(filter, samples[(i + j) % BENCH_SAMPLES]);
+        }
+        sink = map(&sensors[i], filter->output);
+    }
+
+    return 0;
+}
+
+static double double_median(const double_filter* filter) {
+    double sorted[FILTER_MEDIAN_MAX];
+    int len = filter->win_len;
+    for (int i = 0; i < len; i++) {
+        double value = filter->window[i];
+        int j = i;
+        while (j > 0 && sorted[j-1] > value) {
+            sorted[j] = sorted[j-1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+
+    return sorted[len / 2];
+}
+
+static double double_push(double_filter* filter, const filter_config* config,
+    double raw) {
+        if (config->oversample > 1) {
+            filter->os_sum += raw;
+            filter->os_count++;
+            if (filter->os_count < config->oversample) {
+                return -1;
+            }
+            raw = filter->os_sum / filter->os_count;
+            filter->os_sum = 0;
+            filter->os_count = 0;
+        }
+
+        if (config->median > 1) {
+            filter->window[filter->win_pos] = raw;
+            filter->win_pos = (filter->win_pos + 1) % config->median;
+            if (filter->win_len < config->median) {
+                filter->win_len++;
+            }
+            raw = double_median(filter);
+        }
+
+        if (config->ema_shift > 0) {
+            double alpha = 1.0 / (1 << config->ema_shift);
+            filter->ema = filter->ema_ready ?
+                filter->ema + alpha * (raw - filter->ema) : raw;
+            filter->ema_ready = true;
+            raw = filter->ema;
+        }
+
+        return raw;
+}
+
+static double double_map(const sensor* sens, double val) {
+    // map() before the fixed-point scale
+    double mapped_val = (val - sens->mean_dry) /
+        (sens->mean_wet - sens->mean_dry);
+    if (mapped_val < 0) {
+        mapped_val = 0.00;
+    }
+    else if (mapped_val > 1) {
+        mapped_val = 1.00;
+    }
+
+    return mapped_val;
+}
+
+static int run_filter_f64(int num_sensors) {
+    // Same stages and burst as run_filter() in double precision
+    for (int i = 0; i < num_sensors; i++) {
+        double_filter* filter = &double_filters[i];
+        memset(filter, 0, sizeof(double_filter));
+        int burst = filter_burst_len(&sensors[i].filter);
+        double value = -1;
+        for (int j = 0; j < burst; j++) {
+            double out = double_push(filter, &sensors[i].filter.config,
+                samples[(i + j) % BENCH_SAMPLES]);
+            if (out >= 0) {
+                value = out;
+            }
+        }
+        sink = (int)(double_map(&sensors[i], value) * 10000);
+    }
+
+    return 0;
+}
+
+static int run_map(int num_sensors) {
+    for (int i = 0; i < num_sensors; i++) {
+        sink = map(&sensors[i], samples[i % BENCH_SAMPLES]);
+    }
+
+    return 0;
+}
+
+static int run_map_f64(int num_sensors) {
+    for (int i = 0; i < num_sensors; i++) {
+        sink = (int)(double_map(&sensors[i], samples[i % BENCH_SAMPLES]) *
+            10000);
+    }
+
+    return 0;
+}
+
+static void case_task(void* pvParameters) {
+    const bench_case* bench = (const bench_case*)pvParameters;
+    bench_row* row = &rows[num_rows];
+    row->name = bench->name;
+    row->num_sensors = bench->num_sensors;
+
+    // Untimed cycle to connect and fill the pools
+    bench->run(bench->num_sensors);
+
+    host_http_stats before = host_http_get_stats();
+    allocs = 0;
+    body_bytes = 0;
+    counting = true;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int failed = 0;
+    for (int i = 0; i < BENCH_CYCLES; i++) {
+        failed += bench->run(bench->num_sensors) == -1;
+    }
+    struct timespec stop;
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    counting = false;
+    host_http_stats after = host_http_get_stats();
+
+    if (failed > 0) {
+        printf("ERROR %d cycles of %s failed.\n", failed, bench->name);
+    }
+
+    double ns = (stop.tv_sec - start.tv_sec) * 1e9 +
+        (stop.tv_nsec - start.tv_nsec);
+    int per = bench->num_sensors > 0 ? bench->num_sensors : 1;
+    row->ns_per_sensor = ns / BENCH_CYCLES / per;
+    row->allocs_per_cycle = (double)allocs / BENCH_CYCLES;
+    row->stack_bytes = BENCH_STACK - uxTaskGetStackHighWaterMark(NULL);
+    row->bytes_per_cycle = (double)(after.bytes_sent + after.bytes_received -
+        before.bytes_sent - before.bytes_received) / BENCH_CYCLES;
+    row->requests_per_cycle = (double)(after.requests - before.requests) /
+        BENCH_CYCLES;
+    row->body_per_sensor = (double)body_bytes / BENCH_CYCLES / per;
+    num_rows++;
+
+    xTaskNotifyGive(main_handle);
+    vTaskDelete(NULL);
+}
+
+static void run_case(const char* name, int (*run)(int), int num_sensors) {
+    bench_case bench = {
+        .name = name,
+        .run = run,
+        .num_sensors = num_sensors
+    };
+    if (num_rows == BENCH_MAX_ROWS) {
+        printf("ERROR too many benchmark cases.\n");
+        return;
+    }
+
+    // Fresh task per case for its own stack high water mark
+    if (xTaskCreate(case_task, "BenchTask", BENCH_STACK, &bench, 5,
+        NULL) != pdPASS) {
+            printf("ERROR starting %s.\n", name);
+            return;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+static void bench_main(void) {
+    main_handle = xTaskGetCurrentTaskHandle();
+    init_sensors();
+    reader = init_adc(sensors, BENCH_MAX_SENSORS, SENS_MODE_ONESHOT);
+    if (reader == NULL || init_wifi() != 0) {
+        host_stop("setup failed");
+        vTaskDelay(portMAX_DELAY);
+    }
+    time_restore();
+
+    for (int i = 0; i < num_counts; i++) {
+        run_case("read", run_read, sensor_counts[i]);
+        run_case("batch", run_batch, sensor_counts[i]);
+        run_case("post", run_post, sensor_counts[i]);
+        run_case("batch_packed", run_upload_packed, sensor_counts[i]);
+        run_case("pack", run_pack, sensor_counts[i]);
+        run_case("filter", run_filter, sensor_counts[i]);
+        run_case("filter_f64", run_filter_f64, sensor_counts[i]);
+        run_case("map", run_map, sensor_counts[i]);
+        run_case("map_f64", run_map_f64, sensor_counts[i]);
+    }
+    run_case("params", run_params, 0);
+    run_case("json", run_json, 0);
+
+    host_stop("benchmark done");
+    vTaskDelay(portMAX_DELAY);
+}
+
+static const bench_row* find_baseline(const bench_row* baseline, int count,
+    const bench_row* row) {
+        for (int i = 0; i < count; i++) {
+            if (strcmp(baseline[i].name, row->name) == 0 &&
+                baseline[i].num_sensors == row->num_sensors) {
+                    return &baseline[i];
+            }
+        }
+
+        return NULL;
+}
+
+static int load_baseline(const char* path, bench_row* baseline,
+    char names[][16]) {
+        FILE* file = fopen(path, "r");
+        if (file == NULL) {
+            printf("ERROR opening baseline %s.\n", path);
+            return -1;
+        }
+
+        // Header line, then one row per case
+        char line[256];
+        int count = 0;
+        if (fgets(line, sizeof(line), file) == NULL) {
+            fclose(file);
+            return 0;
+        }
+        while (count < BENCH_MAX_ROWS && fgets(line, sizeof(line), file)) {
+            bench_row* row = &baseline[count];
+            if (sscanf(line, "%15[^,],%d,%lf,%lf,%d,%lf,%lf,%lf", names[count],
+                &row->num_sensors, &row->ns_per_sensor, &row->allocs_per_cycle,
+                &row->stack_bytes, &row->bytes_per_cycle,
+                &row->requests_per_cycle, &row->body_per_sensor) >= 7) {
+                    row->name = names[count];
+                    count++;
+            }
+        }
+        fclose(file);
+
+        return count;
+}
+
+int main(int argc, char** argv) {
+    bench_row baseline[BENCH_MAX_ROWS];
+    char baseline_names[BENCH_MAX_ROWS][16];
+    int num_baseline = 0;
+    if (argc > 1) {
+        num_baseline = load_baseline(argv[1], baseline, baseline_names);
+        if (num_baseline == -1) {
+            return 1;
+        }
+    }
+
+    // Firmware logs go to stderr, results alone to stdout
+    FILE* out = fdopen(dup(STDOUT_FILENO), "w");
+    if (out == NULL || dup2(STDERR_FILENO, STDOUT_FILENO) == -1) {
+        printf("ERROR redirecting output.\n");
+        return 1;
+    }
+    if (freopen("/dev/null", "r", stdin) == NULL) {
+        printf("ERROR reopening stdin.\n");
+        return 1;
+    }
+
+    host_clock_init(BENCH_EPOCH, 0);
+    host_http_set_handler(http_handler, NULL);
+    host_run(bench_main, (int64_t)24 * 3600 * 1000000);
+
+    fprintf(out, "case,sensors,ns_per_sensor,allocs_per_cycle,stack_bytes,"
+        "bytes_per_cycle,requests_per_cycle,body_bytes_per_sensor%s\n",
+        num_baseline > 0 ? ",baseline_ns_per_sensor,time_ratio" : "");
+    for (int i = 0; i < num_rows; i++) {
+        const bench_row* row = &rows[i];
+        fprintf(out, "%s,%d,%.0f,%.2f,%d,%.1f,%.2f,%.1f", row->name,
+            row->num_sensors, row->ns_per_sensor, row->allocs_per_cycle,
+            row->stack_bytes, row->bytes_per_cycle, row->requests_per_cycle,
+            row->body_per_sensor);
+
+        const bench_row* base = find_baseline(baseline, num_baseline, row);
+        if (base != NULL) {
+            fprintf(out, ",%.0f,%.2f", base->ns_per_sensor,
+                row->ns_per_sensor / base->ns_per_sensor);
+        }
+        else if (num_baseline > 0) {
+            fprintf(out, ",,");
+        }
+        fprintf(out, "\n");
+    }
+    fclose(out);
+
+    return num_rows > 0 ? 0 : 1;
+}
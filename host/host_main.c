@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "host.h"
+
+// Reference time at boot, 2025-08-10 06:00:00 UTC
+#define HOST_EPOCH 1754805600
+
+#define DEFAULT_HOURS 24
+
+void app_main(void);
+
+int main(int argc, char** argv) {
+    double hours = argc > 1 ? atof(argv[1]) : DEFAULT_HOURS;
+    int32_t drift_ppm = argc > 2 ? atoi(argv[2]) : 0;
+    if (hours <= 0) {
+        printf("Usage: %s [hours] [drift_ppm]\n", argv[0]);
+        return 1;
+    }
+
+    // Console task polls stdin, which must not wait for a terminal
+    if (freopen("/dev/null", "r", stdin) == NULL) {
+        printf("ERROR reopening stdin.\n");
+        return 1;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    host_clock_init(HOST_EPOCH, drift_ppm);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int64_t end = host_run(app_main, (int64_t)(hours * 3600 * 1000000));
+    struct timespec stop;
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    double wall_ms = (stop.tv_sec - start.tv_sec) * 1000.0 +
+        (stop.tv_nsec - start.tv_nsec) / 1000000.0;
+    host_http_stats http = host_http_get_stats();
+
+    printf("\n");
+    printf("Simulated: %.2f h in %.0f ms (%.0f ms CPU)\n", end / 3.6e9,
+        wall_ms, host_cpu_us() / 1000.0);
+    printf("HTTP: %lu requests, %lu failed, %lu connects, %lu dropped\n",
+        (unsigned long)http.requests, (unsigned long)http.failures,
+        (unsigned long)http.connects, (unsigned long)http.drops);
+    printf("HTTP bytes: %llu sent, %llu received\n",
+        (unsigned long long)http.bytes_sent,
+        (unsigned long long)http.bytes_received);
+
+    return 0;
+}
@@ -0,0 +1,21 @@
+/**
+ * @file esp_attr.h
+ * @brief Host shim of the ESP-IDF placement attributes
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Code and data have no special placement on the host. RTC memory
+ * is ordinary memory, so it keeps its contents for the whole run.
+ *
+ */
+
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+#endif
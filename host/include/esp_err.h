@@ -0,0 +1,74 @@
+/**
+ * @file esp_err.h
+ * @brief Host shim of the ESP-IDF error codes
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ */
+
+#ifndef ESP_ERR_H
+#define ESP_ERR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_INVALID_SIZE 0x104
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_NOT_SUPPORTED 0x106
+#define ESP_ERR_TIMEOUT 0x107
+
+#define ESP_ERR_NVS_BASE 0x1100
+#define ESP_ERR_NVS_NOT_INITIALIZED (ESP_ERR_NVS_BASE + 0x01)
+#define ESP_ERR_NVS_NOT_FOUND (ESP_ERR_NVS_BASE + 0x02)
+#define ESP_ERR_NVS_NO_FREE_PAGES (ESP_ERR_NVS_BASE + 0x0d)
+#define ESP_ERR_NVS_NEW_VERSION_FOUND (ESP_ERR_NVS_BASE + 0x10)
+
+#define ESP_ERR_WIFI_BASE 0x3000
+#define ESP_ERR_WIFI_NOT_INIT (ESP_ERR_WIFI_BASE + 1)
+#define ESP_ERR_WIFI_NOT_STARTED (ESP_ERR_WIFI_BASE + 2)
+#define ESP_ERR_WIFI_NOT_STOPPED (ESP_ERR_WIFI_BASE + 3)
+#define ESP_ERR_WIFI_CONN (ESP_ERR_WIFI_BASE + 7)
+
+#define ESP_ERR_HTTP_BASE 0x7000
+#define ESP_ERR_HTTP_CONNECT (ESP_ERR_HTTP_BASE + 3)
+#define ESP_ERR_HTTP_WRITE_DATA (ESP_ERR_HTTP_BASE + 4)
+#define ESP_ERR_HTTP_FETCH_HEADER (ESP_ERR_HTTP_BASE + 5)
+#define ESP_ERR_HTTP_EAGAIN (ESP_ERR_HTTP_BASE + 7)
+
+/**
+ * @brief Name of an error code
+ *
+ * @param[in] code Error code
+ *
+ * @return const char*: Name of the code, "UNKNOWN ERROR" if not known
+ *
+ */
+const char* esp_err_to_name(esp_err_t code);
+
+#define ESP_ERROR_CHECK(x) do {                                             \
+        esp_err_t err_rc_ = (x);                                            \
+        if (err_rc_ != ESP_OK) {                                            \
+            printf("ESP_ERROR_CHECK failed: %s at %s:%d\n",                 \
+                esp_err_to_name(err_rc_), __FILE__, __LINE__);             \
+            abort();                                                        \
+        }                                                                   \
+    } while (0)
+
+// Newlib has strlcpy, older glibc versions do not
+size_t strlcpy(char* dst, const char* src, size_t size);
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * @file esp_event.h
+ * @brief Host shim of the ESP-IDF default event loop
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Events are delivered in order by a "sys_evt" task, as on the
+ * device.
+ *
+ */
+
+#ifndef ESP_EVENT_H
+#define ESP_EVENT_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+typedef const char* esp_event_base_t;
+typedef void* esp_event_handler_instance_t;
+typedef void (*esp_event_handler_t)(void* event_handler_arg,
+    esp_event_base_t event_base, int32_t event_id, void* event_data);
+
+#define ESP_EVENT_ANY_BASE NULL
+#define ESP_EVENT_ANY_ID -1
+
+/**
+ * @def ESP_EVENT_DATA_MAX
+ * @brief Largest event data copied by esp_event_post() (in bytes)
+ *
+ */
+#define ESP_EVENT_DATA_MAX 64
+
+esp_err_t esp_event_loop_create_default(void);
+esp_err_t esp_event_loop_delete_default(void);
+esp_err_t esp_event_handler_register(esp_event_base_t event_base,
+    int32_t event_id, esp_event_handler_t event_handler,
+    void* event_handler_arg);
+esp_err_t esp_event_handler_unregister(esp_event_base_t event_base,
+    int32_t event_id, esp_event_handler_t event_handler);
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base,
+    int32_t event_id, esp_event_handler_t event_handler,
+    void* event_handler_arg, esp_event_handler_instance_t* instance);
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id,
+    const void* event_data, size_t event_data_size, TickType_t ticks_to_wait);
+
+#endif
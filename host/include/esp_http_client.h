@@ -0,0 +1,122 @@
+/**
+ * @file esp_http_client.h
+ * @brief Host shim of the ESP-IDF HTTP client
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Requests are answered in process by the handler set with
+ * host_http_set_handler(), by default the Firebase stand-in. Connecting and
+ * every request take time on the virtual clock (HOST_HTTP_CONNECT_MS and
+ * HOST_HTTP_REQUEST_MS), connections stay open between requests and are
+ * dropped by the server after HOST_HTTP_IDLE_MS without a request, and all
+ * connections close when WiFi goes down. Events are sent to the event handler
+ * as by the real client.
+ *
+ */
+
+#ifndef ESP_HTTP_CLIENT_H
+#define ESP_HTTP_CLIENT_H
+
+#include "esp_err.h"
+#include "esp_event.h"
+#include "freertos/FreeRTOS.h"
+
+typedef struct esp_http_client* esp_http_client_handle_t;
+
+typedef enum {
+    HTTP_EVENT_ERROR = 0,
+    HTTP_EVENT_ON_CONNECTED,
+    HTTP_EVENT_HEADERS_SENT,
+    HTTP_EVENT_HEADER_SENT = HTTP_EVENT_HEADERS_SENT,
+    HTTP_EVENT_ON_HEADER,
+    HTTP_EVENT_ON_DATA,
+    HTTP_EVENT_ON_FINISH,
+    HTTP_EVENT_DISCONNECTED,
+    HTTP_EVENT_REDIRECT
+} esp_http_client_event_id_t;
+
+typedef struct esp_http_client_event {
+    esp_http_client_event_id_t event_id;
+    esp_http_client_handle_t client;
+    void* data;
+    int data_len;
+    void* user_data;
+    char* header_key;
+    char* header_value;
+} esp_http_client_event_t;
+
+typedef esp_err_t (*http_event_handle_cb)(esp_http_client_event_t* evt);
+
+typedef enum {
+    HTTP_METHOD_GET = 0,
+    HTTP_METHOD_POST,
+    HTTP_METHOD_PUT,
+    HTTP_METHOD_PATCH,
+    HTTP_METHOD_DELETE,
+    HTTP_METHOD_HEAD,
+    HTTP_METHOD_MAX
+} esp_http_client_method_t;
+
+typedef struct {
+    const char* url;
+    const char* host;
+    int port;
+    const char* username;
+    const char* password;
+    const char* path;
+    const char* query;
+    const char* cert_pem;
+    size_t cert_len;
+    esp_http_client_method_t method;
+    int timeout_ms;
+    bool disable_auto_redirect;
+    int max_redirection_count;
+    http_event_handle_cb event_handler;
+    void* user_data;
+    int buffer_size;
+    int buffer_size_tx;
+    bool is_async;
+    bool skip_cert_common_name_check;
+    bool keep_alive_enable;
+    int keep_alive_idle;
+    int keep_alive_interval;
+    int keep_alive_count;
+    bool save_client_session;
+} esp_http_client_config_t;
+
+esp_http_client_handle_t esp_http_client_init(
+    const esp_http_client_config_t* config);
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client);
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client,
+    const char* url);
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client,
+    const char* data, int len);
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client,
+    const char* key, const char* value);
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client,
+    const char* key);
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client,
+    esp_http_client_method_t method);
+esp_err_t esp_http_client_set_timeout_ms(esp_http_client_handle_t client,
+    int timeout_ms);
+esp_err_t esp_http_client_open(esp_http_client_handle_t client,
+    int write_len);
+int esp_http_client_write(esp_http_client_handle_t client, const char* buffer,
+    int len);
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client);
+int esp_http_client_read(esp_http_client_handle_t client, char* buffer,
+    int len);
+esp_err_t esp_http_client_flush_response(esp_http_client_handle_t client,
+    int* len);
+int esp_http_client_get_status_code(esp_http_client_handle_t client);
+int64_t esp_http_client_get_content_length(esp_http_client_handle_t client);
+esp_err_t esp_http_client_set_redirection(esp_http_client_handle_t client);
+esp_err_t esp_http_client_get_user_data(esp_http_client_handle_t client,
+    void** data);
+esp_err_t esp_http_client_set_user_data(esp_http_client_handle_t client,
+    void* data);
+esp_err_t esp_http_client_close(esp_http_client_handle_t client);
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client);
+
+#endif
@@ -0,0 +1,15 @@
+/**
+ * @file esp_mac.h
+ * @brief Host shim of the ESP-IDF MAC address header
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ */
+
+#ifndef ESP_MAC_H
+#define ESP_MAC_H
+
+#include "esp_err.h"
+
+#endif
@@ -0,0 +1,27 @@
+/**
+ * @file esp_netif.h
+ * @brief Host shim of the ESP-IDF network interface layer
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ */
+
+#ifndef ESP_NETIF_H
+#define ESP_NETIF_H
+
+#include "esp_event.h"
+
+typedef struct esp_netif_obj esp_netif_t;
+
+extern const esp_event_base_t IP_EVENT;
+
+typedef enum {
+    IP_EVENT_STA_GOT_IP,
+    IP_EVENT_STA_LOST_IP
+} ip_event_t;
+
+esp_err_t esp_netif_init(void);
+esp_netif_t* esp_netif_create_default_wifi_sta(void);
+
+#endif
@@ -0,0 +1,29 @@
+/**
+ * @file esp_sleep.h
+ * @brief Host shim of the ESP-IDF sleep modes
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Deep sleep restarts the chip, which the host build cannot do, so
+ * entering it ends the run.
+ *
+ */
+
+#ifndef ESP_SLEEP_H
+#define ESP_SLEEP_H
+
+#include "esp_err.h"
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED = 0,
+    ESP_SLEEP_WAKEUP_EXT0 = 2,
+    ESP_SLEEP_WAKEUP_EXT1 = 3,
+    ESP_SLEEP_WAKEUP_TIMER = 4
+} esp_sleep_wakeup_cause_t;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+void esp_deep_sleep_start(void) __attribute__((noreturn));
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void);
+
+#endif
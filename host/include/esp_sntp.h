@@ -0,0 +1,51 @@
+/**
+ * @file esp_sntp.h
+ * @brief Host shim of the ESP-IDF SNTP client
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Answers arrive HOST_SNTP_MS after a request while WiFi is
+ * connected and carry the reference time of host_clock_init(), so the drift
+ * of the device clock can be measured.
+ *
+ */
+
+#ifndef ESP_SNTP_H
+#define ESP_SNTP_H
+
+#include <sys/time.h>
+
+#include "esp_err.h"
+
+typedef enum {
+    ESP_SNTP_OPMODE_POLL,
+    ESP_SNTP_OPMODE_LISTENONLY
+} esp_sntp_operatingmode_t;
+
+typedef enum {
+    SNTP_SYNC_STATUS_RESET,
+    SNTP_SYNC_STATUS_COMPLETED,
+    SNTP_SYNC_STATUS_IN_PROGRESS
+} sntp_sync_status_t;
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval* tv);
+
+void esp_sntp_setoperatingmode(esp_sntp_operatingmode_t operating_mode);
+void esp_sntp_setservername(uint8_t idx, const char* server);
+void esp_sntp_init(void);
+void esp_sntp_stop(void);
+bool esp_sntp_enabled(void);
+bool sntp_restart(void);
+void sntp_set_sync_interval(uint32_t interval_ms);
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+sntp_sync_status_t sntp_get_sync_status(void);
+void sntp_set_sync_status(sntp_sync_status_t sync_status);
+
+/**
+ * @brief Apply a received time (weak, may be replaced by the application)
+ *
+ */
+void sntp_sync_time(struct timeval* tv);
+
+#endif
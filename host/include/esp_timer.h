@@ -0,0 +1,21 @@
+/**
+ * @file esp_timer.h
+ * @brief Host shim of the ESP-IDF high resolution timer
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ */
+
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Time since boot on the virtual clock (in us)
+ *
+ */
+int64_t esp_timer_get_time(void);
+
+#endif
@@ -0,0 +1,17 @@
+/**
+ * @file esp_tls.h
+ * @brief Host shim of the ESP-IDF TLS header
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Requests to the HTTP stand-in are not encrypted.
+ *
+ */
+
+#ifndef ESP_TLS_H
+#define ESP_TLS_H
+
+#include "esp_err.h"
+
+#endif
@@ -0,0 +1,29 @@
+/**
+ * @file event_groups.h
+ * @brief Host shim of the FreeRTOS event group API
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ */
+
+#ifndef EVENT_GROUPS_H
+#define EVENT_GROUPS_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_event_group* EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+
+EventGroupHandle_t xEventGroupCreate(void);
+void vEventGroupDelete(EventGroupHandle_t xEventGroup);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup,
+    const EventBits_t uxBitsToSet);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup,
+    const EventBits_t uxBitsToClear);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup,
+    const EventBits_t uxBitsToWaitFor, const BaseType_t xClearOnExit,
+    const BaseType_t xWaitForAllBits, TickType_t xTicksToWait);
+
+#endif
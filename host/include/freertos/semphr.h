@@ -0,0 +1,32 @@
+/**
+ * @file semphr.h
+ * @brief Host shim of the FreeRTOS semaphore API
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Semaphores are queues without item data, as in FreeRTOS. Mutexes
+ * do not inherit priority.
+ *
+ */
+
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount,
+    UBaseType_t uxInitialCount);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore,
+    TickType_t xBlockTime);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore,
+    BaseType_t* pxHigherPriorityTaskWoken);
+
+#define vSemaphoreDelete(xSemaphore) vQueueDelete(xSemaphore)
+
+#endif
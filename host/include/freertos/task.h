@@ -0,0 +1,89 @@
+/**
+ * @file task.h
+ * @brief Host shim of the FreeRTOS task API
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Stack depths are in bytes as on ESP-IDF. Host code needs more
+ * stack than the firmware, so every task gets at least HOST_STACK_MIN bytes
+ * and stack figures are host figures. Run time counters hold the host CPU
+ * time of each task (in us).
+ *
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+typedef enum {
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid
+} eTaskState;
+
+typedef enum {
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite
+} eNotifyAction;
+
+typedef struct {
+    TaskHandle_t xHandle;
+    const char* pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    configRUN_TIME_COUNTER_TYPE ulRunTimeCounter;
+    StackType_t* pxStackBase;
+    configSTACK_DEPTH_TYPE usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char* pcName,
+    configSTACK_DEPTH_TYPE usStackDepth, void* pvParameters,
+    UBaseType_t uxPriority, TaskHandle_t* pxCreatedTask);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode,
+    const char* pcName, configSTACK_DEPTH_TYPE usStackDepth,
+    void* pvParameters, UBaseType_t uxPriority, TaskHandle_t* pxCreatedTask,
+    BaseType_t xCoreID);
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+void vTaskDelay(TickType_t xTicksToDelay);
+BaseType_t xTaskDelayUntil(TickType_t* pxPreviousWakeTime,
+    TickType_t xTimeIncrement);
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+const char* pcTaskGetName(TaskHandle_t xTaskToQuery);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* pxTaskStatusArray,
+    UBaseType_t uxArraySize, configRUN_TIME_COUNTER_TYPE* pulTotalRunTime);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify,
+    BaseType_t* pxHigherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit,
+    TickType_t xTicksToWait);
+BaseType_t xTaskNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue,
+    eNotifyAction eAction);
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry,
+    uint32_t ulBitsToClearOnExit, uint32_t* pulNotificationValue,
+    TickType_t xTicksToWait);
+
+#define taskYIELD() vTaskDelay(0)
+
+#endif
@@ -0,0 +1,425 @@
+/**
+ * @file host.h
+ * @brief Virtual clock and hardware shims of the host build
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details The host build runs the firmware sources on Linux against shims
+ * of the ESP-IDF APIs they use. Tasks are switched on a single thread and
+ * time only passes on a virtual clock, which jumps to the next deadline as
+ * soon as every task is blocked. A run is deterministic and an hour of device
+ * time takes milliseconds of host time when the firmware is idle.
+ *
+ * Each shim has a hook to swap out the simulated hardware:
+ * - ADC conversions come from host_adc_set_source()
+ * - GPIO output changes go to host_gpio_set_observer()
+ * - HTTP requests go to host_http_set_handler(), by default a Firebase
+ *   stand-in that serves the parameters document
+ * - The wall clock, SNTP and WiFi follow host_clock_init() and
+ *   host_wifi_set_available()
+ * - The offline partition is kept in a file by host_partition_set_file()
+ *
+ * @note Hooks must not block, they run on the virtual clock without a task.
+ *
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "driver/gpio.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_http_client.h"
+
+/**
+ * @def HOST_STACK_MIN
+ * @brief Smallest task stack on the host (in bytes)
+ *
+ */
+#define HOST_STACK_MIN 65536
+
+/**
+ * @def HOST_STACK_SCALE
+ * @brief Host stack size per byte of firmware stack
+ *
+ */
+#define HOST_STACK_SCALE 4
+
+/**
+ * @def HOST_HEAP_SIZE
+ * @brief Heap reported by the heap statistics (in bytes)
+ *
+ */
+#define HOST_HEAP_SIZE 327680
+
+/**
+ * @def HOST_WIFI_SCAN_MS
+ * @brief Time to connect after a scan of every channel (in ms)
+ *
+ */
+#define HOST_WIFI_SCAN_MS 2500
+
+/**
+ * @def HOST_WIFI_FAST_MS
+ * @brief Time to connect to a known access point and channel (in ms)
+ *
+ */
+#define HOST_WIFI_FAST_MS 400
+
+/**
+ * @def HOST_WIFI_DHCP_MS
+ * @brief Time from connecting to receiving an address (in ms)
+ *
+ */
+#define HOST_WIFI_DHCP_MS 300
+
+/**
+ * @def HOST_SNTP_MS
+ * @brief Round trip of an SNTP request (in ms)
+ *
+ */
+#define HOST_SNTP_MS 80
+
+/**
+ * @def HOST_HTTP_CONNECT_MS
+ * @brief TCP connect and TLS handshake (in ms)
+ *
+ */
+#define HOST_HTTP_CONNECT_MS 450
+
+/**
+ * @def HOST_HTTP_REQUEST_MS
+ * @brief Round trip of a request on an open connection (in ms)
+ *
+ */
+#define HOST_HTTP_REQUEST_MS 120
+
+/**
+ * @def HOST_HTTP_IDLE_MS
+ * @brief Idle time after which the server drops a connection (in ms)
+ *
+ */
+#define HOST_HTTP_IDLE_MS 60000
+
+/**
+ * @def HOST_HTTP_KEEP_ALIVE_MS
+ * @brief Time between keep-alive events on an event stream (in ms)
+ *
+ */
+#define HOST_HTTP_KEEP_ALIVE_MS 30000
+
+/**
+ * @brief Callback of a virtual timer
+ *
+ * @param[in] ctx User context
+ *
+ */
+typedef void (*host_timer_cb)(void* ctx);
+
+/**
+ * @brief Virtual timer returned by host_timer_start()
+ *
+ */
+typedef struct host_timer host_timer;
+
+/**
+ * @brief Run the firmware on the virtual clock
+ *
+ * Starts entry in a "main" task of priority 1, like app_main(), and switches
+ * tasks until duration has passed on the virtual clock, every task is blocked
+ * forever or host_stop() is called. Tasks are left where they stopped.
+ *
+ * @param[in] entry Firmware entry point
+ * @param[in] duration Time to run (in us)
+ *
+ * @return int64_t: Time on the virtual clock at the end (in us)
+ *
+ */
+int64_t host_run(void (*entry)(void), int64_t duration);
+
+/**
+ * @brief End host_run() once the running task blocks
+ *
+ * @param[in] reason Message printed at the end
+ *
+ */
+void host_stop(const char* reason);
+
+/**
+ * @brief Time since boot on the virtual clock
+ *
+ * @return int64_t: Time (in us)
+ *
+ */
+int64_t host_time_us(void);
+
+/**
+ * @brief Block the running task on the virtual clock
+ *
+ * Used by the shims for hardware and network delays.
+ *
+ * @param[in] us Time to block (in us)
+ *
+ */
+void host_sleep_us(int64_t us);
+
+/**
+ * @brief Host CPU time spent in the firmware
+ *
+ * Covers every task and the shim hooks run between tasks.
+ *
+ * @return uint64_t: CPU time (in us)
+ *
+ */
+uint64_t host_cpu_us(void);
+
+/**
+ * @brief Start a virtual timer
+ *
+ * @param[in] delay Time to the first call (in us)
+ * @param[in] period Time between later calls, 0 for a single call (in us)
+ * @param[in] callback Function called on the virtual clock
+ * @param[in] ctx User context for callback
+ *
+ * @return host_timer*: Timer, or NULL on failure
+ *
+ */
+host_timer* host_timer_start(int64_t delay, int64_t period,
+    host_timer_cb callback, void* ctx);
+
+/**
+ * @brief Stop and free a virtual timer
+ *
+ * @param[in] timer Timer, ignored if NULL
+ *
+ */
+void host_timer_stop(host_timer* timer);
+
+/**
+ * @brief Set the reference time and the error of the device clock
+ *
+ * The device clock reads 0 (1970) at boot, as after a power loss, until
+ * SNTP or the firmware sets it. It then gains drift_ppm against the
+ * reference time that SNTP answers with.
+ *
+ * @param[in] epoch Reference time at boot (in s since 1970)
+ * @param[in] drift_ppm Device clock error (in parts per million)
+ *
+ */
+void host_clock_init(time_t epoch, int32_t drift_ppm);
+
+/**
+ * @brief Reference time on the virtual clock
+ *
+ * @return time_t: Time (in s since 1970)
+ *
+ */
+time_t host_clock_reference(void);
+
+/**
+ * @brief Source of ADC conversions
+ *
+ * @param[in] unit ADC unit
+ * @param[in] channel ADC channel
+ * @param[in] ctx User context
+ *
+ * @return int: Raw conversion (0 to 4095)
+ *
+ */
+typedef int (*host_adc_source)(adc_unit_t unit, adc_channel_t channel,
+    void* ctx);
+
+/**
+ * @brief Set the source of ADC conversions
+ *
+ * @param[in] source Conversion source, NULL for the fixed levels of
+ * host_adc_set_level()
+ * @param[in] ctx User context for source
+ *
+ */
+void host_adc_set_source(host_adc_source source, void* ctx);
+
+/**
+ * @brief Set the fixed level of a channel (2048 by default)
+ *
+ * @param[in] unit ADC unit
+ * @param[in] channel ADC channel
+ * @param[in] raw Raw conversion (0 to 4095)
+ *
+ */
+void host_adc_set_level(adc_unit_t unit, adc_channel_t channel, int raw);
+
+/**
+ * @brief Observer of GPIO output changes
+ *
+ * @param[in] pin GPIO pin
+ * @param[in] level New level
+ * @param[in] ctx User context
+ *
+ */
+typedef void (*host_gpio_observer)(gpio_num_t pin, uint32_t level, void* ctx);
+
+/**
+ * @brief Set the observer of GPIO output changes
+ *
+ * @param[in] observer Observer, NULL for none
+ * @param[in] ctx User context for observer
+ *
+ */
+void host_gpio_set_observer(host_gpio_observer observer, void* ctx);
+
+/**
+ * @brief Drive the level seen by gpio_get_level()
+ *
+ * @param[in] pin GPIO pin
+ * @param[in] level Input level
+ *
+ */
+void host_gpio_set_input(gpio_num_t pin, int level);
+
+/**
+ * @brief Set the chip temperature
+ *
+ * @param[in] celsius Temperature (in degrees C)
+ *
+ */
+void host_set_chip_temperature(float celsius);
+
+/**
+ * @brief Make the access point reachable or not
+ *
+ * A connected station is disconnected when it goes away. It is reachable
+ * at the start of a run.
+ *
+ * @param[in] available Access point reachable
+ *
+ */
+void host_wifi_set_available(bool available);
+
+/**
+ * @brief Keep the offline partition in a file
+ *
+ * The partition is read from path, created erased if missing, and writes go
+ * straight to the file. Calling it again drops the partition in memory and
+ * reads the file back, as flash is found after a power cycle. Without a file
+ * the partition starts erased and is lost at exit.
+ *
+ * @param[in] path Partition file
+ *
+ * @retval 0 Success
+ * @retval -1 File could not be opened or mapped
+ *
+ */
+int host_partition_set_file(const char* path);
+
+/**
+ * @brief HTTP request received by the stand-in
+ *
+ */
+typedef struct {
+    esp_http_client_method_t method;    /**< Request method */
+    const char* path;                   /**< Path, e.g. "/parameters.json" */
+    const char* query;                  /**< Query after '?', "" if none */
+    const char* content_type;           /**< Content-Type, "" if none */
+    const char* content_encoding;       /**< Content-Encoding, "" if none */
+    bool event_stream;                  /**< Accept: text/event-stream */
+    const char* body;                   /**< Body with chunk framing removed */
+    int body_len;                       /**< Length of body */
+} host_http_request;
+
+/**
+ * @brief HTTP response of the stand-in
+ *
+ * Set to status 200 with an empty body before the handler runs.
+ *
+ */
+typedef struct {
+    int status;                         /**< Status code */
+    char* body;                         /**< Body, allocated with malloc */
+    int body_len;                       /**< Length of body */
+    bool stream;                        /**< Left open for host_http_stream_send() */
+} host_http_response;
+
+/**
+ * @brief Request handler of the stand-in
+ *
+ * @param[in] request Request
+ * @param[out] response Response
+ * @param[in] ctx User context
+ *
+ */
+typedef void (*host_http_handler)(const host_http_request* request,
+    host_http_response* response, void* ctx);
+
+/**
+ * @brief Traffic between the firmware and the stand-in
+ *
+ */
+typedef struct {
+    uint32_t requests;          /**< Requests answered */
+    uint32_t failures;          /**< Requests without a response */
+    uint32_t connects;          /**< Connections opened */
+    uint32_t drops;             /**< Connections dropped by the server */
+    uint64_t bytes_sent;        /**< Request bytes with headers */
+    uint64_t bytes_received;    /**< Response bytes with headers */
+} host_http_stats;
+
+/**
+ * @brief Set the request handler
+ *
+ * @param[in] handler Handler, NULL for the Firebase stand-in
+ * @param[in] ctx User context for handler
+ *
+ */
+void host_http_set_handler(host_http_handler handler, void* ctx);
+
+/**
+ * @brief Send data on every open event stream
+ *
+ * @param[in] data Data
+ * @param[in] len Length of data
+ *
+ */
+void host_http_stream_send(const char* data, int len);
+
+/**
+ * @brief Traffic since the start of the run
+ *
+ * @return host_http_stats: Traffic counters
+ *
+ */
+host_http_stats host_http_get_stats(void);
+
+/**
+ * @brief Firebase Realtime Database stand-in
+ *
+ * Serves the parameters document for GET requests and as an event stream,
+ * accepts every POST and echoes PATCHes of the parameters to open streams.
+ * Members set to null are deleted from the document, as Firebase does.
+ * PATCH bodies are decompressed if sent with gzip Content-Encoding and
+ * rejected with 400 unless they are valid JSON; the response echoes the
+ * decompressed body. Can be called by other handlers to keep this behaviour.
+ *
+ * @param[in] request Request
+ * @param[out] response Response
+ * @param[in] ctx unused
+ *
+ */
+void host_firebase_handler(const host_http_request* request,
+    host_http_response* response, void* ctx);
+
+/**
+ * @brief Replace the parameters document
+ *
+ * Open event streams receive the new document.
+ *
+ * @param[in] json Document
+ *
+ */
+void host_firebase_set_params(const char* json);
+
+#endif
@@ -0,0 +1,31 @@
+/**
+ * @file nvs.h
+ * @brief Host shim of the ESP-IDF non-volatile storage API
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Integer entries only, kept in memory for the whole run.
+ *
+ */
+
+#ifndef NVS_H
+#define NVS_H
+
+#include "esp_err.h"
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum {
+    NVS_READONLY,
+    NVS_READWRITE
+} nvs_open_mode_t;
+
+esp_err_t nvs_open(const char* namespace_name, nvs_open_mode_t open_mode,
+    nvs_handle_t* out_handle);
+esp_err_t nvs_get_i64(nvs_handle_t handle, const char* key, int64_t* out_value);
+esp_err_t nvs_set_i64(nvs_handle_t handle, const char* key, int64_t value);
+esp_err_t nvs_commit(nvs_handle_t handle);
+void nvs_close(nvs_handle_t handle);
+
+#endif
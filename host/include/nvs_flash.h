@@ -0,0 +1,18 @@
+/**
+ * @file nvs_flash.h
+ * @brief Host shim of the ESP-IDF NVS partition setup
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ */
+
+#ifndef NVS_FLASH_H
+#define NVS_FLASH_H
+
+#include "nvs.h"
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+
+#endif
@@ -0,0 +1,22 @@
+/**
+ * @file sdkconfig.h
+ * @brief Project configuration of the host build
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Options from sdkconfig.defaults that the firmware checks at
+ * compile time.
+ *
+ */
+
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+#define CONFIG_IDF_TARGET_LINUX 1
+#define CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS 1
+#define CONFIG_FREERTOS_USE_TRACE_FACILITY 1
+#define CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS 1
+#define CONFIG_FREERTOS_HZ 100
+
+#endif
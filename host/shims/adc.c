@@ -0,0 +1,271 @@
+#include "esp_adc/adc_continuous.h"
+
+#include "host.h"
+#include "kernel.h"
+
+#define NUM_UNITS 2
+#define NUM_CHANNELS 10
+#define DEFAULT_LEVEL 2048
+
+struct adc_oneshot_unit_ctx_t {
+    adc_unit_t unit;
+};
+
+struct adc_continuous_ctx_t {
+    uint32_t frame_size;
+    uint32_t pool_frames;
+    uint8_t* pool;              // Ring of finished frames
+    uint32_t head;
+    uint32_t count;
+    adc_digi_pattern_config_t pattern[SOC_ADC_PATT_LEN_MAX];
+    uint32_t pattern_num;
+    uint32_t cursor;            // Next pattern entry to convert
+    uint32_t sample_freq;
+    adc_continuous_evt_cbs_t callbacks;
+    void* user_data;
+    host_timer* timer;
+};
+
+static host_adc_source source = NULL;
+static void* source_ctx = NULL;
+static int levels[NUM_UNITS][NUM_CHANNELS];
+static bool levels_set = false;
+static bool unit_claimed[NUM_UNITS];
+
+static int convert(adc_unit_t unit, adc_channel_t channel) {
+    if (source != NULL) {
+        return source(unit, channel, source_ctx);
+    }
+    if (!levels_set || unit >= NUM_UNITS || channel >= NUM_CHANNELS) {
+        return DEFAULT_LEVEL;
+    }
+
+    return levels[unit][channel];
+}
+
+void host_adc_set_source(host_adc_source new_source, void* ctx) {
+    source = new_source;
+    source_ctx = ctx;
+}
+
+void host_adc_set_level(adc_unit_t unit, adc_channel_t channel, int raw) {
+    if (!levels_set) {
+        for (int i = 0; i < NUM_UNITS; i++) {
+            for (int j = 0; j < NUM_CHANNELS; j++) {
+                levels[i][j] = DEFAULT_LEVEL;
+            }
+        }
+        levels_set = true;
+    }
+    if (unit < NUM_UNITS && channel < NUM_CHANNELS) {
+        levels[unit][channel] = raw;
+    }
+}
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t* init_config,
+    adc_oneshot_unit_handle_t* ret_unit) {
+        if (init_config->unit_id >= NUM_UNITS) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        // A unit has a single oneshot handle at a time
+        if (unit_claimed[init_config->unit_id]) {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        *ret_unit = calloc(1, sizeof(struct adc_oneshot_unit_ctx_t));
+        if (*ret_unit == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        (*ret_unit)->unit = init_config->unit_id;
+        unit_claimed[init_config->unit_id] = true;
+
+        return ESP_OK;
+}
+
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle,
+    adc_channel_t channel, const adc_oneshot_chan_cfg_t* config) {
+        return channel < NUM_CHANNELS ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle,
+    adc_channel_t chan, int* out_raw) {
+        if (handle == NULL || chan >= NUM_CHANNELS) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (handle->unit == ADC_UNIT_2 && wifi_adc2_busy()) {
+            return ESP_ERR_TIMEOUT;
+        }
+        *out_raw = convert(handle->unit, chan);
+
+        return ESP_OK;
+}
+
+esp_err_t adc_oneshot_del_unit(adc_oneshot_unit_handle_t handle) {
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    unit_claimed[handle->unit] = false;
+    free(handle);
+
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_new_handle(
+    const adc_continuous_handle_cfg_t* hdl_config,
+    adc_continuous_handle_t* ret_handle) {
+        if (hdl_config->conv_frame_size == 0 ||
+            hdl_config->conv_frame_size % SOC_ADC_DIGI_RESULT_BYTES != 0) {
+                return ESP_ERR_INVALID_ARG;
+        }
+
+        struct adc_continuous_ctx_t* handle = calloc(1,
+            sizeof(struct adc_continuous_ctx_t));
+        if (handle == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        handle->frame_size = hdl_config->conv_frame_size;
+        handle->pool_frames = hdl_config->max_store_buf_size /
+            hdl_config->conv_frame_size;
+        if (handle->pool_frames == 0) {
+            handle->pool_frames = 1;
+        }
+        handle->pool = malloc(handle->pool_frames * handle->frame_size);
+        if (handle->pool == NULL) {
+            free(handle);
+            return ESP_ERR_NO_MEM;
+        }
+
+        *ret_handle = handle;
+
+        return ESP_OK;
+}
+
+esp_err_t adc_continuous_config(adc_continuous_handle_t handle,
+    const adc_continuous_config_t* config) {
+        if (config->pattern_num == 0 ||
+            config->pattern_num > SOC_ADC_PATT_LEN_MAX ||
+            config->sample_freq_hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW ||
+            config->sample_freq_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) {
+                return ESP_ERR_INVALID_ARG;
+        }
+
+        // Units of the pattern must be converted in the chosen mode
+        for (uint32_t i = 0; i < config->pattern_num; i++) {
+            adc_unit_t unit = config->adc_pattern[i].unit;
+            if (unit >= NUM_UNITS ||
+                (config->conv_mode == ADC_CONV_SINGLE_UNIT_1 &&
+                unit != ADC_UNIT_1) ||
+                (config->conv_mode == ADC_CONV_SINGLE_UNIT_2 &&
+                unit != ADC_UNIT_2)) {
+                    return ESP_ERR_INVALID_ARG;
+            }
+        }
+
+        memcpy(handle->pattern, config->adc_pattern,
+            config->pattern_num * sizeof(adc_digi_pattern_config_t));
+        handle->pattern_num = config->pattern_num;
+        handle->sample_freq = config->sample_freq_hz;
+
+        return ESP_OK;
+}
+
+esp_err_t adc_continuous_register_event_callbacks(
+    adc_continuous_handle_t handle, const adc_continuous_evt_cbs_t* cbs,
+    void* user_data) {
+        handle->callbacks = *cbs;
+        handle->user_data = user_data;
+
+        return ESP_OK;
+}
+
+static void frame_done(void* ctx) {
+    struct adc_continuous_ctx_t* handle = ctx;
+
+    // Oldest frame is overwritten when the pool is full
+    if (handle->count == handle->pool_frames) {
+        handle->head = (handle->head + 1) % handle->pool_frames;
+        handle->count--;
+        if (handle->callbacks.on_pool_ovf != NULL) {
+            handle->callbacks.on_pool_ovf(handle, NULL, handle->user_data);
+        }
+    }
+
+    uint32_t slot = (handle->head + handle->count) % handle->pool_frames;
+    uint8_t* frame = handle->pool + slot * handle->frame_size;
+    for (uint32_t i = 0; i < handle->frame_size;
+        i += SOC_ADC_DIGI_RESULT_BYTES) {
+            const adc_digi_pattern_config_t* entry =
+                &handle->pattern[handle->cursor];
+            handle->cursor = (handle->cursor + 1) % handle->pattern_num;
+
+            adc_digi_output_data_t result = { .val = 0 };
+            result.type2.data = convert(entry->unit, entry->channel);
+            result.type2.channel = entry->channel;
+            result.type2.unit = entry->unit;
+            memcpy(frame + i, &result, sizeof(result));
+    }
+    handle->count++;
+    kernel_wake(handle);
+
+    if (handle->callbacks.on_conv_done != NULL) {
+        adc_continuous_evt_data_t edata = {
+            .conv_frame_buffer = frame,
+            .size = handle->frame_size
+        };
+        handle->callbacks.on_conv_done(handle, &edata, handle->user_data);
+    }
+}
+
+esp_err_t adc_continuous_start(adc_continuous_handle_t handle) {
+    if (handle->timer != NULL || handle->pattern_num == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t results = handle->frame_size / SOC_ADC_DIGI_RESULT_BYTES;
+    int64_t period = results * 1000000 / handle->sample_freq;
+    handle->timer = host_timer_start(period, period, frame_done, handle);
+
+    return handle->timer != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t adc_continuous_stop(adc_continuous_handle_t handle) {
+    if (handle->timer == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    host_timer_stop(handle->timer);
+    handle->timer = NULL;
+
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_read(adc_continuous_handle_t handle, uint8_t* buf,
+    uint32_t length_max, uint32_t* out_length, uint32_t timeout_ms) {
+        int64_t deadline = timeout_ms == ADC_MAX_DELAY ? KERNEL_FOREVER :
+            host_time_us() + (int64_t)timeout_ms * 1000;
+        while (handle->count == 0) {
+            if (kernel_wait(handle, deadline) == -1) {
+                *out_length = 0;
+                return ESP_ERR_TIMEOUT;
+            }
+        }
+
+        uint32_t len = handle->frame_size < length_max ? handle->frame_size :
+            length_max;
+        memcpy(buf, handle->pool + handle->head * handle->frame_size, len);
+        handle->head = (handle->head + 1) % handle->pool_frames;
+        handle->count--;
+        *out_length = len;
+
+        return ESP_OK;
+}
+
+esp_err_t adc_continuous_deinit(adc_continuous_handle_t handle) {
+    if (handle->timer != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    free(handle->pool);
+    free(handle);
+
+    return ESP_OK;
+}
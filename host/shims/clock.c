@@ -0,0 +1,142 @@
+#include "host.h"
+
+#include <sys/time.h>
+
+#include "esp_sntp.h"
+#include "esp_timer.h"
+#include "kernel.h"
+
+#define DEFAULT_SYNC_INTERVAL 3600000
+
+static time_t reference_epoch = 0;
+static int32_t drift = 0;
+
+// Device clock read base_wall at base_us and runs at (1 + drift) since
+static int64_t base_wall = 0;
+static int64_t base_us = 0;
+
+static bool sntp_enabled = false;
+static uint32_t sync_interval = DEFAULT_SYNC_INTERVAL;
+static sntp_sync_status_t sync_status = SNTP_SYNC_STATUS_RESET;
+static sntp_sync_time_cb_t sync_callback = NULL;
+static host_timer* sntp_timer = NULL;
+
+static int64_t wall_us(void) {
+    int64_t elapsed = host_time_us() - base_us;
+
+    return base_wall + elapsed + elapsed * drift / 1000000;
+}
+
+void host_clock_init(time_t epoch, int32_t drift_ppm) {
+    reference_epoch = epoch;
+    drift = drift_ppm;
+}
+
+time_t host_clock_reference(void) {
+    return reference_epoch + host_time_us() / 1000000;
+}
+
+int64_t esp_timer_get_time(void) {
+    return host_time_us();
+}
+
+time_t time(time_t* tloc) {
+    time_t now = wall_us() / 1000000;
+    if (tloc != NULL) {
+        *tloc = now;
+    }
+
+    return now;
+}
+
+int gettimeofday(struct timeval* restrict tv, void* restrict tz) {
+    int64_t now = wall_us();
+    tv->tv_sec = now / 1000000;
+    tv->tv_usec = now % 1000000;
+
+    return 0;
+}
+
+int settimeofday(const struct timeval* tv, const struct timezone* tz) {
+    if (tv != NULL) {
+        base_wall = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+        base_us = host_time_us();
+    }
+
+    return 0;
+}
+
+__attribute__((weak)) void sntp_sync_time(struct timeval* tv) {
+    settimeofday(tv, NULL);
+    sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+}
+
+static void sntp_response(void* ctx) {
+    // Requests go unanswered while the station is down
+    if (!sntp_enabled || !wifi_link_up()) {
+        return;
+    }
+
+    int64_t now = (int64_t)reference_epoch * 1000000 + host_time_us();
+    struct timeval tv = {
+        .tv_sec = now / 1000000,
+        .tv_usec = now % 1000000
+    };
+    sntp_sync_time(&tv);
+    if (sync_callback != NULL) {
+        sync_callback(&tv);
+    }
+}
+
+static void start_requests(void) {
+    host_timer_stop(sntp_timer);
+    sntp_timer = host_timer_start((int64_t)HOST_SNTP_MS * 1000,
+        (int64_t)sync_interval * 1000, sntp_response, NULL);
+}
+
+void esp_sntp_setoperatingmode(esp_sntp_operatingmode_t operating_mode) {
+}
+
+void esp_sntp_setservername(uint8_t idx, const char* server) {
+}
+
+void esp_sntp_init(void) {
+    sntp_enabled = true;
+    sync_status = SNTP_SYNC_STATUS_RESET;
+    start_requests();
+}
+
+void esp_sntp_stop(void) {
+    sntp_enabled = false;
+    host_timer_stop(sntp_timer);
+    sntp_timer = NULL;
+}
+
+bool esp_sntp_enabled(void) {
+    return sntp_enabled;
+}
+
+bool sntp_restart(void) {
+    if (!sntp_enabled) {
+        return false;
+    }
+    start_requests();
+
+    return true;
+}
+
+void sntp_set_sync_interval(uint32_t interval_ms) {
+    sync_interval = interval_ms;
+}
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback) {
+    sync_callback = callback;
+}
+
+sntp_sync_status_t sntp_get_sync_status(void) {
+    return sync_status;
+}
+
+void sntp_set_sync_status(sntp_sync_status_t status) {
+    sync_status = status;
+}
@@ -0,0 +1,367 @@
+#include "host.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "json_stream.h"
+
+#define MAX_FIELDS 16
+
+#define DEFAULT_PARAMS \
+    "{\"Water_Duration_Set\": 60, \"Water_Times_Set\": [6, 18]}"
+
+/**
+ * @brief Top-level member of the parameters document
+ *
+ */
+typedef struct {
+    char* key;
+    char* value;                // Raw JSON of the value
+} field;
+
+static field fields[MAX_FIELDS];
+static int num_fields = 0;
+static bool loaded = false;
+static host_timer* keep_alive = NULL;
+static unsigned post_count = 0;
+
+static const char* skip_space(const char* p, const char* end) {
+    while (p < end && isspace((unsigned char)*p)) {
+        p++;
+    }
+
+    return p;
+}
+
+static const char* skip_string(const char* p, const char* end) {
+    // p is on the opening quote
+    for (p++; p < end; p++) {
+        if (*p == '\\') {
+            p++;
+        }
+        else if (*p == '"') {
+            return p + 1;
+        }
+    }
+
+    return NULL;
+}
+
+static const char* skip_value(const char* p, const char* end) {
+    int depth = 0;
+    while (p < end) {
+        if (*p == '"') {
+            p = skip_string(p, end);
+            if (p == NULL) {
+                return NULL;
+            }
+            continue;
+        }
+        if (*p == '{' || *p == '[') {
+            depth++;
+        }
+        else if (*p == '}' || *p == ']') {
+            if (depth == 0) {
+                return p;
+            }
+            depth--;
+        }
+        else if (*p == ',' && depth == 0) {
+            return p;
+        }
+        p++;
+    }
+
+    return depth == 0 ? p : NULL;
+}
+
+static void set_field(const char* key, int key_len, const char* value,
+    int value_len) {
+        field* slot = NULL;
+        for (int i = 0; i < num_fields; i++) {
+            if ((int)strlen(fields[i].key) == key_len &&
+                strncmp(fields[i].key, key, key_len) == 0) {
+                    slot = &fields[i];
+                    break;
+            }
+        }
+
+        // Trailing space is not part of the value
+        while (value_len > 0 && isspace((unsigned char)value[value_len - 1])) {
+            value_len--;
+        }
+
+        // Firebase deletes members set to null
+        if (value_len == 4 && strncmp(value, "null", 4) == 0) {
+            if (slot != NULL) {
+                free(slot->key);
+                free(slot->value);
+                *slot = fields[--num_fields];
+            }
+            return;
+        }
+        if (slot == NULL) {
+            if (num_fields == MAX_FIELDS) {
+                printf("ERROR host parameters document full.\n");
+                return;
+            }
+            slot = &fields[num_fields++];
+            slot->key = strndup(key, key_len);
+            slot->value = NULL;
+        }
+        free(slot->value);
+        slot->value = strndup(value, value_len);
+}
+
+static int merge(const char* json, int len) {
+    // Members of the top-level object replace those of the document
+    const char* end = json + len;
+    const char* p = skip_space(json, end);
+    if (p == end || *p != '{') {
+        return -1;
+    }
+    p = skip_space(p + 1, end);
+
+    while (p < end && *p != '}') {
+        if (*p != '"') {
+            return -1;
+        }
+        const char* key = p + 1;
+        p = skip_string(p, end);
+        if (p == NULL) {
+            return -1;
+        }
+        int key_len = p - 1 - key;
+
+        p = skip_space(p, end);
+        if (p == end || *p != ':') {
+            return -1;
+        }
+        const char* value = skip_space(p + 1, end);
+        p = skip_value(value, end);
+        if (p == NULL || p == end) {
+            return -1;
+        }
+        set_field(key, key_len, value, p - value);
+
+        if (*p == ',') {
+            p = skip_space(p + 1, end);
+        }
+    }
+
+    return 0;
+}
+
+static void load_defaults(void) {
+    if (!loaded) {
+        loaded = true;
+        merge(DEFAULT_PARAMS, strlen(DEFAULT_PARAMS));
+    }
+}
+
+static char* document(int* len) {
+    int cap = 3;
+    for (int i = 0; i < num_fields; i++) {
+        cap += strlen(fields[i].key) + strlen(fields[i].value) + 6;
+    }
+
+    char* doc = malloc(cap);
+    if (doc == NULL) {
+        *len = 0;
+        return NULL;
+    }
+    int pos = snprintf(doc, cap, "{");
+    for (int i = 0; i < num_fields; i++) {
+        pos += snprintf(doc + pos, cap - pos, "%s\"%s\": %s",
+            i == 0 ? "" : ", ", fields[i].key, fields[i].value);
+    }
+    pos += snprintf(doc + pos, cap - pos, "}");
+    *len = pos;
+
+    return doc;
+}
+
+static char* event(const char* name, const char* data, int data_len,
+    int* len) {
+        const char* format =
+            "event: %s\ndata: {\"path\": \"/\", \"data\": %.*s}\n\n";
+        *len = snprintf(NULL, 0, format, name, data_len, data);
+        char* message = malloc(*len + 1);
+        if (message != NULL) {
+            snprintf(message, *len + 1, format, name, data_len, data);
+        }
+
+        return message;
+}
+
+static void send_keep_alive(void* ctx) {
+    const char* message = "event: keep-alive\ndata: null\n\n";
+    host_http_stream_send(message, strlen(message));
+}
+
+static void send_event(const char* name, const char* data, int data_len) {
+    int len;
+    char* message = event(name, data, data_len, &len);
+    if (message != NULL) {
+        host_http_stream_send(message, len);
+        free(message);
+    }
+}
+
+static char* copy_body(const char* body, int len) {
+    char* copy = malloc(len + 1);
+    if (copy != NULL) {
+        memcpy(copy, body, len);
+        copy[len] = '\0';
+    }
+
+    return copy;
+}
+
+static char* inflate_body(const char* body, int len, int* out_len) {
+    // Gzip wrapper only, its CRC and length are checked by zlib
+    z_stream stream = {0};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+        return NULL;
+    }
+
+    int cap = 4 * len + 64;
+    char* out = malloc(cap + 1);
+    stream.next_in = (Bytef*)body;
+    stream.avail_in = len;
+    int status = Z_OK;
+    while (out != NULL && status == Z_OK) {
+        if (stream.total_out == (uLong)cap) {
+            cap *= 2;
+            char* grown = realloc(out, cap + 1);
+            if (grown == NULL) {
+                free(out);
+                out = NULL;
+                break;
+            }
+            out = grown;
+        }
+        stream.next_out = (Bytef*)out + stream.total_out;
+        stream.avail_out = cap - stream.total_out;
+        status = inflate(&stream, Z_NO_FLUSH);
+    }
+
+    // Data after the end of the gzip member is an error too
+    if (out != NULL && (status != Z_STREAM_END || stream.avail_in != 0)) {
+        free(out);
+        out = NULL;
+    }
+    if (out != NULL) {
+        *out_len = stream.total_out;
+        out[*out_len] = '\0';
+    }
+    inflateEnd(&stream);
+
+    return out;
+}
+
+static bool valid_json(const char* body, int len) {
+    json_parser parser;
+    json_init(&parser, NULL, NULL);
+
+    return json_feed(&parser, body, len) == 0 && json_finish(&parser) == 0;
+}
+
+void host_firebase_handler(const host_http_request* request,
+    host_http_response* response, void* ctx) {
+        load_defaults();
+        bool params = strcmp(request->path, "/parameters.json") == 0;
+        char* doc;
+        int doc_len;
+        const char* body = request->body;
+        int body_len = request->body_len;
+        char* inflated = NULL;
+
+        switch (request->method) {
+            case HTTP_METHOD_GET:
+                if (!params) {
+                    response->body = copy_body("null", 4);
+                    response->body_len = 4;
+                    break;
+                }
+
+                doc = document(&doc_len);
+                if (doc == NULL) {
+                    response->status = 500;
+                    break;
+                }
+                if (request->event_stream) {
+                    // Current document, then changes as they are written
+                    response->body = event("put", doc, doc_len,
+                        &response->body_len);
+                    response->stream = true;
+                    free(doc);
+                    if (keep_alive == NULL) {
+                        keep_alive = host_timer_start(
+                            (int64_t)HOST_HTTP_KEEP_ALIVE_MS * 1000,
+                            (int64_t)HOST_HTTP_KEEP_ALIVE_MS * 1000,
+                            send_keep_alive, NULL);
+                    }
+                }
+                else {
+                    response->body = doc;
+                    response->body_len = doc_len;
+                }
+                break;
+            case HTTP_METHOD_PATCH:
+                // Gzip bodies are decompressed, then checked like any other
+                if (strcmp(request->content_encoding, "gzip") == 0) {
+                    inflated = inflate_body(request->body, request->body_len,
+                        &body_len);
+                    body = inflated;
+                }
+                if (body == NULL || !valid_json(body, body_len)) {
+                    response->status = 400;
+                    break;
+                }
+                if (params) {
+                    if (merge(body, body_len) != 0) {
+                        response->status = 400;
+                        break;
+                    }
+                    send_event("patch", body, body_len);
+                }
+                response->body = copy_body(body, body_len);
+                response->body_len = body_len;
+                break;
+            case HTTP_METHOD_POST:
+                response->body = malloc(32);
+                if (response->body != NULL) {
+                    response->body_len = snprintf(response->body, 32,
+                        "{\"name\": \"-host%u\"}", post_count++);
+                }
+                break;
+            default:
+                break;
+        }
+        free(inflated);
+}
+
+void host_firebase_set_params(const char* json) {
+    for (int i = 0; i < num_fields; i++) {
+        free(fields[i].key);
+        free(fields[i].value);
+    }
+    num_fields = 0;
+    loaded = true;
+
+    if (merge(json, strlen(json)) != 0) {
+        printf("ERROR host parameters document malformed.\n");
+        return;
+    }
+
+    int doc_len;
+    char* doc = document(&doc_len);
+    if (doc != NULL) {
+        send_event("put", doc, doc_len);
+        free(doc);
+    }
+}
@@ -0,0 +1,884 @@
+#include "kernel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "host.h"
+
+#define STACK_FILL 0xA5
+#define MAIN_TASK_STACK 3584
+
+typedef enum {
+    TASK_READY,
+    TASK_BLOCKED,
+    TASK_DELETED
+} task_state;
+
+struct host_task {
+    ucontext_t context;
+    uint8_t* stack;
+    size_t stack_size;
+    size_t depth;               // Stack size on the device
+    TaskFunction_t function;
+    void* param;
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t priority;
+    UBaseType_t number;
+    task_state state;
+    uint64_t ready_seq;         // Order of ready tasks of equal priority
+    const void* wait_object;
+    int64_t wake_at;            // Deadline of the wait, or KERNEL_FOREVER
+    bool timed_out;
+    uint32_t notify_value;
+    bool notify_pending;
+    uint64_t run_us;            // Host time spent running
+    struct host_task* next;
+};
+
+struct host_timer {
+    int64_t at;
+    int64_t period;
+    host_timer_cb callback;
+    void* ctx;
+    uint64_t seq;
+    bool active;
+    struct host_timer* next;
+};
+
+typedef enum {
+    QUEUE_DATA,
+    QUEUE_MUTEX,
+    QUEUE_SEMAPHORE
+} queue_type;
+
+struct host_queue {
+    queue_type type;
+    uint8_t* items;
+    UBaseType_t length;         // Capacity, or maximum count of a semaphore
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+};
+
+struct host_event_group {
+    EventBits_t bits;
+};
+
+static ucontext_t sched_context;
+static struct host_task* tasks = NULL;
+static struct host_task* current = NULL;
+static struct host_timer* timers = NULL;
+static struct host_task idle_task = { .name = "IDLE" };
+static int64_t now_us = 0;
+static int64_t end_us = 0;
+static uint64_t next_seq = 0;
+static UBaseType_t num_tasks = 0;
+static UBaseType_t next_number = 1;
+static bool stopping = false;
+static uint64_t cpu_us = 0;
+static void (*app_entry)(void) = NULL;
+
+static uint64_t mono_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void make_ready(struct host_task* task) {
+    task->state = TASK_READY;
+    task->wait_object = NULL;
+    task->wake_at = KERNEL_FOREVER;
+    task->ready_seq = next_seq++;
+}
+
+static struct host_task* pick_ready(void) {
+    struct host_task* best = NULL;
+    for (struct host_task* task = tasks; task != NULL; task = task->next) {
+        if (task->state != TASK_READY) {
+            continue;
+        }
+        if (best == NULL || task->priority > best->priority ||
+            (task->priority == best->priority &&
+            task->ready_seq < best->ready_seq)) {
+                best = task;
+        }
+    }
+
+    return best;
+}
+
+static void switch_out(void) {
+    swapcontext(&current->context, &sched_context);
+}
+
+static void preempt(void) {
+    if (current == NULL) {
+        return;
+    }
+
+    struct host_task* next = pick_ready();
+    if (next != NULL && next != current && next->priority > current->priority) {
+        make_ready(current);
+        switch_out();
+    }
+}
+
+static void task_entry(void) {
+    struct host_task* task = current;
+    task->function(task->param);
+
+    // Returning from a task is not allowed, app_main() is deleted by IDF
+    vTaskDelete(NULL);
+}
+
+static void free_task(struct host_task* task) {
+    struct host_task** link = &tasks;
+    while (*link != task) {
+        link = &(*link)->next;
+    }
+    *link = task->next;
+
+    munmap(task->stack, task->stack_size);
+    free(task);
+}
+
+static void sweep_timers(void) {
+    struct host_timer** link = &timers;
+    while (*link != NULL) {
+        struct host_timer* timer = *link;
+        if (!timer->active) {
+            *link = timer->next;
+            free(timer);
+        }
+        else {
+            link = &timer->next;
+        }
+    }
+}
+
+static struct host_timer* next_timer(void) {
+    struct host_timer* best = NULL;
+    for (struct host_timer* timer = timers; timer != NULL;
+        timer = timer->next) {
+            if (timer->active && (best == NULL || timer->at < best->at ||
+                (timer->at == best->at && timer->seq < best->seq))) {
+                    best = timer;
+            }
+    }
+
+    return best;
+}
+
+static bool advance(void) {
+    // Earliest timer or task deadline
+    int64_t next = -1;
+    struct host_timer* timer = next_timer();
+    if (timer != NULL) {
+        next = timer->at;
+    }
+    for (struct host_task* task = tasks; task != NULL; task = task->next) {
+        if (task->state == TASK_BLOCKED && task->wake_at != KERNEL_FOREVER &&
+            (next == -1 || task->wake_at < next)) {
+                next = task->wake_at;
+        }
+    }
+
+    if (next == -1) {
+        printf("Every task is blocked forever.\n");
+        return false;
+    }
+    if (next > end_us) {
+        now_us = end_us;
+        return false;
+    }
+    if (next > now_us) {
+        now_us = next;
+    }
+
+    // Timers first, in the order they are due
+    while ((timer = next_timer()) != NULL && timer->at <= now_us) {
+        if (timer->period > 0) {
+            timer->at += timer->period;
+        }
+        else {
+            timer->active = false;
+        }
+        timer->seq = next_seq++;
+        timer->callback(timer->ctx);
+    }
+    sweep_timers();
+
+    for (struct host_task* task = tasks; task != NULL; task = task->next) {
+        if (task->state == TASK_BLOCKED && task->wake_at != KERNEL_FOREVER &&
+            task->wake_at <= now_us) {
+                make_ready(task);
+                task->timed_out = true;
+        }
+    }
+
+    return true;
+}
+
+static void main_task(void* pvParameters) {
+    app_entry();
+}
+
+int64_t host_run(void (*entry)(void), int64_t duration) {
+    end_us = now_us + duration;
+    stopping = false;
+    app_entry = entry;
+    xTaskCreate(main_task, "main", MAIN_TASK_STACK, NULL, 1, NULL);
+
+    uint64_t mark = mono_us();
+    while (!stopping) {
+        struct host_task* next = pick_ready();
+        if (next == NULL) {
+            if (!advance()) {
+                break;
+            }
+            continue;
+        }
+
+        uint64_t start = mono_us();
+        cpu_us += start - mark;
+        idle_task.run_us += start - mark;
+
+        current = next;
+        swapcontext(&sched_context, &next->context);
+        current = NULL;
+
+        mark = mono_us();
+        cpu_us += mark - start;
+        next->run_us += mark - start;
+        if (next->state == TASK_DELETED) {
+            free_task(next);
+        }
+    }
+    cpu_us += mono_us() - mark;
+
+    return now_us;
+}
+
+void host_stop(const char* reason) {
+    printf("%s\n", reason);
+    stopping = true;
+}
+
+int64_t host_time_us(void) {
+    return now_us;
+}
+
+void host_sleep_us(int64_t us) {
+    int64_t deadline = now_us + us;
+    while (kernel_wait(NULL, deadline) == 0) {
+    }
+}
+
+uint64_t host_cpu_us(void) {
+    return cpu_us;
+}
+
+host_timer* host_timer_start(int64_t delay, int64_t period,
+    host_timer_cb callback, void* ctx) {
+        struct host_timer* timer = calloc(1, sizeof(struct host_timer));
+        if (timer == NULL) {
+            return NULL;
+        }
+        timer->at = now_us + (delay > 0 ? delay : 0);
+        timer->period = period;
+        timer->callback = callback;
+        timer->ctx = ctx;
+        timer->seq = next_seq++;
+        timer->active = true;
+        timer->next = timers;
+        timers = timer;
+
+        return timer;
+}
+
+void host_timer_stop(host_timer* timer) {
+    // Freed between tasks, the timer may be running its callback
+    if (timer != NULL) {
+        timer->active = false;
+    }
+}
+
+int64_t kernel_deadline(TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        return KERNEL_FOREVER;
+    }
+
+    // Deadlines fall on tick boundaries as on the device
+    return (now_us / KERNEL_TICK_US + ticks) * KERNEL_TICK_US;
+}
+
+int kernel_wait(const void* object, int64_t deadline) {
+    if (current == NULL || (deadline != KERNEL_FOREVER && deadline <= now_us)) {
+        return -1;
+    }
+
+    current->state = TASK_BLOCKED;
+    current->wait_object = object;
+    current->wake_at = deadline;
+    current->timed_out = false;
+    switch_out();
+
+    return current->timed_out ? -1 : 0;
+}
+
+void kernel_wake(const void* object) {
+    for (struct host_task* task = tasks; task != NULL; task = task->next) {
+        if (task->state == TASK_BLOCKED && task->wait_object == object &&
+            object != NULL) {
+                make_ready(task);
+        }
+    }
+    preempt();
+}
+
+bool kernel_in_task(void) {
+    return current != NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char* pcName,
+    configSTACK_DEPTH_TYPE usStackDepth, void* pvParameters,
+    UBaseType_t uxPriority, TaskHandle_t* pxCreatedTask) {
+        struct host_task* task = calloc(1, sizeof(struct host_task));
+        if (task == NULL) {
+            return pdFAIL;
+        }
+
+        task->stack_size = (size_t)usStackDepth * HOST_STACK_SCALE;
+        if (task->stack_size < HOST_STACK_MIN) {
+            task->stack_size = HOST_STACK_MIN;
+        }
+        task->depth = usStackDepth;
+
+        // Kept out of the malloc heap, which stands for the device heap
+        task->stack = mmap(NULL, task->stack_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        if (task->stack == MAP_FAILED) {
+            free(task);
+            return pdFAIL;
+        }
+        // Painted to find the deepest use of the stack
+        memset(task->stack, STACK_FILL, task->stack_size);
+
+        getcontext(&task->context);
+        task->context.uc_stack.ss_sp = task->stack;
+        task->context.uc_stack.ss_size = task->stack_size;
+        task->context.uc_link = &sched_context;
+        makecontext(&task->context, task_entry, 0);
+
+        task->function = pxTaskCode;
+        task->param = pvParameters;
+        strlcpy(task->name, pcName != NULL ? pcName : "", sizeof(task->name));
+        task->priority = uxPriority < configMAX_PRIORITIES ? uxPriority :
+            configMAX_PRIORITIES - 1;
+        task->number = next_number++;
+        make_ready(task);
+
+        // Appended so tasks are listed in creation order
+        struct host_task** link = &tasks;
+        while (*link != NULL) {
+            link = &(*link)->next;
+        }
+        *link = task;
+        num_tasks++;
+
+        if (pxCreatedTask != NULL) {
+            *pxCreatedTask = task;
+        }
+        preempt();
+
+        return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode,
+    const char* pcName, configSTACK_DEPTH_TYPE usStackDepth,
+    void* pvParameters, UBaseType_t uxPriority, TaskHandle_t* pxCreatedTask,
+    BaseType_t xCoreID) {
+        return xTaskCreate(pxTaskCode, pcName, usStackDepth, pvParameters,
+            uxPriority, pxCreatedTask);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+    struct host_task* task = xTaskToDelete != NULL ? xTaskToDelete : current;
+    if (task == NULL || task->state == TASK_DELETED) {
+        return;
+    }
+
+    task->state = TASK_DELETED;
+    num_tasks--;
+    if (task == current) {
+        // Stack is freed by the scheduler once switched out
+        switch_out();
+    }
+    else {
+        free_task(task);
+    }
+}
+
+void vTaskDelay(TickType_t xTicksToDelay) {
+    if (current == NULL) {
+        return;
+    }
+
+    if (xTicksToDelay == 0) {
+        make_ready(current);
+        switch_out();
+        return;
+    }
+    host_sleep_us(kernel_deadline(xTicksToDelay) - now_us);
+}
+
+BaseType_t xTaskDelayUntil(TickType_t* pxPreviousWakeTime,
+    TickType_t xTimeIncrement) {
+        TickType_t wake = *pxPreviousWakeTime + xTimeIncrement;
+        *pxPreviousWakeTime = wake;
+
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(wake - now) <= 0) {
+            return pdFALSE;
+        }
+        vTaskDelay(wake - now);
+
+        return pdTRUE;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(now_us / KERNEL_TICK_US);
+}
+
+TickType_t xTaskGetTickCountFromISR(void) {
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return current;
+}
+
+const char* pcTaskGetName(TaskHandle_t xTaskToQuery) {
+    struct host_task* task = xTaskToQuery != NULL ? xTaskToQuery : current;
+
+    return task != NULL ? task->name : NULL;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask) {
+    struct host_task* task = xTask != NULL ? xTask : current;
+
+    return task != NULL ? task->priority : 0;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+    // IDLE is listed as well
+    return num_tasks + 1;
+}
+
+static UBaseType_t stack_free(const struct host_task* task) {
+    // Stack grows down from the end of the allocation
+    size_t untouched = 0;
+    while (untouched < task->stack_size &&
+        task->stack[untouched] == STACK_FILL) {
+            untouched++;
+    }
+
+    // Against the device stack size, host frames are larger
+    size_t used = task->stack_size - untouched;
+
+    return used < task->depth ? (UBaseType_t)(task->depth - used) : 0;
+}
+
+size_t kernel_stack_bytes(void) {
+    size_t total = 0;
+    for (struct host_task* task = tasks; task != NULL; task = task->next) {
+        if (task->state != TASK_DELETED) {
+            total += task->depth;
+        }
+    }
+
+    return total;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask) {
+    struct host_task* task = xTask != NULL ? xTask : current;
+
+    return task != NULL ? stack_free(task) : 0;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* pxTaskStatusArray,
+    UBaseType_t uxArraySize, configRUN_TIME_COUNTER_TYPE* pulTotalRunTime) {
+        if (uxArraySize < uxTaskGetNumberOfTasks()) {
+            return 0;
+        }
+
+        UBaseType_t count = 0;
+        for (struct host_task* task = tasks; task != NULL; task = task->next) {
+            if (task->state == TASK_DELETED) {
+                continue;
+            }
+
+            TaskStatus_t* status = &pxTaskStatusArray[count++];
+            memset(status, 0, sizeof(TaskStatus_t));
+            status->xHandle = task;
+            status->pcTaskName = task->name;
+            status->xTaskNumber = task->number;
+            status->eCurrentState = task == current ? eRunning :
+                task->state == TASK_READY ? eReady : eBlocked;
+            status->uxCurrentPriority = task->priority;
+            status->uxBasePriority = task->priority;
+            status->ulRunTimeCounter = (uint32_t)task->run_us;
+            status->pxStackBase = task->stack;
+            status->usStackHighWaterMark = stack_free(task);
+            status->xCoreID = tskNO_AFFINITY;
+        }
+
+        // Time between tasks, spent in timers and shim hooks
+        TaskStatus_t* idle = &pxTaskStatusArray[count++];
+        memset(idle, 0, sizeof(TaskStatus_t));
+        idle->xHandle = &idle_task;
+        idle->pcTaskName = idle_task.name;
+        idle->eCurrentState = eReady;
+        idle->ulRunTimeCounter = (uint32_t)idle_task.run_us;
+        idle->xCoreID = tskNO_AFFINITY;
+
+        if (pulTotalRunTime != NULL) {
+            *pulTotalRunTime = (uint32_t)cpu_us;
+        }
+
+        return count;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify) {
+    return xTaskNotify(xTaskToNotify, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify,
+    BaseType_t* pxHigherPriorityTaskWoken) {
+        xTaskNotify(xTaskToNotify, 0, eIncrement);
+        if (pxHigherPriorityTaskWoken != NULL) {
+            *pxHigherPriorityTaskWoken = pdFALSE;
+        }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit,
+    TickType_t xTicksToWait) {
+        struct host_task* task = current;
+        if (task == NULL) {
+            return 0;
+        }
+
+        int64_t deadline = kernel_deadline(xTicksToWait);
+        while (task->notify_value == 0) {
+            if (kernel_wait(&task->notify_value, deadline) == -1) {
+                break;
+            }
+        }
+
+        uint32_t value = task->notify_value;
+        if (value > 0) {
+            task->notify_value = xClearCountOnExit ? 0 : value - 1;
+        }
+        task->notify_pending = false;
+
+        return value;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue,
+    eNotifyAction eAction) {
+        struct host_task* task = xTaskToNotify;
+        if (task == NULL || task->state == TASK_DELETED) {
+            return pdFAIL;
+        }
+
+        switch (eAction) {
+            case eSetBits:
+                task->notify_value |= ulValue;
+                break;
+            case eIncrement:
+                task->notify_value++;
+                break;
+            case eSetValueWithOverwrite:
+                task->notify_value = ulValue;
+                break;
+            case eSetValueWithoutOverwrite:
+                if (task->notify_pending) {
+                    return pdFAIL;
+                }
+                task->notify_value = ulValue;
+                break;
+            default:
+                break;
+        }
+        task->notify_pending = true;
+        kernel_wake(&task->notify_value);
+
+        return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry,
+    uint32_t ulBitsToClearOnExit, uint32_t* pulNotificationValue,
+    TickType_t xTicksToWait) {
+        struct host_task* task = current;
+        if (task == NULL) {
+            return pdFALSE;
+        }
+
+        if (!task->notify_pending) {
+            task->notify_value &= ~ulBitsToClearOnEntry;
+        }
+
+        int64_t deadline = kernel_deadline(xTicksToWait);
+        while (!task->notify_pending) {
+            if (kernel_wait(&task->notify_value, deadline) == -1) {
+                break;
+            }
+        }
+
+        if (pulNotificationValue != NULL) {
+            *pulNotificationValue = task->notify_value;
+        }
+        if (!task->notify_pending) {
+            return pdFALSE;
+        }
+        task->notify_value &= ~ulBitsToClearOnExit;
+        task->notify_pending = false;
+
+        return pdTRUE;
+}
+
+static struct host_queue* create_queue(queue_type type, UBaseType_t length,
+    UBaseType_t item_size, UBaseType_t count) {
+        struct host_queue* queue = calloc(1, sizeof(struct host_queue));
+        if (queue == NULL) {
+            return NULL;
+        }
+        if (item_size > 0) {
+            queue->items = malloc((size_t)length * item_size);
+            if (queue->items == NULL) {
+                free(queue);
+                return NULL;
+            }
+        }
+        queue->type = type;
+        queue->length = length;
+        queue->item_size = item_size;
+        queue->count = count;
+
+        return queue;
+}
+
+static BaseType_t queue_send(QueueHandle_t queue, const void* item,
+    TickType_t ticks, bool front) {
+        if (queue == NULL) {
+            return pdFAIL;
+        }
+
+        int64_t deadline = kernel_deadline(ticks);
+        while (queue->count == queue->length) {
+            if (kernel_wait(queue, deadline) == -1) {
+                return pdFAIL;
+            }
+        }
+
+        if (queue->item_size > 0) {
+            UBaseType_t slot;
+            if (front) {
+                queue->head = (queue->head + queue->length - 1) % queue->length;
+                slot = queue->head;
+            }
+            else {
+                slot = (queue->head + queue->count) % queue->length;
+            }
+            memcpy(queue->items + (size_t)slot * queue->item_size, item,
+                queue->item_size);
+        }
+        queue->count++;
+        kernel_wake(queue);
+
+        return pdPASS;
+}
+
+static BaseType_t queue_receive(QueueHandle_t queue, void* buffer,
+    TickType_t ticks, bool peek) {
+        if (queue == NULL) {
+            return pdFAIL;
+        }
+
+        int64_t deadline = kernel_deadline(ticks);
+        while (queue->count == 0) {
+            if (kernel_wait(queue, deadline) == -1) {
+                return pdFAIL;
+            }
+        }
+
+        if (queue->item_size > 0) {
+            memcpy(buffer, queue->items + (size_t)queue->head * queue->item_size,
+                queue->item_size);
+        }
+        if (!peek) {
+            if (queue->item_size > 0) {
+                queue->head = (queue->head + 1) % queue->length;
+            }
+            queue->count--;
+            kernel_wake(queue);
+        }
+
+        return pdPASS;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize) {
+    if (uxQueueLength == 0) {
+        return NULL;
+    }
+
+    return create_queue(QUEUE_DATA, uxQueueLength, uxItemSize, 0);
+}
+
+void vQueueDelete(QueueHandle_t xQueue) {
+    if (xQueue != NULL) {
+        free(xQueue->items);
+        free(xQueue);
+    }
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue,
+    TickType_t xTicksToWait) {
+        return queue_send(xQueue, pvItemToQueue, xTicksToWait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void* pvItemToQueue,
+    TickType_t xTicksToWait) {
+        return queue_send(xQueue, pvItemToQueue, xTicksToWait, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void* pvItemToQueue,
+    BaseType_t* pxHigherPriorityTaskWoken) {
+        if (pxHigherPriorityTaskWoken != NULL) {
+            *pxHigherPriorityTaskWoken = pdFALSE;
+        }
+
+        return queue_send(xQueue, pvItemToQueue, 0, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t xQueue, const void* pvItemToQueue) {
+    // Only defined for queues of length one
+    if (xQueue != NULL && xQueue->count == xQueue->length) {
+        xQueue->count = 0;
+    }
+
+    return queue_send(xQueue, pvItemToQueue, 0, false);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer,
+    TickType_t xTicksToWait) {
+        return queue_receive(xQueue, pvBuffer, xTicksToWait, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void* pvBuffer,
+    TickType_t xTicksToWait) {
+        return queue_receive(xQueue, pvBuffer, xTicksToWait, true);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue) {
+    return xQueue != NULL ? xQueue->count : 0;
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue) {
+    if (xQueue != NULL && xQueue->type == QUEUE_DATA) {
+        xQueue->count = 0;
+        xQueue->head = 0;
+        kernel_wake(xQueue);
+    }
+
+    return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return create_queue(QUEUE_MUTEX, 1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return create_queue(QUEUE_SEMAPHORE, 1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount,
+    UBaseType_t uxInitialCount) {
+        return create_queue(QUEUE_SEMAPHORE, uxMaxCount, 0, uxInitialCount);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore,
+    TickType_t xBlockTime) {
+        return queue_receive(xSemaphore, NULL, xBlockTime, false);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore) {
+    return queue_send(xSemaphore, NULL, 0, false);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore,
+    BaseType_t* pxHigherPriorityTaskWoken) {
+        if (pxHigherPriorityTaskWoken != NULL) {
+            *pxHigherPriorityTaskWoken = pdFALSE;
+        }
+
+        return queue_send(xSemaphore, NULL, 0, false);
+}
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    return calloc(1, sizeof(struct host_event_group));
+}
+
+void vEventGroupDelete(EventGroupHandle_t xEventGroup) {
+    free(xEventGroup);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup,
+    const EventBits_t uxBitsToSet) {
+        xEventGroup->bits |= uxBitsToSet;
+        EventBits_t bits = xEventGroup->bits;
+        kernel_wake(xEventGroup);
+
+        return bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup,
+    const EventBits_t uxBitsToClear) {
+        EventBits_t bits = xEventGroup->bits;
+        xEventGroup->bits &= ~uxBitsToClear;
+
+        return bits;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup) {
+    return xEventGroup->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup,
+    const EventBits_t uxBitsToWaitFor, const BaseType_t xClearOnExit,
+    const BaseType_t xWaitForAllBits, TickType_t xTicksToWait) {
+        int64_t deadline = kernel_deadline(xTicksToWait);
+
+        while (1) {
+            EventBits_t bits = xEventGroup->bits;
+            EventBits_t set = bits & uxBitsToWaitFor;
+            if (xWaitForAllBits ? set == uxBitsToWaitFor : set != 0) {
+                if (xClearOnExit) {
+                    xEventGroup->bits &= ~uxBitsToWaitFor;
+                }
+                return bits;
+            }
+            if (kernel_wait(xEventGroup, deadline) == -1) {
+                return xEventGroup->bits;
+            }
+        }
+}
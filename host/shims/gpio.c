@@ -0,0 +1,76 @@
+#include "driver/gpio.h"
+
+#include "host.h"
+
+static gpio_mode_t modes[GPIO_NUM_MAX];
+static uint32_t outputs[GPIO_NUM_MAX];
+static int inputs[GPIO_NUM_MAX];
+static host_gpio_observer observer = NULL;
+static void* observer_ctx = NULL;
+
+static bool valid_pin(gpio_num_t gpio_num) {
+    return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX;
+}
+
+void host_gpio_set_observer(host_gpio_observer new_observer, void* ctx) {
+    observer = new_observer;
+    observer_ctx = ctx;
+}
+
+void host_gpio_set_input(gpio_num_t pin, int level) {
+    if (valid_pin(pin)) {
+        inputs[pin] = level;
+    }
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    modes[gpio_num] = mode;
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t pull) {
+    return valid_pin(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    level = level ? 1 : 0;
+    if (outputs[gpio_num] != level) {
+        outputs[gpio_num] = level;
+        if (observer != NULL) {
+            observer(gpio_num, level, observer_ctx);
+        }
+    }
+
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    if (!valid_pin(gpio_num)) {
+        return 0;
+    }
+
+    return modes[gpio_num] & GPIO_MODE_INPUT ? inputs[gpio_num] :
+        (int)outputs[gpio_num];
+}
+
+esp_err_t gpio_hold_en(gpio_num_t gpio_num) {
+    return valid_pin(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_hold_dis(gpio_num_t gpio_num) {
+    return valid_pin(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void gpio_deep_sleep_hold_en(void) {
+}
+
+void gpio_deep_sleep_hold_dis(void) {
+}
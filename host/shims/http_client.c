@@ -0,0 +1,560 @@
+#include "esp_http_client.h"
+
+#include <strings.h>
+
+#include "esp_timer.h"
+#include "host.h"
+#include "kernel.h"
+
+#define MAX_HEADERS 12
+#define DEFAULT_TIMEOUT_MS 5000
+#define DEFAULT_BUFFER_SIZE 512
+
+// Status line and headers of a Firebase response
+#define RESPONSE_HEADER_BYTES 160
+
+typedef struct {
+    char key[32];
+    char value[96];
+} header;
+
+struct esp_http_client {
+    char url[512];
+    esp_http_client_method_t method;
+    header headers[MAX_HEADERS];
+    int num_headers;
+    const char* post_data;
+    int post_len;
+    http_event_handle_cb event_handler;
+    void* user_data;
+    int timeout_ms;
+    int buffer_size;
+
+    bool connected;
+    bool stale;                 // Dropped by the server while idle
+    int64_t last_used;
+    bool chunked;
+    char* request;
+    int request_len;
+    int request_cap;
+
+    int status;
+    char* response;
+    int response_len;
+    int response_pos;
+    bool headers_fetched;
+    bool finished;
+    bool stream;
+    struct esp_http_client* next;
+};
+
+static struct esp_http_client* clients = NULL;
+static host_http_handler handler = NULL;
+static void* handler_ctx = NULL;
+static host_http_stats stats;
+
+static void emit(struct esp_http_client* client, esp_http_client_event_id_t id,
+    void* data, int len) {
+        if (client->event_handler == NULL) {
+            return;
+        }
+
+        esp_http_client_event_t evt = {
+            .event_id = id,
+            .client = client,
+            .data = data,
+            .data_len = len,
+            .user_data = client->user_data
+        };
+        if (id == HTTP_EVENT_ON_HEADER) {
+            evt.header_key = "Content-Type";
+            evt.header_value = "application/json; charset=utf-8";
+        }
+        client->event_handler(&evt);
+}
+
+static header* find_header(struct esp_http_client* client, const char* key) {
+    for (int i = 0; i < client->num_headers; i++) {
+        if (strcasecmp(client->headers[i].key, key) == 0) {
+            return &client->headers[i];
+        }
+    }
+
+    return NULL;
+}
+
+static const char* header_value(struct esp_http_client* client,
+    const char* key) {
+        header* h = find_header(client, key);
+
+        return h != NULL ? h->value : "";
+}
+
+static void reset_response(struct esp_http_client* client) {
+    free(client->response);
+    client->response = NULL;
+    client->response_len = 0;
+    client->response_pos = 0;
+    client->status = 0;
+    client->headers_fetched = false;
+    client->finished = false;
+    client->stream = false;
+}
+
+static int append(char** buffer, int* len, int* cap, const char* data,
+    int data_len) {
+        if (*len + data_len + 1 > *cap) {
+            int new_cap = *cap > 0 ? *cap : 256;
+            while (new_cap < *len + data_len + 1) {
+                new_cap *= 2;
+            }
+            char* grown = realloc(*buffer, new_cap);
+            if (grown == NULL) {
+                return -1;
+            }
+            *buffer = grown;
+            *cap = new_cap;
+        }
+        memcpy(*buffer + *len, data, data_len);
+        *len += data_len;
+        (*buffer)[*len] = '\0';
+
+        return 0;
+}
+
+static int dechunk(char* body, int len) {
+    // Decoded in place, data is never longer than its framing
+    int in = 0;
+    int out = 0;
+    while (in < len) {
+        char* end;
+        long size = strtol(body + in, &end, 16);
+        char* line_end = strstr(end, "\r\n");
+        if (line_end == NULL || size < 0) {
+            return -1;
+        }
+        in = line_end + 2 - body;
+        if (size == 0) {
+            break;
+        }
+        if (in + size + 2 > len) {
+            return -1;
+        }
+        memmove(body + out, body + in, size);
+        out += size;
+        in += size + 2;
+    }
+    body[out] = '\0';
+
+    return out;
+}
+
+static int connect_client(struct esp_http_client* client) {
+    if (client->connected) {
+        int64_t idle = host_time_us() - client->last_used;
+        if (idle > (int64_t)HOST_HTTP_IDLE_MS * 1000) {
+            // Noticed only once the request goes unanswered
+            client->stale = true;
+        }
+        return 0;
+    }
+
+    if (!wifi_link_up()) {
+        return -1;
+    }
+    host_sleep_us((int64_t)HOST_HTTP_CONNECT_MS * 1000);
+    if (!wifi_link_up()) {
+        return -1;
+    }
+
+    client->connected = true;
+    client->stale = false;
+    client->last_used = host_time_us();
+    stats.connects++;
+    emit(client, HTTP_EVENT_ON_CONNECTED, NULL, 0);
+
+    return 0;
+}
+
+static int request_header_bytes(struct esp_http_client* client) {
+    // Request line, Host and the set headers
+    int len = strlen(client->url) + 64;
+    for (int i = 0; i < client->num_headers; i++) {
+        len += strlen(client->headers[i].key) +
+            strlen(client->headers[i].value) + 4;
+    }
+
+    return len;
+}
+
+static int send_request(struct esp_http_client* client) {
+    int body_len = client->request_len;
+    if (client->chunked && body_len > 0) {
+        body_len = dechunk(client->request, client->request_len);
+        if (body_len < 0) {
+            printf("ERROR host HTTP malformed chunked body.\n");
+            return -1;
+        }
+    }
+    stats.bytes_sent += request_header_bytes(client) + client->request_len;
+
+    host_sleep_us((int64_t)HOST_HTTP_REQUEST_MS * 1000);
+    if (!client->connected || client->stale) {
+        if (client->stale) {
+            stats.drops++;
+        }
+        stats.failures++;
+        client->connected = false;
+        client->stale = false;
+        return -1;
+    }
+
+    // Split the URL into path and query
+    char path[512];
+    const char* start = strstr(client->url, "://");
+    start = start != NULL ? strchr(start + 3, '/') : client->url;
+    strlcpy(path, start != NULL ? start : "/", sizeof(path));
+    const char* query = "";
+    char* mark = strchr(path, '?');
+    if (mark != NULL) {
+        *mark = '\0';
+        query = mark + 1;
+    }
+
+    host_http_request request = {
+        .method = client->method,
+        .path = path,
+        .query = query,
+        .content_type = header_value(client, "Content-Type"),
+        .content_encoding = header_value(client, "Content-Encoding"),
+        .event_stream = strcmp(header_value(client, "Accept"),
+            "text/event-stream") == 0,
+        .body = client->request != NULL ? client->request : "",
+        .body_len = body_len
+    };
+    host_http_response response = {
+        .status = 200
+    };
+    if (handler != NULL) {
+        handler(&request, &response, handler_ctx);
+    }
+    else {
+        host_firebase_handler(&request, &response, NULL);
+    }
+
+    reset_response(client);
+    client->status = response.status;
+    client->response = response.body;
+    client->response_len = response.body_len;
+    client->stream = response.stream;
+    client->headers_fetched = true;
+    client->last_used = host_time_us();
+    client->request_len = 0;
+
+    stats.requests++;
+    stats.bytes_received += RESPONSE_HEADER_BYTES + response.body_len;
+    emit(client, HTTP_EVENT_ON_HEADER, NULL, 0);
+
+    return 0;
+}
+
+static int read_body(struct esp_http_client* client, char* buffer, int len) {
+    int available = client->response_len - client->response_pos;
+    if (len > available) {
+        len = available;
+    }
+    if (len > 0) {
+        memcpy(buffer, client->response + client->response_pos, len);
+        client->response_pos += len;
+        emit(client, HTTP_EVENT_ON_DATA, buffer, len);
+    }
+
+    if (!client->stream && client->response_pos == client->response_len &&
+        !client->finished) {
+            client->finished = true;
+            emit(client, HTTP_EVENT_ON_FINISH, NULL, 0);
+    }
+
+    return len;
+}
+
+esp_http_client_handle_t esp_http_client_init(
+    const esp_http_client_config_t* config) {
+        struct esp_http_client* client = calloc(1,
+            sizeof(struct esp_http_client));
+        if (client == NULL) {
+            return NULL;
+        }
+
+        strlcpy(client->url, config->url != NULL ? config->url : "",
+            sizeof(client->url));
+        client->method = config->method;
+        client->event_handler = config->event_handler;
+        client->user_data = config->user_data;
+        client->timeout_ms = config->timeout_ms > 0 ? config->timeout_ms :
+            DEFAULT_TIMEOUT_MS;
+        client->buffer_size = config->buffer_size > 0 ? config->buffer_size :
+            DEFAULT_BUFFER_SIZE;
+
+        client->next = clients;
+        clients = client;
+
+        return client;
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client) {
+    if (esp_http_client_open(client, client->post_len) != ESP_OK) {
+        return ESP_ERR_HTTP_CONNECT;
+    }
+    if (client->post_len > 0 &&
+        esp_http_client_write(client, client->post_data, client->post_len) < 0) {
+            return ESP_ERR_HTTP_WRITE_DATA;
+    }
+    if (esp_http_client_fetch_headers(client) < 0) {
+        return ESP_ERR_HTTP_FETCH_HEADER;
+    }
+
+    char* chunk = malloc(client->buffer_size);
+    if (chunk == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    while (read_body(client, chunk, client->buffer_size) > 0) {
+    }
+    free(chunk);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client,
+    const char* url) {
+        strlcpy(client->url, url, sizeof(client->url));
+
+        return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client,
+    const char* data, int len) {
+        client->post_data = data;
+        client->post_len = data != NULL ? len : 0;
+
+        return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client,
+    const char* key, const char* value) {
+        header* h = find_header(client, key);
+        if (h == NULL) {
+            if (client->num_headers == MAX_HEADERS) {
+                return ESP_ERR_NO_MEM;
+            }
+            h = &client->headers[client->num_headers++];
+            strlcpy(h->key, key, sizeof(h->key));
+        }
+        strlcpy(h->value, value, sizeof(h->value));
+
+        return ESP_OK;
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client,
+    const char* key) {
+        header* h = find_header(client, key);
+        if (h != NULL) {
+            *h = client->headers[--client->num_headers];
+        }
+
+        return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client,
+    esp_http_client_method_t method) {
+        client->method = method;
+
+        return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_timeout_ms(esp_http_client_handle_t client,
+    int timeout_ms) {
+        client->timeout_ms = timeout_ms;
+
+        return ESP_OK;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client,
+    int write_len) {
+        reset_response(client);
+        client->request_len = 0;
+        if (connect_client(client) != 0) {
+            stats.failures++;
+            return ESP_ERR_HTTP_CONNECT;
+        }
+
+        client->chunked = write_len < 0;
+        if (client->chunked) {
+            esp_http_client_set_header(client, "Transfer-Encoding", "chunked");
+        }
+        emit(client, HTTP_EVENT_HEADERS_SENT, NULL, 0);
+
+        return ESP_OK;
+}
+
+int esp_http_client_write(esp_http_client_handle_t client, const char* buffer,
+    int len) {
+        if (!client->connected || append(&client->request,
+            &client->request_len, &client->request_cap, buffer, len) != 0) {
+                return -1;
+        }
+
+        return len;
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client) {
+    if (!client->connected || send_request(client) != 0) {
+        return ESP_FAIL;
+    }
+
+    return client->stream ? 0 : client->response_len;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char* buffer,
+    int len) {
+        if (!client->headers_fetched) {
+            return -1;
+        }
+        if (!client->stream) {
+            return read_body(client, buffer, len);
+        }
+
+        // Event stream, wait for the server to send
+        int64_t deadline = host_time_us() + (int64_t)client->timeout_ms * 1000;
+        while (client->stream && client->response_pos == client->response_len) {
+            if (kernel_wait(client, deadline) == -1) {
+                return -ESP_ERR_HTTP_EAGAIN;
+            }
+        }
+        if (!client->stream) {
+            return 0;
+        }
+
+        int read_len = read_body(client, buffer, len);
+        if (client->response_pos == client->response_len) {
+            client->response_pos = 0;
+            client->response_len = 0;
+        }
+
+        return read_len;
+}
+
+esp_err_t esp_http_client_flush_response(esp_http_client_handle_t client,
+    int* len) {
+        int flushed = 0;
+        if (!client->stream) {
+            char chunk[128];
+            int read_len;
+            while ((read_len = read_body(client, chunk, sizeof(chunk))) > 0) {
+                flushed += read_len;
+            }
+        }
+        if (len != NULL) {
+            *len = flushed;
+        }
+
+        return ESP_OK;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client) {
+    return client->status;
+}
+
+int64_t esp_http_client_get_content_length(esp_http_client_handle_t client) {
+    return client->stream ? -1 : client->response_len;
+}
+
+esp_err_t esp_http_client_set_redirection(esp_http_client_handle_t client) {
+    // The stand-in does not redirect
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_get_user_data(esp_http_client_handle_t client,
+    void** data) {
+        *data = client->user_data;
+
+        return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_user_data(esp_http_client_handle_t client,
+    void* data) {
+        client->user_data = data;
+
+        return ESP_OK;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client) {
+    if (client->connected) {
+        client->connected = false;
+        emit(client, HTTP_EVENT_DISCONNECTED, NULL, 0);
+    }
+    client->stale = false;
+    reset_response(client);
+    kernel_wake(client);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client) {
+    esp_http_client_close(client);
+
+    struct esp_http_client** link = &clients;
+    while (*link != NULL && *link != client) {
+        link = &(*link)->next;
+    }
+    if (*link != NULL) {
+        *link = client->next;
+    }
+    free(client->request);
+    free(client);
+
+    return ESP_OK;
+}
+
+void http_link_down(void) {
+    struct esp_http_client* next;
+    for (struct esp_http_client* client = clients; client != NULL;
+        client = next) {
+            // Woken reader may close and free its client before we return
+            next = client->next;
+            if (client->connected) {
+                client->connected = false;
+                client->stream = false;
+                kernel_wake(client);
+            }
+    }
+}
+
+void host_http_set_handler(host_http_handler new_handler, void* ctx) {
+    handler = new_handler;
+    handler_ctx = ctx;
+}
+
+void host_http_stream_send(const char* data, int len) {
+    struct esp_http_client* next;
+    for (struct esp_http_client* client = clients; client != NULL;
+        client = next) {
+            // Woken reader may close and free its client before we return
+            next = client->next;
+            if (!client->connected || !client->stream) {
+                continue;
+            }
+
+            int cap = client->response_len + 1;
+            if (append(&client->response, &client->response_len, &cap, data,
+                len) == 0) {
+                    stats.bytes_received += len;
+                    client->last_used = host_time_us();
+                    kernel_wake(client);
+            }
+    }
+}
+
+host_http_stats host_http_get_stats(void) {
+    return stats;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file kernel.h
+ * @brief Task switching and blocking shared by the host shims
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Every blocking call of the shims waits on an object, which is any
+ * address the waking side agrees on, until the object is woken or a deadline
+ * on the virtual clock passes. A woken task checks its condition again, so
+ * waking more tasks than needed is harmless.
+ *
+ */
+
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @def KERNEL_TICK_US
+ * @brief Length of a FreeRTOS tick (in us)
+ *
+ */
+#define KERNEL_TICK_US (1000000 / configTICK_RATE_HZ)
+
+/**
+ * @def KERNEL_FOREVER
+ * @brief Deadline of a wait without timeout
+ *
+ */
+#define KERNEL_FOREVER -1
+
+/**
+ * @brief Deadline of a wait of a number of ticks
+ *
+ * @param[in] ticks Ticks to wait, portMAX_DELAY for no timeout
+ *
+ * @return int64_t: Deadline on the virtual clock (in us), or KERNEL_FOREVER
+ *
+ */
+int64_t kernel_deadline(TickType_t ticks);
+
+/**
+ * @brief Block the running task until an object is woken
+ *
+ * Returns at once if no task is running or the deadline has passed.
+ *
+ * @param[in] object Object to wait on
+ * @param[in] deadline Deadline (in us), or KERNEL_FOREVER
+ *
+ * @retval 0 Object was woken
+ * @retval -1 Deadline passed
+ *
+ */
+int kernel_wait(const void* object, int64_t deadline);
+
+/**
+ * @brief Wake every task waiting on an object
+ *
+ * The running task is switched out if a woken task has a higher priority.
+ *
+ * @param[in] object Object
+ *
+ */
+void kernel_wake(const void* object);
+
+/**
+ * @brief Check if a task is running
+ *
+ * @retval true Called from a task
+ * @retval false Called from a timer or outside host_run()
+ *
+ */
+bool kernel_in_task(void);
+
+/**
+ * @brief Stack the live tasks would take from the device heap
+ *
+ * @return size_t: Sum of the stack sizes passed to xTaskCreate() (in bytes)
+ *
+ */
+size_t kernel_stack_bytes(void);
+
+/**
+ * @brief Check if the station has an address
+ *
+ * @retval true WiFi connected
+ * @retval false WiFi down
+ *
+ */
+bool wifi_link_up(void);
+
+/**
+ * @brief Check if the WiFi driver holds ADC2
+ *
+ * The radio uses ADC2 while it connects, oneshot reads of ADC2 time out
+ * meanwhile.
+ *
+ * @retval true ADC2 in use by WiFi
+ * @retval false ADC2 free
+ *
+ */
+bool wifi_adc2_busy(void);
+
+/**
+ * @brief Close every HTTP connection after WiFi went down
+ *
+ */
+void http_link_down(void);
+
+#endif
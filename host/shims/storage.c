@@ -0,0 +1,216 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "esp_partition.h"
+#include "host.h"
+#include "nvs_flash.h"
+
+#define MAX_ENTRIES 32
+#define MAX_NAMESPACES 8
+#define NAME_LEN 16
+
+#define OFFLINE_SIZE 0x40000
+#define SECTOR_SIZE 0x1000
+
+/**
+ * @brief Stored NVS value
+ *
+ */
+typedef struct {
+    nvs_handle_t ns;
+    char key[NAME_LEN];
+    int64_t value;
+} nvs_entry;
+
+static bool nvs_ready = false;
+static char namespaces[MAX_NAMESPACES][NAME_LEN];
+static int num_namespaces = 0;
+static nvs_entry entries[MAX_ENTRIES];
+static int num_entries = 0;
+
+static const esp_partition_t offline = {
+    .type = ESP_PARTITION_TYPE_DATA,
+    .subtype = 0x40,
+    .address = 0x190000,
+    .size = OFFLINE_SIZE,
+    .erase_size = SECTOR_SIZE,
+    .label = "offline"
+};
+static uint8_t* offline_flash = NULL;
+
+esp_err_t nvs_flash_init(void) {
+    nvs_ready = true;
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    num_entries = 0;
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* namespace_name, nvs_open_mode_t open_mode,
+    nvs_handle_t* out_handle) {
+        if (!nvs_ready) {
+            return ESP_ERR_NVS_NOT_INITIALIZED;
+        }
+
+        // Handles are the namespace index plus one
+        for (int i = 0; i < num_namespaces; i++) {
+            if (strcmp(namespaces[i], namespace_name) == 0) {
+                *out_handle = i + 1;
+                return ESP_OK;
+            }
+        }
+        if (open_mode == NVS_READONLY) {
+            return ESP_ERR_NVS_NOT_FOUND;
+        }
+        if (num_namespaces == MAX_NAMESPACES) {
+            return ESP_ERR_NO_MEM;
+        }
+        strlcpy(namespaces[num_namespaces], namespace_name, NAME_LEN);
+        *out_handle = ++num_namespaces;
+
+        return ESP_OK;
+}
+
+static nvs_entry* find_entry(nvs_handle_t handle, const char* key) {
+    for (int i = 0; i < num_entries; i++) {
+        if (entries[i].ns == handle && strcmp(entries[i].key, key) == 0) {
+            return &entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+esp_err_t nvs_get_i64(nvs_handle_t handle, const char* key,
+    int64_t* out_value) {
+        nvs_entry* entry = find_entry(handle, key);
+        if (entry == NULL) {
+            return ESP_ERR_NVS_NOT_FOUND;
+        }
+        *out_value = entry->value;
+
+        return ESP_OK;
+}
+
+esp_err_t nvs_set_i64(nvs_handle_t handle, const char* key, int64_t value) {
+    nvs_entry* entry = find_entry(handle, key);
+    if (entry == NULL) {
+        if (num_entries == MAX_ENTRIES) {
+            return ESP_ERR_NVS_NO_FREE_PAGES;
+        }
+        entry = &entries[num_entries++];
+        entry->ns = handle;
+        strlcpy(entry->key, key, NAME_LEN);
+    }
+    entry->value = value;
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+}
+
+int host_partition_set_file(const char* path) {
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd == -1) {
+        printf("ERROR opening partition file %s.\n", path);
+        return -1;
+    }
+
+    struct stat info;
+    uint8_t* flash = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && ftruncate(fd, OFFLINE_SIZE) == 0) {
+        flash = mmap(NULL, OFFLINE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+            fd, 0);
+    }
+    close(fd);
+    if (flash == MAP_FAILED) {
+        printf("ERROR mapping partition file %s.\n", path);
+        return -1;
+    }
+
+    // New part of the file reads as erased flash
+    if (info.st_size < OFFLINE_SIZE) {
+        memset(flash + info.st_size, 0xFF, OFFLINE_SIZE - info.st_size);
+    }
+    if (offline_flash != NULL) {
+        munmap(offline_flash, OFFLINE_SIZE);
+    }
+    offline_flash = flash;
+
+    return 0;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+    esp_partition_subtype_t subtype, const char* label) {
+        if ((type != offline.type && type != ESP_PARTITION_TYPE_ANY) ||
+            (subtype != offline.subtype &&
+            subtype != ESP_PARTITION_SUBTYPE_ANY) ||
+            (label != NULL && strcmp(label, offline.label) != 0)) {
+                return NULL;
+        }
+
+        // Erased flash reads as ones, kept out of the malloc heap
+        if (offline_flash == NULL) {
+            offline_flash = mmap(NULL, OFFLINE_SIZE, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (offline_flash == MAP_FAILED) {
+                offline_flash = NULL;
+                return NULL;
+            }
+            memset(offline_flash, 0xFF, OFFLINE_SIZE);
+        }
+
+        return &offline;
+}
+
+static bool in_range(size_t offset, size_t size) {
+    return offset <= OFFLINE_SIZE && size <= OFFLINE_SIZE - offset;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition,
+    size_t src_offset, void* dst, size_t size) {
+        if (partition != &offline || !in_range(src_offset, size)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        memcpy(dst, offline_flash + src_offset, size);
+
+        return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition,
+    size_t dst_offset, const void* src, size_t size) {
+        if (partition != &offline || !in_range(dst_offset, size)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        // Writes only clear bits, as on flash
+        const uint8_t* bytes = src;
+        for (size_t i = 0; i < size; i++) {
+            offline_flash[dst_offset + i] &= bytes[i];
+        }
+
+        return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition,
+    size_t offset, size_t size) {
+        if (partition != &offline || !in_range(offset, size) ||
+            offset % SECTOR_SIZE != 0 || size % SECTOR_SIZE != 0) {
+                return ESP_ERR_INVALID_ARG;
+        }
+        memset(offline_flash + offset, 0xFF, size);
+
+        return ESP_OK;
+}
@@ -0,0 +1,204 @@
+#include <malloc.h>
+
+#include "driver/temperature_sensor.h"
+#include "esp_heap_caps.h"
+#include "esp_sleep.h"
+#include "host.h"
+#include "kernel.h"
+#include "led_strip.h"
+
+#define DEFAULT_TEMPERATURE 42.0f
+
+struct temperature_sensor_obj_t {
+    bool enabled;
+};
+
+struct led_strip_t {
+    uint32_t max_leds;
+};
+
+// Embedded by the IDF build from the certificate file
+const char certificate_pem_start[] __asm__("_binary_certificate_pem_start") =
+    "";
+const char certificate_pem_end[] __asm__("_binary_certificate_pem_end") = "";
+
+static float chip_temperature = DEFAULT_TEMPERATURE;
+static size_t min_free = HOST_HEAP_SIZE;
+static uint64_t sleep_us = 0;
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:
+            return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:
+            return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:
+            return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:
+            return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_NVS_NOT_INITIALIZED:
+            return "ESP_ERR_NVS_NOT_INITIALIZED";
+        case ESP_ERR_NVS_NOT_FOUND:
+            return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_NO_FREE_PAGES:
+            return "ESP_ERR_NVS_NO_FREE_PAGES";
+        case ESP_ERR_WIFI_NOT_INIT:
+            return "ESP_ERR_WIFI_NOT_INIT";
+        case ESP_ERR_WIFI_NOT_STARTED:
+            return "ESP_ERR_WIFI_NOT_STARTED";
+        case ESP_ERR_WIFI_CONN:
+            return "ESP_ERR_WIFI_CONN";
+        case ESP_ERR_HTTP_CONNECT:
+            return "ESP_ERR_HTTP_CONNECT";
+        case ESP_ERR_HTTP_WRITE_DATA:
+            return "ESP_ERR_HTTP_WRITE_DATA";
+        case ESP_ERR_HTTP_FETCH_HEADER:
+            return "ESP_ERR_HTTP_FETCH_HEADER";
+        case ESP_ERR_HTTP_EAGAIN:
+            return "ESP_ERR_HTTP_EAGAIN";
+        default:
+            return "UNKNOWN ERROR";
+    }
+}
+
+#ifndef HAVE_STRLCPY
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t copy_len = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, copy_len);
+        dst[copy_len] = '\0';
+    }
+
+    return len;
+}
+#endif
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    // Firmware allocations plus the stacks the device would allocate
+    struct mallinfo2 info = mallinfo2();
+    size_t used = info.uordblks + kernel_stack_bytes();
+    size_t free_size = used < HOST_HEAP_SIZE ? HOST_HEAP_SIZE - used : 0;
+    if (free_size < min_free) {
+        min_free = free_size;
+    }
+
+    return free_size;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    // Lowest seen by the heap queries, not by every allocation
+    heap_caps_get_free_size(caps);
+
+    return min_free;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us) {
+    sleep_us = time_in_us;
+
+    return ESP_OK;
+}
+
+void esp_deep_sleep_start(void) {
+    printf("Deep sleep for %llu ms ends the host run.\n",
+        (unsigned long long)(sleep_us / 1000));
+    host_stop("Deep sleep.");
+
+    // Never switched back in
+    while (kernel_in_task()) {
+        kernel_wait(NULL, KERNEL_FOREVER);
+    }
+    exit(0);
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void) {
+    return ESP_SLEEP_WAKEUP_UNDEFINED;
+}
+
+void host_set_chip_temperature(float celsius) {
+    chip_temperature = celsius;
+}
+
+esp_err_t temperature_sensor_install(
+    const temperature_sensor_config_t* tsens_config,
+    temperature_sensor_handle_t* ret_tsens) {
+        if (tsens_config->range_min >= tsens_config->range_max) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        *ret_tsens = calloc(1, sizeof(struct temperature_sensor_obj_t));
+
+        return *ret_tsens != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t temperature_sensor_uninstall(temperature_sensor_handle_t tsens) {
+    free(tsens);
+
+    return ESP_OK;
+}
+
+esp_err_t temperature_sensor_enable(temperature_sensor_handle_t tsens) {
+    tsens->enabled = true;
+
+    return ESP_OK;
+}
+
+esp_err_t temperature_sensor_disable(temperature_sensor_handle_t tsens) {
+    tsens->enabled = false;
+
+    return ESP_OK;
+}
+
+esp_err_t temperature_sensor_get_celsius(temperature_sensor_handle_t tsens,
+    float* out_celsius) {
+        if (!tsens->enabled) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        *out_celsius = chip_temperature;
+
+        return ESP_OK;
+}
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t* led_config,
+    const led_strip_rmt_config_t* rmt_config, led_strip_handle_t* ret_strip) {
+        *ret_strip = calloc(1, sizeof(struct led_strip_t));
+        if (*ret_strip == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        (*ret_strip)->max_leds = led_config->max_leds;
+
+        return ESP_OK;
+}
+
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index,
+    uint32_t red, uint32_t green, uint32_t blue) {
+        return index < strip->max_leds ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t led_strip_refresh(led_strip_handle_t strip) {
+    return ESP_OK;
+}
+
+esp_err_t led_strip_clear(led_strip_handle_t strip) {
+    return ESP_OK;
+}
+
+esp_err_t led_strip_del(led_strip_handle_t strip) {
+    free(strip);
+
+    return ESP_OK;
+}
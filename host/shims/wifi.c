@@ -0,0 +1,314 @@
+#include "esp_wifi.h"
+
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "host.h"
+#include "kernel.h"
+
+#define MAX_HANDLERS 8
+#define EVENT_QUEUE_LEN 32
+#define EVENT_TASK_PRIORITY 20
+#define EVENT_TASK_STACK 2304
+#define AP_CHANNEL 6
+#define REASON_ASSOC_LEAVE 8
+
+/**
+ * @brief Registered event handler
+ *
+ */
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void* arg;
+} handler_entry;
+
+/**
+ * @brief Posted event waiting for the event task
+ *
+ */
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    uint8_t data[ESP_EVENT_DATA_MAX];
+} posted_event;
+
+const esp_event_base_t WIFI_EVENT = "WIFI_EVENT";
+const esp_event_base_t IP_EVENT = "IP_EVENT";
+
+static const uint8_t ap_bssid[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+static handler_entry handlers[MAX_HANDLERS];
+static int num_handlers = 0;
+static QueueHandle_t event_queue = NULL;
+
+static wifi_config_t sta_config;
+static bool initialized = false;
+static bool started = false;
+static bool ap_available = true;
+static bool connecting = false;
+static bool associated = false;
+static bool has_ip = false;
+static host_timer* pending = NULL;
+
+static void event_task(void* pvParameters) {
+    posted_event event;
+    while (1) {
+        xQueueReceive(event_queue, &event, portMAX_DELAY);
+        for (int i = 0; i < num_handlers; i++) {
+            if ((handlers[i].base == ESP_EVENT_ANY_BASE ||
+                handlers[i].base == event.base) &&
+                (handlers[i].id == ESP_EVENT_ANY_ID ||
+                handlers[i].id == event.id)) {
+                    handlers[i].handler(handlers[i].arg, event.base, event.id,
+                        event.data);
+            }
+        }
+    }
+}
+
+esp_err_t esp_event_loop_create_default(void) {
+    if (event_queue != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    event_queue = xQueueCreate(EVENT_QUEUE_LEN, sizeof(posted_event));
+    if (event_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(event_task, "sys_evt", EVENT_TASK_STACK, NULL,
+        EVENT_TASK_PRIORITY, NULL) != pdPASS) {
+            return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_event_loop_delete_default(void) {
+    // Event task keeps running, nothing is posted once WiFi is stopped
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base,
+    int32_t event_id, esp_event_handler_t event_handler,
+    void* event_handler_arg) {
+        if (num_handlers == MAX_HANDLERS) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        handler_entry* entry = &handlers[num_handlers++];
+        entry->base = event_base;
+        entry->id = event_id;
+        entry->handler = event_handler;
+        entry->arg = event_handler_arg;
+
+        return ESP_OK;
+}
+
+esp_err_t esp_event_handler_unregister(esp_event_base_t event_base,
+    int32_t event_id, esp_event_handler_t event_handler) {
+        for (int i = 0; i < num_handlers; i++) {
+            if (handlers[i].base == event_base && handlers[i].id == event_id &&
+                handlers[i].handler == event_handler) {
+                    handlers[i] = handlers[--num_handlers];
+                    return ESP_OK;
+            }
+        }
+
+        return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base,
+    int32_t event_id, esp_event_handler_t event_handler,
+    void* event_handler_arg, esp_event_handler_instance_t* instance) {
+        if (instance != NULL) {
+            *instance = NULL;
+        }
+
+        return esp_event_handler_register(event_base, event_id, event_handler,
+            event_handler_arg);
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id,
+    const void* event_data, size_t event_data_size, TickType_t ticks_to_wait) {
+        if (event_queue == NULL) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (event_data_size > ESP_EVENT_DATA_MAX) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        posted_event event = {
+            .base = event_base,
+            .id = event_id
+        };
+        if (event_data != NULL) {
+            memcpy(event.data, event_data, event_data_size);
+        }
+
+        return xQueueSend(event_queue, &event, ticks_to_wait) == pdPASS ?
+            ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t esp_netif_init(void) {
+    return ESP_OK;
+}
+
+esp_netif_t* esp_netif_create_default_wifi_sta(void) {
+    static int netif;
+
+    return (esp_netif_t*)&netif;
+}
+
+static void post_disconnected(uint8_t reason) {
+    wifi_event_sta_disconnected_t event = {
+        .ssid_len = strnlen((const char*)sta_config.sta.ssid,
+            sizeof(sta_config.sta.ssid)),
+        .reason = reason,
+        .rssi = -60
+    };
+    memcpy(event.ssid, sta_config.sta.ssid, sizeof(event.ssid));
+    memcpy(event.bssid, ap_bssid, sizeof(event.bssid));
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &event,
+        sizeof(event), 0);
+}
+
+static void link_down(void) {
+    host_timer_stop(pending);
+    pending = NULL;
+    connecting = false;
+    associated = false;
+    if (has_ip) {
+        has_ip = false;
+        http_link_down();
+    }
+}
+
+static void dhcp_done(void* ctx) {
+    pending = NULL;
+    has_ip = true;
+    esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, NULL, 0, 0);
+}
+
+static void connect_done(void* ctx) {
+    pending = NULL;
+    connecting = false;
+
+    if (!ap_available) {
+        post_disconnected(WIFI_REASON_NO_AP_FOUND);
+        return;
+    }
+
+    associated = true;
+    wifi_event_sta_connected_t event = {
+        .ssid_len = strnlen((const char*)sta_config.sta.ssid,
+            sizeof(sta_config.sta.ssid)),
+        .channel = AP_CHANNEL,
+        .authmode = 3
+    };
+    memcpy(event.ssid, sta_config.sta.ssid, sizeof(event.ssid));
+    memcpy(event.bssid, ap_bssid, sizeof(event.bssid));
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &event, sizeof(event),
+        0);
+
+    pending = host_timer_start((int64_t)HOST_WIFI_DHCP_MS * 1000, 0, dhcp_done,
+        NULL);
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t* config) {
+    initialized = true;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_deinit(void) {
+    if (started) {
+        return ESP_ERR_WIFI_NOT_STOPPED;
+    }
+    initialized = false;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) {
+    return initialized ? ESP_OK : ESP_ERR_WIFI_NOT_INIT;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf) {
+    if (!initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    sta_config = *conf;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void) {
+    if (!initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (!started) {
+        started = true;
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0, 0);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_stop(void) {
+    if (started) {
+        started = false;
+        link_down();
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_STOP, NULL, 0, 0);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect(void) {
+    if (!started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    if (connecting || associated) {
+        return ESP_ERR_WIFI_CONN;
+    }
+
+    // A known access point and channel skips the scan
+    connecting = true;
+    const wifi_sta_config_t* sta = &sta_config.sta;
+    int delay_ms = sta->bssid_set && sta->channel == AP_CHANNEL &&
+        memcmp(sta->bssid, ap_bssid, sizeof(ap_bssid)) == 0 ?
+        HOST_WIFI_FAST_MS : HOST_WIFI_SCAN_MS;
+    pending = host_timer_start((int64_t)delay_ms * 1000, 0, connect_done, NULL);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_disconnect(void) {
+    if (!started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    if (connecting || associated) {
+        link_down();
+        post_disconnected(REASON_ASSOC_LEAVE);
+    }
+
+    return ESP_OK;
+}
+
+bool wifi_link_up(void) {
+    return has_ip;
+}
+
+bool wifi_adc2_busy(void) {
+    // Scan, association and DHCP run on a pending timer
+    return pending != NULL;
+}
+
+void host_wifi_set_available(bool available) {
+    ap_available = available;
+    if (!available && associated) {
+        link_down();
+        post_disconnected(WIFI_REASON_BEACON_TIMEOUT);
+    }
+}
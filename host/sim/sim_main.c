@@ -0,0 +1,421 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host.h"
+#include "sensor.h"
+#include "soil.h"
+#include "solenoid.h"
+#include "time_sync.h"
+
+// Reference time at boot, 2025-08-10 06:00:00 UTC
+#define SIM_EPOCH 1754805600
+
+#define DEFAULT_DAYS 7
+#define DEFAULT_SEED 1
+
+#define SECONDS_PER_DAY 86400
+#define SECONDS_PER_HOUR 3600
+
+// Parameters served to the firmware
+#define SIM_WATER_DURATION 60
+#define SIM_WATER_HOURS { 6, 18 }
+
+// An opening up to this early still belongs to the next hour (in s)
+#define SIM_WINDOW_LEAD 300
+
+// Open time over the longest watering still within it (in us)
+#define SIM_CAP_SLACK 1000000
+
+// Longest step of the soil model and reuse time of a reading (in us)
+#define SIM_STEP_US 60000000
+#define SIM_READING_US 1000000
+
+#define SIM_NOISE 8
+#define SIM_DRIFT_PPM 20
+
+// WiFi outages per day and their length (in min)
+#define SIM_OUTAGE_CHANCE 0.3
+#define SIM_OUTAGE_MIN 10
+#define SIM_OUTAGE_MAX 120
+
+#define MAX_ZONES 16
+
+/**
+ * @brief Zone under a valve and its sensor
+ *
+ */
+typedef struct {
+    soil_zone soil;
+    gpio_num_t pin;
+    adc_unit_t unit;
+    adc_channel_t channel;
+    int dry;
+    int wet;
+    bool armed;                 // Valve set closed at least once
+    int64_t updated_us;
+    int64_t read_us;
+    int reading;
+    int64_t opened_us;
+    int window_opens;
+    int64_t window_open_us;     // Open time in the current window
+} sim_zone;
+
+/**
+ * @brief Counters of one day
+ *
+ */
+typedef struct {
+    double water_l;
+    double drained_l;
+    int waterings;
+    int expected;
+    int openings;
+    int missed;
+    int duplicate;
+    int over_cap;
+    int unscheduled;
+    int uploads;
+    int outages;
+    uint64_t bytes;
+    uint64_t cpu_us;
+} sim_day;
+
+extern valve valves[];
+extern const int num_valves;
+
+void app_main(void);
+
+static const int water_hours[] = SIM_WATER_HOURS;
+static const int num_water_hours = sizeof(water_hours) / sizeof(water_hours[0]);
+
+static sim_zone zones[MAX_ZONES];
+static int num_zones = 0;
+static sim_rng rng;
+static int band_low = 0;
+static int band_high = 0;
+static sim_day today;
+static sim_day total;
+static int day = 0;
+static bool first_window = true;
+static host_http_stats last_stats;
+static uint64_t last_cpu = 0;
+
+static double local_hour(time_t t) {
+    struct tm tm;
+    localtime_r(&t, &tm);
+
+    return tm.tm_hour + tm.tm_min / 60.0 + tm.tm_sec / 3600.0;
+}
+
+static void advance(sim_zone* zone) {
+    // Evaporation follows the reference time of day
+    int64_t now = host_time_us();
+    while (zone->updated_us < now) {
+        int64_t step = now - zone->updated_us;
+        if (step > SIM_STEP_US) {
+            step = SIM_STEP_US;
+        }
+        time_t t = SIM_EPOCH + zone->updated_us / 1000000;
+        soil_step(&zone->soil, step / 1e6, soil_evaporation(local_hour(t)));
+        zone->updated_us += step;
+    }
+}
+
+static sim_zone* zone_on_channel(adc_unit_t unit, adc_channel_t channel) {
+    for (int i = 0; i < num_zones; i++) {
+        if (zones[i].unit == unit && zones[i].channel == channel) {
+            return &zones[i];
+        }
+    }
+
+    return NULL;
+}
+
+static int adc_source(adc_unit_t unit, adc_channel_t channel, void* ctx) {
+    sim_zone* zone = zone_on_channel(unit, channel);
+    if (zone == NULL) {
+        return 0;
+    }
+
+    // Conversions of the same second share the soil state
+    int64_t now = host_time_us();
+    if (zone->read_us == 0 || now - zone->read_us >= SIM_READING_US) {
+        advance(zone);
+        zone->reading = soil_reading(&zone->soil, zone->dry, zone->wet);
+        zone->read_us = now;
+    }
+
+    int raw = zone->reading +
+        (int)((rng_next(&rng) * 2 - 1) * SIM_NOISE);
+    if (raw < 0) {
+        return 0;
+    }
+
+    return raw > 4095 ? 4095 : raw;
+}
+
+static void gpio_observer(gpio_num_t pin, uint32_t level, void* ctx) {
+    for (int i = 0; i < num_zones; i++) {
+        sim_zone* zone = &zones[i];
+        if (zone->pin != pin) {
+            continue;
+        }
+
+        // Outputs start low, the valve is only closed once set high
+        advance(zone);
+        if (level == VALVE_HIGH_NUM) {
+            if (zone->soil.open) {
+                zone->window_open_us += host_time_us() - zone->opened_us;
+            }
+            zone->armed = true;
+            zone->soil.open = false;
+        }
+        else if (zone->armed) {
+            zone->soil.open = true;
+            zone->opened_us = host_time_us();
+            zone->window_opens++;
+            today.openings++;
+        }
+    }
+}
+
+static void http_handler(const host_http_request* request,
+    host_http_response* response, void* ctx) {
+        if (request->method != HTTP_METHOD_GET &&
+            strcmp(request->path, "/parameters.json") != 0) {
+                today.uploads++;
+        }
+
+        host_firebase_handler(request, response, NULL);
+}
+
+static bool is_water_hour(int hour) {
+    for (int i = 0; i < num_water_hours; i++) {
+        if (water_hours[i] == hour) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void window_end(void* ctx) {
+    // Window of an hour runs from SIM_WINDOW_LEAD before it to the same
+    // time before the next
+    time_t t = host_clock_reference() + SIM_WINDOW_LEAD - 1;
+    struct tm tm;
+    localtime_r(&t, &tm);
+    bool scheduled = is_water_hour(tm.tm_hour);
+
+    for (int i = 0; i < num_zones; i++) {
+        sim_zone* zone = &zones[i];
+        if (scheduled && !first_window) {
+            today.expected++;
+            if (zone->window_opens == 0) {
+                today.missed++;
+            }
+            else {
+                today.waterings++;
+            }
+
+            // Pulses of closed-loop watering are not repeats
+            if (band_high == 0 && zone->window_opens > 1) {
+                today.duplicate += zone->window_opens - 1;
+            }
+            if (zone->window_open_us >
+                (int64_t)SIM_WATER_DURATION * 1000000 + SIM_CAP_SLACK) {
+                    today.over_cap++;
+            }
+        }
+        else if (!scheduled) {
+            today.unscheduled += zone->window_opens;
+        }
+        zone->window_opens = 0;
+        zone->window_open_us = 0;
+    }
+    first_window = false;
+}
+
+static void outage_end(void* ctx) {
+    host_wifi_set_available(true);
+}
+
+static void outage_begin(void* ctx) {
+    int64_t length = (int64_t)rng_range(&rng, SIM_OUTAGE_MIN,
+        SIM_OUTAGE_MAX) * 60 * 1000000;
+    today.outages++;
+    host_wifi_set_available(false);
+    host_timer_start(length, 0, outage_end, NULL);
+}
+
+static void plan_outage(void) {
+    if (rng_next(&rng) < SIM_OUTAGE_CHANCE) {
+        int64_t delay = (int64_t)(rng_next(&rng) * SECONDS_PER_DAY) * 1000000;
+        host_timer_start(delay, 0, outage_begin, NULL);
+    }
+}
+
+static void print_day(const char* label, const sim_day* counts) {
+    // Wet zones are skipped on purpose in closed-loop watering
+    printf("%-6s water %6.1f L, drained %5.1f L, waterings %3d/%-3d "
+        "openings %3d, %s %d, duplicate %d, over cap %d, unscheduled %d, "
+        "outages %d, uploads %4d, %7.1f kB, CPU %6.0f ms\n", label,
+        counts->water_l, counts->drained_l, counts->waterings,
+        counts->expected, counts->openings,
+        band_high > 0 ? "skipped" : "missed", counts->missed,
+        counts->duplicate, counts->over_cap, counts->unscheduled,
+        counts->outages, counts->uploads, counts->bytes / 1024.0,
+        counts->cpu_us / 1000.0);
+}
+
+static void day_end(void* ctx) {
+    for (int i = 0; i < num_zones; i++) {
+        advance(&zones[i]);
+        today.water_l += zones[i].soil.water_l;
+        today.drained_l += zones[i].soil.drained_l;
+        zones[i].soil.water_l = 0;
+        zones[i].soil.drained_l = 0;
+    }
+
+    host_http_stats stats = host_http_get_stats();
+    today.bytes = stats.bytes_sent + stats.bytes_received -
+        last_stats.bytes_sent - last_stats.bytes_received;
+    last_stats = stats;
+    uint64_t cpu = host_cpu_us();
+    today.cpu_us = cpu - last_cpu;
+    last_cpu = cpu;
+
+    char label[16];
+    snprintf(label, sizeof(label), "Day %d", ++day);
+    print_day(label, &today);
+
+    total.water_l += today.water_l;
+    total.drained_l += today.drained_l;
+    total.waterings += today.waterings;
+    total.expected += today.expected;
+    total.openings += today.openings;
+    total.over_cap += today.over_cap;
+    total.missed += today.missed;
+    total.duplicate += today.duplicate;
+    total.unscheduled += today.unscheduled;
+    total.uploads += today.uploads;
+    total.outages += today.outages;
+    total.bytes += today.bytes;
+    total.cpu_us += today.cpu_us;
+    memset(&today, 0, sizeof(today));
+
+    plan_outage();
+}
+
+static int init_zones(void) {
+    if (num_valves > MAX_ZONES) {
+        printf("ERROR more than %d valves.\n", MAX_ZONES);
+        return -1;
+    }
+
+    for (int i = 0; i < num_valves; i++) {
+        const sensor* sens = valves[i].sensor_obj;
+        if (sens == NULL) {
+            printf("ERROR %s has no sensor.\n", valves[i].name);
+            return -1;
+        }
+
+        sim_zone* zone = &zones[num_zones++];
+        soil_init(&zone->soil, &rng);
+        zone->pin = valves[i].pin;
+        zone->unit = sens->unit;
+        zone->channel = sens->channel;
+        zone->dry = sens->mean_dry;
+        zone->wet = sens->mean_wet;
+    }
+
+    return 0;
+}
+
+static void set_params(void) {
+    char json[192];
+    int pos = snprintf(json, sizeof(json),
+        "{\"Water_Duration_Set\": %d, \"Water_Times_Set\": [",
+        SIM_WATER_DURATION);
+    for (int i = 0; i < num_water_hours; i++) {
+        pos += snprintf(json + pos, sizeof(json) - pos, "%s%d",
+            i == 0 ? "" : ", ", water_hours[i]);
+    }
+    pos += snprintf(json + pos, sizeof(json) - pos, "]");
+    if (band_high > 0) {
+        pos += snprintf(json + pos, sizeof(json) - pos,
+            ", \"Moisture_Low_Set\": %d, \"Moisture_High_Set\": %d",
+            band_low, band_high);
+    }
+    snprintf(json + pos, sizeof(json) - pos, "}");
+    host_firebase_set_params(json);
+}
+
+int main(int argc, char** argv) {
+    int days = argc > 1 ? atoi(argv[1]) : DEFAULT_DAYS;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 0) : DEFAULT_SEED;
+    band_low = argc > 4 ? atoi(argv[3]) : 0;
+    band_high = argc > 4 ? atoi(argv[4]) : 0;
+    if (days <= 0 || band_low < 0 || band_high < 0) {
+        printf("Usage: %s [days] [seed] [moisture_low moisture_high]\n",
+            argv[0]);
+        return 1;
+    }
+
+    // Console task polls stdin, which must not wait for a terminal
+    if (freopen("/dev/null", "r", stdin) == NULL) {
+        printf("ERROR reopening stdin.\n");
+        return 1;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    // Windows are judged in the time zone of the firmware
+    setenv("TZ", TIME_ZONE, 1);
+    tzset();
+
+    rng_seed(&rng, seed);
+    if (init_zones() == -1) {
+        return 1;
+    }
+    int32_t drift_ppm = (int32_t)rng_range(&rng, -SIM_DRIFT_PPM,
+        SIM_DRIFT_PPM);
+    host_clock_init(SIM_EPOCH, drift_ppm);
+    set_params();
+
+    host_adc_set_source(adc_source, NULL);
+    host_gpio_set_observer(gpio_observer, NULL);
+    host_http_set_handler(http_handler, NULL);
+
+    int64_t first = (int64_t)(SECONDS_PER_HOUR - SIM_WINDOW_LEAD -
+        SIM_EPOCH % SECONDS_PER_HOUR) * 1000000;
+    host_timer_start(first, (int64_t)SECONDS_PER_HOUR * 1000000, window_end,
+        NULL);
+    host_timer_start((int64_t)SECONDS_PER_DAY * 1000000,
+        (int64_t)SECONDS_PER_DAY * 1000000, day_end, NULL);
+    plan_outage();
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int64_t end = host_run(app_main, (int64_t)days * SECONDS_PER_DAY * 1000000);
+    struct timespec stop;
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    double wall_ms = (stop.tv_sec - start.tv_sec) * 1000.0 +
+        (stop.tv_nsec - start.tv_nsec) / 1000000.0;
+
+    printf("\n");
+    printf("Seed %llu, clock drift %d ppm\n", (unsigned long long)seed,
+        (int)drift_ppm);
+    print_day("Total", &total);
+    for (int i = 0; i < num_zones; i++) {
+        printf("%s: moisture %.0f %%, %.1f L/min into %.1f L\n",
+            valves[i].name, zones[i].soil.moisture * 100,
+            zones[i].soil.flow_lpm, zones[i].soil.capacity_l);
+    }
+    printf("Simulated: %.2f days in %.0f ms (%.0fx real time)\n",
+        end / 8.64e10, wall_ms, end / 1000.0 / wall_ms);
+
+    return 0;
+}
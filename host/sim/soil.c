@@ -0,0 +1,67 @@
+#include "soil.h"
+
+#include <math.h>
+
+#define SECONDS_PER_DAY 86400.0
+
+void rng_seed(sim_rng* rng, uint64_t seed) {
+    // Zero is a fixed point of xorshift
+    rng->state = seed * 0x9E3779B97F4A7C15ULL + 1;
+}
+
+double rng_next(sim_rng* rng) {
+    // xorshift64*
+    rng->state ^= rng->state >> 12;
+    rng->state ^= rng->state << 25;
+    rng->state ^= rng->state >> 27;
+    uint64_t value = rng->state * 0x2545F4914F6CDD1DULL;
+
+    return (value >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double rng_range(sim_rng* rng, double min, double max) {
+    return min + (max - min) * rng_next(rng);
+}
+
+void soil_init(soil_zone* zone, sim_rng* rng) {
+    zone->moisture = rng_range(rng, 0.35, 0.75);
+    zone->capacity_l = rng_range(rng, 8.0, 14.0);
+    zone->loss_per_day = rng_range(rng, 0.2, 0.4);
+    zone->flow_lpm = rng_range(rng, 1.5, 2.5);
+    zone->open = false;
+    zone->water_l = 0;
+    zone->drained_l = 0;
+}
+
+void soil_step(soil_zone* zone, double seconds, double evaporation) {
+    if (zone->open) {
+        double liters = zone->flow_lpm * seconds / 60.0;
+        zone->water_l += liters;
+        zone->moisture += liters / zone->capacity_l;
+    }
+
+    zone->moisture -= zone->moisture * zone->loss_per_day * evaporation *
+        seconds / SECONDS_PER_DAY;
+
+    // Water past field capacity drains away
+    if (zone->moisture > 1.0) {
+        zone->drained_l += (zone->moisture - 1.0) * zone->capacity_l;
+        zone->moisture = 1.0;
+    }
+    if (zone->moisture < 0.0) {
+        zone->moisture = 0.0;
+    }
+}
+
+double soil_evaporation(double hour) {
+    // Half the loss at night, the rest peaking at noon
+    if (hour < 6.0 || hour >= 18.0) {
+        return 0.5;
+    }
+
+    return 0.5 + (M_PI / 2) * sin(M_PI * (hour - 6.0) / 12.0);
+}
+
+int soil_reading(const soil_zone* zone, int dry, int wet) {
+    return dry + (int)lround((wet - dry) * zone->moisture);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file soil.h
+ * @brief Soil moisture model of one watering zone
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Moisture is the fraction of field capacity held by the soil. It is
+ * lost to evaporation and uptake in proportion to itself and to the time of
+ * day, rises with the water let in by an open valve, and drains away above
+ * field capacity. The sensor reading follows moisture linearly between the
+ * calibrated dry and wet values.
+ *
+ */
+
+#ifndef SOIL_H
+#define SOIL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Pseudo-random generator, repeatable from its seed
+ *
+ */
+typedef struct {
+    uint64_t state;
+} sim_rng;
+
+/**
+ * @brief Soil and valve of one zone
+ *
+ */
+typedef struct {
+    double moisture;            /**< Fraction of field capacity (0 to 1) */
+    double capacity_l;          /**< Water held at field capacity (L) */
+    double loss_per_day;        /**< Fraction of moisture lost per day */
+    double flow_lpm;            /**< Flow of the open valve (L/min) */
+    bool open;                  /**< Valve open */
+    double water_l;             /**< Water let in since start (L) */
+    double drained_l;           /**< Water drained above field capacity (L) */
+} soil_zone;
+
+/**
+ * @brief Seed a generator
+ *
+ * @param[out] rng Generator
+ * @param[in] seed Seed, any value
+ *
+ */
+void rng_seed(sim_rng* rng, uint64_t seed);
+
+/**
+ * @brief Next uniform number
+ *
+ * @param[in,out] rng Generator
+ *
+ * @return double: Number in [0, 1)
+ *
+ */
+double rng_next(sim_rng* rng);
+
+/**
+ * @brief Uniform number in a range
+ *
+ * @param[in,out] rng Generator
+ * @param[in] min Lower bound
+ * @param[in] max Upper bound
+ *
+ * @return double: Number in [min, max)
+ *
+ */
+double rng_range(sim_rng* rng, double min, double max);
+
+/**
+ * @brief Draw the soil and valve of a zone
+ *
+ * @param[out] zone Zone
+ * @param[in,out] rng Generator
+ *
+ */
+void soil_init(soil_zone* zone, sim_rng* rng);
+
+/**
+ * @brief Advance a zone
+ *
+ * @param[in,out] zone Zone
+ * @param[in] seconds Time to advance (in s)
+ * @param[in] evaporation Loss relative to the daily mean (0 at night)
+ *
+ */
+void soil_step(soil_zone* zone, double seconds, double evaporation);
+
+/**
+ * @brief Loss relative to the daily mean at a time of day
+ *
+ * @param[in] hour Local time of day (in hours, 0 to 24)
+ *
+ * @return double: Relative loss, averaging 1 over a day
+ *
+ */
+double soil_evaporation(double hour);
+
+/**
+ * @brief Raw sensor reading of a zone
+ *
+ * @param[in] zone Zone
+ * @param[in] dry Calibrated dry reading
+ * @param[in] wet Calibrated wet reading
+ *
+ * @return int: Raw reading without noise
+ *
+ */
+int soil_reading(const soil_zone* zone, int dry, int wet);
+
+#endif
@@ -0,0 +1,51 @@
+/**
+ * @file check.h
+ * @brief Checks shared by the host tests
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Each test is a program registered with CTest. A failed check
+ * prints its location and the test goes on, so one run reports every
+ * failure. The exit status is that of check_result().
+ *
+ */
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+/**
+ * @brief Check a condition
+ *
+ * @param[in] cond Condition that must hold
+ *
+ */
+#define CHECK(cond) check_true((cond), #cond, __FILE__, __LINE__)
+
+static int check_failures = 0;
+
+static void check_true(int ok, const char* cond, const char* file, int line) {
+    if (!ok) {
+        fprintf(stderr, "FAIL %s:%d: %s\n", file, line, cond);
+        check_failures++;
+    }
+}
+
+/**
+ * @brief Report the checks of a test
+ *
+ * @param[in] name Test name
+ *
+ * @return int: Exit status, 0 if every check held
+ *
+ */
+static int check_result(const char* name) {
+    fprintf(stderr, "%s: %s\n", name, check_failures == 0 ? "passed" :
+        "FAILED");
+
+    return check_failures == 0 ? 0 : 1;
+}
+
+#endif
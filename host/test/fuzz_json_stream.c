@@ -0,0 +1,434 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_stream.h"
+#include "planter_utils.h"
+
+#define MAX_INPUT 4096
+#define MAX_LOG 65536
+#define MAX_CHUNK 16
+
+// Deepest nesting accepted by the parser
+#define PARSER_DEPTH 32
+
+#define DEFAULT_RUNS 20000
+
+/**
+ * @brief Elements reported by the parser, one record per callback
+ *
+ */
+typedef struct {
+    char data[MAX_LOG];
+    int len;
+    bool long_value;            // A value may be cut when split across chunks
+} event_log;
+
+/**
+ * @brief Reference JSON reader
+ *
+ * Accepts what the parser accepts: standard JSON, with any byte allowed in
+ * strings and any byte after a backslash.
+ *
+ */
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+    int depth;
+} ref_reader;
+
+static uint64_t rng_state = 1;
+
+static uint32_t rng_next(void) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+
+    return (rng_state * 2685821657736338717ULL) >> 32;
+}
+
+static void check_int(const char* value, int len) {
+    // Integer part, stops growing once past the int range
+    long long ref = 0;
+    int i = len > 0 && value[0] == '-' ? 1 : 0;
+    for (; i < len && value[i] >= '0' && value[i] <= '9'; i++) {
+        if (ref <= (long long)INT32_MAX + 1) {
+            ref = ref * 10 + (value[i] - '0');
+        }
+    }
+    if (value[0] == '-') {
+        ref = ref > (long long)INT32_MAX + 1 ? INT32_MIN : -ref;
+    }
+    else if (ref > INT32_MAX) {
+        ref = INT32_MAX;
+    }
+
+    if (json_to_int(value, len) != ref) {
+        fprintf(stderr, "FAIL json_to_int(%.*s) = %d\n", len, value,
+            json_to_int(value, len));
+        abort();
+    }
+}
+
+static void log_event(const json_parser* parser, json_type type,
+    const char* value, int len, void* ctx) {
+        event_log* log = ctx;
+        if (type == JSON_NUMBER) {
+            check_int(value, len);
+        }
+        if (len >= JSON_TOKEN_MAX - 1) {
+            log->long_value = true;
+        }
+
+        const char* key = json_path_key(parser, parser->depth);
+        int n = snprintf(log->data + log->len, MAX_LOG - log->len,
+            "%d %d %s %d %d:", type, parser->depth, key != NULL ? key : "-",
+            json_path_index(parser, parser->depth), len);
+        if (n < 0 || n >= MAX_LOG - log->len || len > MAX_LOG - log->len - n) {
+            log->long_value = true;
+            return;
+        }
+        log->len += n;
+        if (len > 0) {
+            memcpy(log->data + log->len, value, len);
+            log->len += len;
+        }
+}
+
+static void ref_space(ref_reader* r) {
+    while (r->p < r->end && (*r->p == ' ' || *r->p == '\t' ||
+        *r->p == '\r' || *r->p == '\n')) {
+            r->p++;
+    }
+}
+
+static bool ref_digits(ref_reader* r) {
+    const uint8_t* start = r->p;
+    while (r->p < r->end && *r->p >= '0' && *r->p <= '9') {
+        r->p++;
+    }
+
+    return r->p > start;
+}
+
+static bool ref_number(ref_reader* r) {
+    if (*r->p == '-') {
+        r->p++;
+    }
+    if (r->p < r->end && *r->p == '0') {
+        r->p++;
+    }
+    else if (r->p == r->end || *r->p < '1' || *r->p > '9' ||
+        !ref_digits(r)) {
+            return false;
+    }
+    if (r->p < r->end && *r->p == '.') {
+        r->p++;
+        if (!ref_digits(r)) {
+            return false;
+        }
+    }
+    if (r->p < r->end && (*r->p == 'e' || *r->p == 'E')) {
+        r->p++;
+        if (r->p < r->end && (*r->p == '+' || *r->p == '-')) {
+            r->p++;
+        }
+        if (!ref_digits(r)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool ref_string(ref_reader* r) {
+    // r->p is on the opening quote
+    for (r->p++; r->p < r->end; r->p++) {
+        if (*r->p == '\\') {
+            r->p++;
+            if (r->p == r->end) {
+                return false;
+            }
+        }
+        else if (*r->p == '"') {
+            r->p++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool ref_value(ref_reader* r);
+
+static bool ref_container(ref_reader* r, bool array) {
+    if (r->depth == PARSER_DEPTH) {
+        return false;
+    }
+    r->depth++;
+    r->p++;
+    ref_space(r);
+    char close = array ? ']' : '}';
+    if (r->p < r->end && *r->p == close) {
+        r->p++;
+        r->depth--;
+        return true;
+    }
+
+    while (1) {
+        if (!array) {
+            ref_space(r);
+            if (r->p == r->end || *r->p != '"' || !ref_string(r)) {
+                return false;
+            }
+            ref_space(r);
+            if (r->p == r->end || *r->p != ':') {
+                return false;
+            }
+            r->p++;
+        }
+        if (!ref_value(r)) {
+            return false;
+        }
+        ref_space(r);
+        if (r->p == r->end) {
+            return false;
+        }
+        if (*r->p == close) {
+            r->p++;
+            r->depth--;
+            return true;
+        }
+        if (*r->p != ',') {
+            return false;
+        }
+        r->p++;
+    }
+}
+
+static bool ref_value(ref_reader* r) {
+    static const char* const words[] = { "true", "false", "null" };
+
+    ref_space(r);
+    if (r->p == r->end) {
+        return false;
+    }
+    switch (*r->p) {
+        case '{':
+            return ref_container(r, false);
+        case '[':
+            return ref_container(r, true);
+        case '"':
+            return ref_string(r);
+        default:
+            break;
+    }
+    for (int i = 0; i < 3; i++) {
+        int len = strlen(words[i]);
+        if (r->end - r->p >= len && memcmp(r->p, words[i], len) == 0) {
+            r->p += len;
+            return true;
+        }
+    }
+
+    return ref_number(r);
+}
+
+static bool ref_accepts(const uint8_t* data, size_t size) {
+    ref_reader r = {
+        .p = data,
+        .end = data + size
+    };
+    if (!ref_value(&r)) {
+        return false;
+    }
+    ref_space(&r);
+
+    return r.p == r.end;
+}
+
+static bool parse(const uint8_t* data, size_t size, uint64_t seed,
+    event_log* log) {
+        json_parser parser;
+        json_init(&parser, log_event, log);
+        log->len = 0;
+        log->long_value = false;
+
+        // Whole document for seed 0, chunks of random size otherwise
+        rng_state = seed;
+        size_t pos = 0;
+        int status = 0;
+        while (pos < size && status == 0) {
+            size_t len = seed == 0 ? size : 1 + rng_next() % MAX_CHUNK;
+            if (len > size - pos) {
+                len = size - pos;
+            }
+            status = json_feed(&parser, (const char*)data + pos, len);
+            pos += len;
+        }
+
+        return status == 0 && json_finish(&parser) == 0;
+}
+
+static void bind(const uint8_t* data, size_t size, int event) {
+    static params_binder binder;
+    params_begin(&binder, event);
+    for (size_t pos = 0; pos < size; pos += MAX_CHUNK) {
+        size_t len = size - pos < MAX_CHUNK ? size - pos : MAX_CHUNK;
+        params_feed(&binder, (const char*)data + pos, len);
+    }
+    params_end(&binder);
+
+    // Scheduler opens valves for water_duration * 1000 ms
+    if (water_duration > MAX_WATER_DURATION) {
+        fprintf(stderr, "FAIL watering duration %d s accepted\n",
+            water_duration);
+        abort();
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static event_log whole;
+    static event_log chunked;
+
+    // Split points depend on the input so a failure can be replayed
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < size; i++) {
+        seed = (seed ^ data[i]) * 0x100000001B3ULL;
+    }
+
+    bool valid = ref_accepts(data, size);
+    bool whole_ok = parse(data, size, 0, &whole);
+    bool chunked_ok = parse(data, size, seed | 1, &chunked);
+    if (whole_ok != valid || chunked_ok != valid) {
+        fprintf(stderr, "FAIL %s accepted %d whole, %d chunked: %.*s\n",
+            valid ? "valid" : "invalid", whole_ok, chunked_ok, (int)size,
+            (const char*)data);
+        abort();
+    }
+    if (valid && !whole.long_value && (whole.len != chunked.len ||
+        memcmp(whole.data, chunked.data, whole.len) != 0)) {
+            fprintf(stderr, "FAIL elements differ when chunked: %.*s\n",
+                (int)size, (const char*)data);
+            abort();
+    }
+
+    // Binder reports invalid documents, only valid ones are applied
+    if (valid) {
+        bind(data, size, seed & 2);
+    }
+
+    return 0;
+}
+
+#ifndef PLANTER_LIBFUZZER
+
+static const char* const keys[] = {
+    "Water_Duration_Set", "Water_Times_Set", "Valve_Times_Set",
+    "Moisture_Low_Set", "Moisture_High_Set", "path", "data", "VALVE_1", "k"
+};
+static const char* const scalars[] = {
+    "0", "-0", "7", "18", "-12", "0.5", "1e3", "-2.50E-2", "1E+2", "true",
+    "false", "null", "\"\"", "\"/\"", "\"/Valve_Times_Set/VALVE_1\"",
+    "\"a\\\"b\"", "\"\\\\\"", "\"\\u00e9\"", "86400", "86401",
+    "2147483647", "2147483648", "-2147483648", "-2147483649", "99999999999"
+};
+static const char alphabet[] = "{}[],:\" \\-+.0123456789eEtrufalsnx\n";
+
+static int gen_value(char* out, int cap, int depth) {
+    int len = 0;
+    int kind = depth > 5 ? 2 : rng_next() % 3;
+    if (kind == 2) {
+        int n = sizeof(scalars) / sizeof(scalars[0]);
+        len = snprintf(out, cap, "%s", scalars[rng_next() % n]);
+        return len < cap ? len : cap - 1;
+    }
+
+    bool array = kind == 0;
+    int count = rng_next() % 5;
+    len += snprintf(out + len, cap - len, array ? "[" : "{");
+    for (int i = 0; i < count && len < cap - 64; i++) {
+        if (i > 0) {
+            len += snprintf(out + len, cap - len, rng_next() % 2 ? "," : ", ");
+        }
+        if (!array) {
+            len += snprintf(out + len, cap - len, "\"%s\": ",
+                keys[rng_next() % (sizeof(keys) / sizeof(keys[0]))]);
+        }
+        len += gen_value(out + len, cap - len, depth + 1);
+    }
+    if (len < cap - 1) {
+        out[len++] = array ? ']' : '}';
+        out[len] = '\0';
+    }
+
+    return len;
+}
+
+static int mutate(char* doc, int len) {
+    int edits = 1 + rng_next() % 3;
+    for (int i = 0; i < edits; i++) {
+        int pos = len > 0 ? rng_next() % len : 0;
+        char c = alphabet[rng_next() % (sizeof(alphabet) - 1)];
+        switch (rng_next() % 3) {
+            case 0:
+                if (len > 0) {
+                    doc[pos] = c;
+                }
+                break;
+            case 1:
+                if (len < MAX_INPUT - 1) {
+                    memmove(doc + pos + 1, doc + pos, len - pos);
+                    doc[pos] = c;
+                    len++;
+                }
+                break;
+            default:
+                if (len > 0) {
+                    memmove(doc + pos, doc + pos + 1, len - pos - 1);
+                    len--;
+                }
+                break;
+        }
+    }
+
+    return len;
+}
+
+int main(int argc, char** argv) {
+    int runs = argc > 1 ? atoi(argv[1]) : DEFAULT_RUNS;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+
+    // Inputs from a file are replayed as they are
+    if (argc > 3) {
+        static uint8_t input[MAX_INPUT];
+        FILE* file = fopen(argv[3], "rb");
+        if (file == NULL) {
+            printf("ERROR opening %s.\n", argv[3]);
+            return 1;
+        }
+        size_t size = fread(input, 1, sizeof(input), file);
+        fclose(file);
+        return LLVMFuzzerTestOneInput(input, size);
+    }
+
+    int valid = 0;
+    for (int i = 0; i < runs; i++) {
+        static char doc[MAX_INPUT];
+        rng_state = seed * 0x9E3779B97F4A7C15ULL + i;
+        int len = gen_value(doc, sizeof(doc), 0);
+        if (rng_next() % 2) {
+            len = mutate(doc, len);
+        }
+        valid += ref_accepts((const uint8_t*)doc, len);
+        LLVMFuzzerTestOneInput((const uint8_t*)doc, len);
+    }
+    fprintf(stderr, "json_stream fuzz: %d inputs, %d valid, passed\n", runs,
+        valid);
+
+    return 0;
+}
+
+#endif
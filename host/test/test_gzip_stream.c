@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "check.h"
+#include "gzip_stream.h"
+#include "host.h"
+#include "rest_api.h"
+#include "secrets.h"
+#include "wifi_manager.h"
+
+#define TEST_EPOCH 1754805600
+
+#define MAX_DATA 65536
+#define NUM_RECORDS 200
+
+/**
+ * @brief Compressed output collected from the callback
+ *
+ */
+typedef struct {
+    uint8_t data[2 * MAX_DATA];
+    int len;
+} sink;
+
+/**
+ * @brief PATCH as seen by the stand-in
+ *
+ */
+typedef struct {
+    int status;
+    int sent_len;               // Body on the wire
+    char* body;                 // Echo of the body after decompression
+    int body_len;
+} patch_result;
+
+static gzip_stream stream;
+static sink out;
+static uint8_t input[MAX_DATA];
+static uint8_t inflated[MAX_DATA];
+static patch_result last_patch;
+static sensor_record records[NUM_RECORDS];
+static bool finished = false;
+
+static int collect(const uint8_t* data, int len, void* ctx) {
+    sink* s = ctx;
+    if (s->len + len > (int)sizeof(s->data)) {
+        return -1;
+    }
+    memcpy(s->data + s->len, data, len);
+    s->len += len;
+
+    return 0;
+}
+
+static int gunzip(const uint8_t* data, int len, uint8_t* dst, int cap) {
+    z_stream z = {0};
+    if (inflateInit2(&z, 16 + MAX_WBITS) != Z_OK) {
+        return -1;
+    }
+    z.next_in = (Bytef*)data;
+    z.avail_in = len;
+    z.next_out = dst;
+    z.avail_out = cap;
+    int status = inflate(&z, Z_FINISH);
+    int total = z.total_out;
+    bool whole = z.avail_in == 0;
+    inflateEnd(&z);
+
+    return status == Z_STREAM_END && whole ? total : -1;
+}
+
+static void round_trip(const uint8_t* data, int len, int chunk) {
+    out.len = 0;
+    gzip_init(&stream, collect, &out);
+    for (int pos = 0; pos < len; pos += chunk) {
+        int n = len - pos < chunk ? len - pos : chunk;
+        CHECK(gzip_write(&stream, data + pos, n) == 0);
+    }
+    CHECK(gzip_finish(&stream) == 0);
+
+    int inflated_len = gunzip(out.data, out.len, inflated, sizeof(inflated));
+    CHECK(inflated_len == len && memcmp(inflated, data, len) == 0);
+}
+
+static void test_round_trip(void) {
+    static const int chunks[] = { 1, 7, 100, GZIP_WINDOW, MAX_DATA };
+    int num_chunks = sizeof(chunks) / sizeof(chunks[0]);
+
+    // Repetitive JSON as uploaded
+    int json_len = 0;
+    for (int i = 0; json_len < MAX_DATA - 128; i++) {
+        json_len += snprintf((char*)input + json_len, MAX_DATA - json_len,
+            "\"%d-SENSOR_%d\": {\"Name\": \"SENSOR_%d\", "
+            "\"Moisture\": %d.%02d}, ", TEST_EPOCH + i / 4 * 3600,
+            i % 4 + 1, i % 4 + 1, i * 7 % 100, i * 13 % 100);
+    }
+    for (int i = 0; i < num_chunks; i++) {
+        round_trip(input, 0, chunks[i]);
+        round_trip(input, 1, chunks[i]);
+        round_trip(input, json_len, chunks[i]);
+    }
+
+    // Long runs and data without matches
+    memset(input, 'a', MAX_DATA);
+    round_trip(input, MAX_DATA, 1000);
+    uint32_t x = 1;
+    for (int i = 0; i < MAX_DATA; i++) {
+        x = x * 1103515245 + 12345;
+        input[i] = x >> 24;
+    }
+    round_trip(input, MAX_DATA, 333);
+    CHECK(out.len < MAX_DATA + MAX_DATA / 8);
+}
+
+static void http_handler(const host_http_request* request,
+    host_http_response* response, void* ctx) {
+        host_firebase_handler(request, response, NULL);
+        if (request->method == HTTP_METHOD_PATCH) {
+            free(last_patch.body);
+            last_patch.status = response->status;
+            last_patch.sent_len = request->body_len;
+            last_patch.body = malloc(response->body_len);
+            last_patch.body_len = response->body_len;
+            if (last_patch.body != NULL) {
+                memcpy(last_patch.body, response->body, response->body_len);
+            }
+        }
+}
+
+static void test_upload(void) {
+    // Day of hourly readings of 8 sensors, as drained from the queue
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        records[i].name = "SENSOR";
+        records[i].timestamp = TEST_EPOCH + i / 8 * 3600;
+        records[i].moisture = (i * 731) % 10001;
+        records[i].sensor_id = i % 8;
+    }
+    CHECK(init_wifi() == 0);
+    esp_http_client_handle_t client = acquire_client("sensor_data",
+        FIREBASE_URL, FIREBASE_API_KEY);
+    CHECK(client != NULL);
+
+    CHECK(send_records(client, &json_codec, records, NUM_RECORDS,
+        REST_ENCODING_IDENTITY) == 0);
+    patch_result plain = last_patch;
+    last_patch.body = NULL;
+    CHECK(plain.status == 200);
+
+    // Stand-in decompresses the body and checks it is valid JSON
+    CHECK(send_records(client, &json_codec, records, NUM_RECORDS,
+        REST_ENCODING_GZIP) == 0);
+    CHECK(last_patch.status == 200);
+    CHECK(last_patch.sent_len < plain.sent_len / 4);
+    CHECK(last_patch.body_len == plain.body_len &&
+        memcmp(last_patch.body, plain.body, plain.body_len) == 0);
+    release_client(client, false);
+    free(plain.body);
+}
+
+static void test_main(void) {
+    test_round_trip();
+    test_upload();
+
+    finished = true;
+    host_stop("gzip_stream done");
+    vTaskDelay(portMAX_DELAY);
+}
+
+int main(int argc, char** argv) {
+    host_clock_init(TEST_EPOCH, 0);
+    host_http_set_handler(http_handler, NULL);
+    host_run(test_main, (int64_t)600 * 1000000);
+    CHECK(finished);
+
+    return check_result("gzip_stream");
+}
@@ -0,0 +1,70 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "health.h"
+#include "host.h"
+#include "wifi_manager.h"
+
+#define TEST_EPOCH 1754805600
+
+static bool fail_health = false;
+static char* last_record = NULL;
+static bool finished = false;
+
+static void http_handler(const host_http_request* request,
+    host_http_response* response, void* ctx) {
+        if (strncmp(request->path, "/health", 7) != 0) {
+            host_firebase_handler(request, response, NULL);
+            return;
+        }
+        if (fail_health) {
+            response->status = 500;
+            return;
+        }
+        free(last_record);
+        last_record = strndup(request->body, request->body_len);
+        host_firebase_handler(request, response, NULL);
+}
+
+static void test_failed_publish(void) {
+    CHECK(health_init() == 0);
+    CHECK(init_wifi() == 0);
+
+    // Slow request in the window of a record that fails to upload
+    http_timing slow = { .connect_ms = 300, .first_byte_ms = 700,
+        .total_ms = 4321 };
+    health_http_request(&slow, true);
+    fail_health = true;
+    CHECK(health_publish() == -1);
+    CHECK(last_record == NULL);
+
+    // Next record still has it
+    fail_health = false;
+    CHECK(health_publish() == 0);
+    CHECK(last_record != NULL &&
+        strstr(last_record, "\"Http_Total_Max_Ms\": 4321") != NULL);
+
+    // Window starts over once sent
+    health_report report;
+    health_snapshot(&report, false);
+    CHECK(report.http.total_max_ms < 4321);
+}
+
+static void test_main(void) {
+    test_failed_publish();
+
+    finished = true;
+    host_stop("health done");
+    vTaskDelay(portMAX_DELAY);
+}
+
+int main(int argc, char** argv) {
+    host_clock_init(TEST_EPOCH, 0);
+    host_http_set_handler(http_handler, NULL);
+    host_run(test_main, (int64_t)600 * 1000000);
+    CHECK(finished);
+    free(last_record);
+
+    return check_result("health");
+}
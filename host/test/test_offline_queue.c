@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "esp_partition.h"
+#include "host.h"
+#include "offline_queue.h"
+
+#define TEST_EPOCH 1754805600
+
+// Small ring so the tests wrap quickly
+#define RING_SECTORS 2
+#define RING_PAGES (RING_SECTORS * QUEUE_SECTOR_SIZE / QUEUE_PAGE_SIZE)
+#define SECTOR_PAGES (QUEUE_SECTOR_SIZE / QUEUE_PAGE_SIZE)
+
+static char path[] = "/tmp/planter-queue-XXXXXX";
+static const esp_partition_t* partition = NULL;
+static int failing_writes = 0;
+
+static int flash_read(void* ctx, uint32_t offset, void* dst, uint32_t len) {
+    return esp_partition_read(partition, offset, dst, len) == ESP_OK ? 0 : -1;
+}
+
+static int flash_write(void* ctx, uint32_t offset, const void* src,
+    uint32_t len) {
+        // A failing write stops halfway, as on power loss
+        if (failing_writes > 0) {
+            failing_writes--;
+            esp_partition_write(partition, offset, src, len / 2);
+            return -1;
+        }
+
+        return esp_partition_write(partition, offset, src, len) == ESP_OK ?
+            0 : -1;
+}
+
+static int flash_erase(void* ctx, uint32_t offset, uint32_t len) {
+    return esp_partition_erase_range(partition, offset, len) == ESP_OK ?
+        0 : -1;
+}
+
+static int restart(void) {
+    // Flash is read back from the file, RAM state is lost
+    if (host_partition_set_file(path) != 0) {
+        return -1;
+    }
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+        ESP_PARTITION_SUBTYPE_ANY, QUEUE_PARTITION_LABEL);
+    if (partition == NULL) {
+        return -1;
+    }
+
+    queue_storage storage = {
+        .read = flash_read,
+        .write = flash_write,
+        .erase = flash_erase,
+        .size = RING_SECTORS * QUEUE_SECTOR_SIZE
+    };
+
+    return queue_init_storage(&storage);
+}
+
+static void erase_all(void) {
+    esp_partition_erase_range(partition, 0, RING_SECTORS * QUEUE_SECTOR_SIZE);
+    restart();
+}
+
+static queue_record make_record(int i) {
+    queue_record record = {
+        .timestamp = TEST_EPOCH + i * 3600,
+        .moisture = (i * 731) % 10000,
+        .sensor_id = i % 4
+    };
+
+    return record;
+}
+
+static void push_pages(int first, int count) {
+    // One record per page
+    for (int i = first; i < first + count; i++) {
+        queue_record record = make_record(i);
+        CHECK(queue_push(&record) == 0);
+        CHECK(queue_flush() == 0);
+    }
+}
+
+static int pop_next(void) {
+    // Record of the oldest page, -1 if none
+    queue_record records[QUEUE_PAGE_RECORDS];
+    int count = queue_peek(records, QUEUE_PAGE_RECORDS);
+    if (count != 1 || queue_pop() != 0) {
+        return -1;
+    }
+
+    int i = (records[0].timestamp - TEST_EPOCH) / 3600;
+    queue_record expected = make_record(i);
+    CHECK(records[0].moisture == expected.moisture);
+    CHECK(records[0].sensor_id == expected.sensor_id);
+
+    return i;
+}
+
+static void clear_bit(uint32_t offset) {
+    uint8_t byte;
+    esp_partition_read(partition, offset, &byte, 1);
+    while (byte == 0) {
+        esp_partition_read(partition, ++offset, &byte, 1);
+    }
+    byte &= byte - 1;
+    esp_partition_write(partition, offset, &byte, 1);
+}
+
+static void test_restart_recovery(void) {
+    erase_all();
+    push_pages(0, 5);
+    CHECK(pop_next() == 0);
+    CHECK(pop_next() == 1);
+
+    // Records buffered in RAM are lost, flushed pages are not
+    queue_record record = make_record(5);
+    CHECK(queue_push(&record) == 0);
+    CHECK(restart() == 0);
+    CHECK(queue_backlog() == 3);
+    CHECK(pop_next() == 2);
+
+    CHECK(restart() == 0);
+    CHECK(queue_backlog() == 2);
+    CHECK(pop_next() == 3);
+    CHECK(pop_next() == 4);
+    CHECK(pop_next() == -1);
+}
+
+static void test_checksum(void) {
+    erase_all();
+    push_pages(0, 4);
+
+    // Page in flash is corrupted after it was written
+    clear_bit(1 * QUEUE_PAGE_SIZE + 8);
+    CHECK(pop_next() == 0);
+    CHECK(pop_next() == 2);
+
+    // Corrupted pages are left out of the backlog on recovery
+    clear_bit(3 * QUEUE_PAGE_SIZE + QUEUE_PAGE_SIZE - 1);
+    push_pages(4, 1);
+    CHECK(restart() == 0);
+    CHECK(queue_backlog() == 1);
+    CHECK(pop_next() == 4);
+    CHECK(pop_next() == -1);
+}
+
+static void test_wrap(void) {
+    erase_all();
+    push_pages(0, RING_PAGES);
+    CHECK(queue_backlog() == RING_PAGES);
+    CHECK(queue_dropped() == 0);
+
+    // Entering the first sector again overwrites its pending pages
+    push_pages(RING_PAGES, 8);
+    CHECK(queue_dropped() == SECTOR_PAGES);
+    CHECK(queue_backlog() == RING_PAGES - SECTOR_PAGES + 8);
+
+    // Rest of the sector was erased
+    uint8_t page[QUEUE_PAGE_SIZE];
+    uint8_t erased[QUEUE_PAGE_SIZE];
+    memset(erased, 0xFF, sizeof(erased));
+    esp_partition_read(partition, 8 * QUEUE_PAGE_SIZE, page, sizeof(page));
+    CHECK(memcmp(page, erased, sizeof(page)) == 0);
+
+    // Oldest page is found in the second sector after a restart
+    CHECK(restart() == 0);
+    CHECK(queue_backlog() == RING_PAGES - SECTOR_PAGES + 8);
+    int expected = SECTOR_PAGES;
+    int i;
+    while ((i = pop_next()) != -1) {
+        CHECK(i == expected);
+        expected++;
+    }
+    CHECK(expected == RING_PAGES + 8);
+}
+
+static void test_failed_write(void) {
+    erase_all();
+    push_pages(0, 1);
+
+    // Page slot is retired and the record kept for the next flush
+    queue_record record = make_record(1);
+    CHECK(queue_push(&record) == 0);
+    failing_writes = 1;
+    CHECK(queue_flush() == -1);
+    CHECK(queue_flush() == 0);
+    push_pages(2, 1);
+    CHECK(queue_backlog() == 3);
+
+    // Pending pages on both sides of the retired one are recovered
+    CHECK(restart() == 0);
+    CHECK(queue_backlog() == 3);
+    CHECK(pop_next() == 0);
+    CHECK(pop_next() == 1);
+
+    // Failed pop leaves the page to be sent again
+    queue_record records[QUEUE_PAGE_RECORDS];
+    CHECK(queue_peek(records, QUEUE_PAGE_RECORDS) == 1);
+    failing_writes = 1;
+    CHECK(queue_pop() == -1);
+    CHECK(queue_backlog() == 1);
+    CHECK(pop_next() == 2);
+    CHECK(queue_backlog() == 0);
+}
+
+int main(int argc, char** argv) {
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        printf("ERROR creating partition file.\n");
+        return 1;
+    }
+    close(fd);
+
+    if (restart() != 0) {
+        printf("ERROR setting up partition.\n");
+        unlink(path);
+        return 1;
+    }
+
+    test_restart_recovery();
+    test_checksum();
+    test_wrap();
+    test_failed_write();
+    unlink(path);
+
+    return check_result("offline_queue");
+}
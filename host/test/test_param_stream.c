@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "host.h"
+#include "param_stream.h"
+#include "planter_utils.h"
+#include "wifi_manager.h"
+
+#define TEST_EPOCH 1754805600
+
+// First delay between reconnection attempts (in ms)
+#define FIRST_RETRY 5000
+
+// Time to open a stream on top of the retry delay (in ms)
+#define OPEN_SLACK 1500
+
+#define MAX_OPENS 32
+
+static int refused = 0;         // Stream requests left to refuse
+static int64_t opens[MAX_OPENS];
+static int num_opens = 0;
+static bool finished = false;
+
+static void http_handler(const host_http_request* request,
+    host_http_response* response, void* ctx) {
+        if (request->event_stream) {
+            if (num_opens < MAX_OPENS) {
+                opens[num_opens++] = host_time_us() / 1000;
+            }
+            if (refused > 0) {
+                refused--;
+                response->status = 503;
+                return;
+            }
+        }
+        host_firebase_handler(request, response, NULL);
+}
+
+static bool wait_connected(bool state, int timeout_s) {
+    for (int i = 0; i < timeout_s * 10; i++) {
+        if (param_stream_connected() == state) {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+
+    return param_stream_connected() == state;
+}
+
+static void check_backoff(int64_t end, const int64_t* times, int count) {
+    // Delay doubles from FIRST_RETRY after the stream ended, up to
+    // STREAM_RETRY_MAX
+    int delay = FIRST_RETRY;
+    for (int i = 0; i < count; i++) {
+        int64_t gap = times[i] - (i == 0 ? end : times[i - 1]);
+        CHECK(gap >= delay && gap <= delay + OPEN_SLACK);
+        delay = delay * 2 < STREAM_RETRY_MAX ? delay * 2 : STREAM_RETRY_MAX;
+    }
+}
+
+static void test_main(void) {
+    CHECK(init_wifi() == 0);
+
+    // Server refuses the first attempts
+    refused = 4;
+    xTaskCreate(param_stream_task, "ParamStreamTask", 6144, NULL, 5, NULL);
+    CHECK(wait_connected(true, 120));
+    CHECK(num_opens == 5);
+    check_backoff(opens[0], opens + 1, 4);
+
+    // Changes arrive as stream events
+    host_firebase_set_params(
+        "{\"Water_Duration_Set\": 90, \"Water_Times_Set\": [7, 19]}");
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    CHECK(water_duration == 90);
+    CHECK(num_watering_times == 2);
+    CHECK(watering_times[0] == 7 && watering_times[1] == 19);
+
+    // Server cancels the stream, delays start over and stop growing at the
+    // longest delay
+    int first = num_opens;
+    refused = 8;
+    const char* cancel = "event: cancel\ndata: null\n\n";
+    int64_t cancel_ms = host_time_us() / 1000;
+    host_http_stream_send(cancel, strlen(cancel));
+    CHECK(wait_connected(false, 1));
+    CHECK(wait_connected(true, 1500));
+    CHECK(num_opens == first + 9);
+    check_backoff(cancel_ms, opens + first, 9);
+
+    // Stream drops with WiFi and comes back once it does
+    host_wifi_set_available(false);
+    CHECK(wait_connected(false, 1));
+    vTaskDelay(pdMS_TO_TICKS(20000));
+    host_wifi_set_available(true);
+    CHECK(check_wifi() >= 0);
+    CHECK(wait_connected(true, 60));
+
+    // Moisture band set through the stream
+    host_firebase_set_params(
+        "{\"Moisture_Low_Set\": 35, \"Moisture_High_Set\": 55}");
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    CHECK(moisture_low == 35 && moisture_high == 55);
+    CHECK(parameter_comms() == 0);
+    CHECK(moisture_low == 35 && moisture_high == 55);
+
+    // Null bound is deleted from the table, a poll turns the band off
+    host_firebase_set_params(
+        "{\"Moisture_Low_Set\": null, \"Moisture_High_Set\": 55}");
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    CHECK(parameter_comms() == 0);
+    CHECK(moisture_low == 0 && moisture_high == 0);
+
+    // Durations past MAX_WATER_DURATION, or past the int range, are ignored
+    host_firebase_set_params("{\"Water_Duration_Set\": 99999999999}");
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    CHECK(water_duration == 90);
+    host_firebase_set_params("{\"Water_Duration_Set\": 86401}");
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    CHECK(parameter_comms() == 0);
+    CHECK(water_duration == 90);
+    host_firebase_set_params("{\"Water_Duration_Set\": 86400}");
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    CHECK(water_duration == 86400);
+
+    finished = true;
+    host_stop("param_stream done");
+    vTaskDelay(portMAX_DELAY);
+}
+
+int main(int argc, char** argv) {
+    host_clock_init(TEST_EPOCH, 0);
+    host_http_set_handler(http_handler, NULL);
+    host_run(test_main, (int64_t)2 * 3600 * 1000000);
+    CHECK(finished);
+
+    return check_result("param_stream");
+}
@@ -0,0 +1,82 @@
+#include <sys/time.h>
+
+#include "check.h"
+#include "host.h"
+#include "scheduler.h"
+
+#define TEST_EPOCH 1754805600
+
+#define HOUR 3600
+
+static int reports = 0;
+static time_t report_times[16];
+static bool finished = false;
+
+static void report_task(void* pvParameters) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (reports < 16) {
+            report_times[reports] = time(NULL);
+        }
+        reports++;
+    }
+}
+
+static void set_clock(time_t when) {
+    struct timeval tv = {
+        .tv_sec = when
+    };
+    settimeofday(&tv, NULL);
+    scheduler_recompute();
+}
+
+static void wait_s(int seconds) {
+    vTaskDelay(pdMS_TO_TICKS(seconds * 1000));
+}
+
+static void test_main(void) {
+    // Hourly reports, 06:30 at start
+    TaskHandle_t report_handle = NULL;
+    xTaskCreate(report_task, "ReportTask", 2048, NULL, 5, &report_handle);
+    sched_config config = {
+        .report_task = report_handle,
+        .report_interval = HOUR
+    };
+    set_clock(TEST_EPOCH + HOUR / 2);
+    CHECK(scheduler_start(&config) == 0);
+    wait_s(HOUR / 2 + 60);
+    CHECK(reports == 1);
+    CHECK(report_times[0] == TEST_EPOCH + HOUR);
+
+    // Clock steps forward over 08:00 and 09:00, the report runs once
+    set_clock(TEST_EPOCH + 3 * HOUR + HOUR / 2);
+    wait_s(60);
+    CHECK(reports == 2);
+
+    // Clock steps back before 09:00, no report until 10:00
+    set_clock(TEST_EPOCH + 2 * HOUR + 3 * HOUR / 4);
+    wait_s(HOUR);
+    CHECK(reports == 2);
+    wait_s(HOUR / 4 + 60);
+    CHECK(reports == 3);
+    CHECK(report_times[2] == TEST_EPOCH + 4 * HOUR);
+
+    // Steps larger than SCHED_MAX_STEP start over from the new time
+    set_clock(TEST_EPOCH + 4 * HOUR + SCHED_MAX_STEP + HOUR + HOUR / 2);
+    wait_s(60);
+    CHECK(reports == 3);
+    wait_s(HOUR / 2);
+    CHECK(reports == 4);
+
+    finished = true;
+    host_stop("scheduler done");
+    vTaskDelay(portMAX_DELAY);
+}
+
+int main(int argc, char** argv) {
+    host_clock_init(TEST_EPOCH, 0);
+    host_run(test_main, (int64_t)12 * HOUR * 1000000);
+    CHECK(finished);
+
+    return check_result("scheduler");
+}
@@ -0,0 +1,205 @@
+#include <stdio.h>
+
+#include "check.h"
+#include "host.h"
+#include "sensor.h"
+
+#define TEST_EPOCH 1754805600
+
+#define MAX_SENSORS (SOC_ADC_PATT_LEN_MAX + 1)
+
+// Largest 12-bit reading
+#define ADC_RAW_MAX 4095
+
+// Allowed gap to the double precision map(), 0.1% in hundredths of a percent
+#define MAP_TOLERANCE 10
+
+// Slow conversions of ADC2, as while WiFi holds it (in ms)
+#define ADC2_WAIT_MS 100
+
+/**
+ * @brief Read of a sensor from its own task
+ *
+ */
+typedef struct {
+    sensor* sens;
+    int result;
+    int64_t done_us;            // Time the read returned
+} shared_read;
+
+static sensor sensors[MAX_SENSORS];
+static adc_reader* shared_reader = NULL;
+static int conversions = 0;
+static shared_read reads[2];
+static int shared_done = 0;
+static bool finished = false;
+
+static void init_sensors(adc_unit_t unit) {
+    for (int i = 0; i < MAX_SENSORS; i++) {
+        snprintf(sensors[i].name, sizeof(sensors[i].name), "SENSOR_%d", i + 1);
+        sensors[i].unit = unit;
+        sensors[i].channel = i % ADC_MAX_CHANNELS;
+        sensors[i].mean_dry = 2712;
+        sensors[i].mean_wet = 970;
+        sensors[i].filter = (sens_filter){ .config = { .oversample = 4,
+            .median = 5, .ema_shift = 2 } };
+        host_adc_set_level(unit, sensors[i].channel,
+            1000 + 170 * (int)sensors[i].channel);
+    }
+}
+
+static double double_map(const sensor* sens, double val) {
+    // map() before the fixed-point scale, as a fraction
+    double mapped_val = (val - sens->mean_dry) /
+        (sens->mean_wet - sens->mean_dry);
+    if (mapped_val < 0) {
+        mapped_val = 0.00;
+    }
+    else if (mapped_val > 1) {
+        mapped_val = 1.00;
+    }
+
+    return mapped_val;
+}
+
+static void test_map(void) {
+    // Usual probe, inverted probe, full range and very narrow spans
+    static const int calibrations[][2] = {
+        { 2712, 970 }, { 970, 2712 }, { 4095, 0 }, { 2000, 1990 },
+        { 3000, 2999 }, { 1, 4094 }
+    };
+    int n = sizeof(calibrations) / sizeof(calibrations[0]);
+
+    for (int i = 0; i < n; i++) {
+        sensor sens = {0};
+        sens_set_calibration(&sens, calibrations[i][0], calibrations[i][1]);
+        int worst = 0;
+        for (int raw = 0; raw <= ADC_RAW_MAX; raw++) {
+            int expected = (int)(double_map(&sens, raw) * 10000 + 0.5);
+            int gap = map(&sens, raw) - expected;
+            if (gap < 0) {
+                gap = -gap;
+            }
+            if (gap > worst) {
+                worst = gap;
+            }
+        }
+        CHECK(worst <= MAP_TOLERANCE);
+    }
+}
+
+static void test_pattern_limit(void) {
+    // Every sensor has a place in the scan pattern or none is read
+    init_sensors(ADC_UNIT_1);
+    CHECK(init_adc(sensors, SOC_ADC_PATT_LEN_MAX + 1,
+        SENS_MODE_CONTINUOUS) == NULL);
+
+    adc_reader* reader = init_adc(sensors, SOC_ADC_PATT_LEN_MAX,
+        SENS_MODE_CONTINUOUS);
+    CHECK(reader != NULL);
+
+    // No data before the first frame, not a fully wet reading
+    CHECK(read_filtered(reader, &sensors[0]) == -1);
+    CHECK(sens_read_moisture(reader, &sensors[0]) == -1);
+
+    vTaskDelay(pdMS_TO_TICKS(500));
+    for (int i = 0; i < SOC_ADC_PATT_LEN_MAX; i++) {
+        CHECK(read_sens(reader, sensors[i].unit, sensors[i].channel) ==
+            1000 + 170 * (int)sensors[i].channel);
+        CHECK(sens_read_moisture(reader, &sensors[i]) ==
+            map(&sensors[i], read_filtered(reader, &sensors[i])));
+    }
+}
+
+static int ramp_source(adc_unit_t unit, adc_channel_t channel, void* ctx) {
+    // Every conversion takes a tick, so another task can run in between
+    vTaskDelay(1);
+
+    return 1000 + 10 * conversions++;
+}
+
+static int slow_adc2_source(adc_unit_t unit, adc_channel_t channel,
+    void* ctx) {
+        if (unit == ADC_UNIT_2) {
+            vTaskDelay(pdMS_TO_TICKS(ADC2_WAIT_MS));
+        }
+
+        return 1000 + 170 * (int)channel;
+}
+
+static void shared_read_task(void* pvParameters) {
+    shared_read* read = pvParameters;
+    read->result = read_filtered(shared_reader, read->sens);
+    read->done_us = host_time_us();
+    shared_done++;
+    vTaskDelete(NULL);
+}
+
+static void read_both(sensor* first, sensor* second) {
+    reads[0] = (shared_read){ .sens = first };
+    reads[1] = (shared_read){ .sens = second };
+    shared_done = 0;
+    xTaskCreate(shared_read_task, "ValveTask", 4096, &reads[0], 5, NULL);
+    xTaskCreate(shared_read_task, "ReportTask", 4096, &reads[1], 5, NULL);
+    while (shared_done < 2) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+static void test_shared_reader(void) {
+    // Valve task and report task read the same sensor
+    init_sensors(ADC_UNIT_1);
+    sensors[1].unit = ADC_UNIT_2;
+    shared_reader = init_adc(sensors, 2, SENS_MODE_ONESHOT);
+    CHECK(shared_reader != NULL);
+    host_adc_set_source(ramp_source, NULL);
+    read_both(&sensors[0], &sensors[0]);
+
+    // Each gets the output of a whole burst of its own
+    sens_filter filter = { .config = sensors[0].filter.config };
+    int burst = filter_burst_len(&filter);
+    for (int i = 0; i < 2; i++) {
+        filter_reset(&filter);
+        for (int j = 0; j < burst; j++) {
+            filter_push(&filter, 1000 + 10 * (i * burst + j));
+        }
+        CHECK(reads[i].result == filter.output);
+    }
+
+    // ADC1 is read while an ADC2 read waits
+    host_adc_set_source(slow_adc2_source, NULL);
+    int64_t start = host_time_us();
+    read_both(&sensors[1], &sensors[0]);
+    host_adc_set_source(NULL, NULL);
+    CHECK(reads[0].result >= 0 && reads[1].result >= 0);
+    CHECK(reads[1].done_us - start < ADC2_WAIT_MS * 1000);
+    CHECK(reads[0].done_us - start >= burst * ADC2_WAIT_MS * 1000);
+}
+
+static void test_continuous_adc2(void) {
+    // WiFi would take ADC2 from under the scan
+    init_sensors(ADC_UNIT_2);
+    CHECK(init_adc(sensors, 2, SENS_MODE_CONTINUOUS) == NULL);
+    init_sensors(ADC_UNIT_1);
+    sensors[1].unit = ADC_UNIT_2;
+    CHECK(init_adc(sensors, 2, SENS_MODE_CONTINUOUS) == NULL);
+}
+
+static void test_main(void) {
+    test_map();
+    test_shared_reader();
+    test_continuous_adc2();
+    test_pattern_limit();
+
+    finished = true;
+    host_stop("sensor done");
+    vTaskDelay(portMAX_DELAY);
+}
+
+int main(int argc, char** argv) {
+    host_clock_init(TEST_EPOCH, 0);
+    host_run(test_main, (int64_t)60 * 1000000);
+    CHECK(finished);
+
+    return check_result("sensor");
+}
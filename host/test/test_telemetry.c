@@ -0,0 +1,69 @@
+#include <string.h>
+
+#include "check.h"
+#include "telemetry.h"
+
+#define TEST_EPOCH 1754805600
+
+#define NUM_RECORDS 64
+
+static telemetry_record make_record(int i) {
+    // Readings of a cycle share a time, a late one is a little behind
+    telemetry_record record = {
+        .timestamp = TEST_EPOCH + (i / 4) * 3600 - (i % 7 == 6 ? 5 : 0),
+        .moisture = (i * 731) % 10001,
+        .sensor_id = i % 4
+    };
+
+    return record;
+}
+
+static void test_round_trip(void) {
+    uint8_t buffer[TELEMETRY_HEADER_SIZE + NUM_RECORDS * TELEMETRY_RECORD_MAX];
+    telemetry_packer packer;
+    pack_init(&packer, buffer, sizeof(buffer));
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        telemetry_record record = make_record(i);
+        CHECK(pack_record(&packer, &record) == 0);
+    }
+    CHECK(packer.count == NUM_RECORDS);
+
+    telemetry_record records[NUM_RECORDS];
+    CHECK(unpack_records(buffer, packer.len, records, NUM_RECORDS) ==
+        NUM_RECORDS);
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        telemetry_record expected = make_record(i);
+        CHECK(records[i].timestamp == expected.timestamp);
+        CHECK(records[i].moisture == expected.moisture);
+        CHECK(records[i].sensor_id == expected.sensor_id);
+    }
+
+    // Cut inside the last reading
+    CHECK(unpack_records(buffer, packer.len - 1, records, NUM_RECORDS) == -1);
+}
+
+static void test_full(void) {
+    // Header and first reading do not fit
+    uint8_t buffer[TELEMETRY_HEADER_SIZE + TELEMETRY_RECORD_MIN];
+    telemetry_packer packer;
+    pack_init(&packer, buffer, TELEMETRY_HEADER_SIZE);
+    telemetry_packer before = packer;
+    telemetry_record record = make_record(0);
+    CHECK(pack_record(&packer, &record) == -1);
+    CHECK(memcmp(&packer, &before, sizeof(packer)) == 0);
+
+    // Later readings that do not fit leave the stream as it was
+    pack_init(&packer, buffer, sizeof(buffer));
+    CHECK(pack_record(&packer, &record) == 0);
+    before = packer;
+    record = make_record(4);
+    CHECK(pack_record(&packer, &record) == -1);
+    CHECK(memcmp(&packer, &before, sizeof(packer)) == 0);
+}
+
+int main(int argc, char** argv) {
+    test_round_trip();
+    test_full();
+
+    return check_result("telemetry");
+}
@@ -0,0 +1,56 @@
+#include "check.h"
+#include "host.h"
+#include "thermal.h"
+
+#define TEST_EPOCH 1754805600
+
+static bool finished = false;
+
+static void sample_at(float celsius) {
+    host_set_chip_temperature(celsius);
+    CHECK(thermal_sample() == 0);
+}
+
+static void test_restore(void) {
+    CHECK(thermal_init() == 0);
+    sample_at(30.0f);
+    sample_at(40.0f);
+
+    // Upload failed, the window is put back and keeps collecting
+    thermal_window failed = thermal_take_window();
+    CHECK(failed.count == 2);
+    CHECK(thermal_take_window().count == 0);
+    sample_at(20.0f);
+    sample_at(50.0f);
+    thermal_restore_window(&failed);
+
+    thermal_window window = thermal_take_window();
+    CHECK(window.count == 4);
+    CHECK(window.min == 20.0f && window.max == 50.0f);
+    CHECK(window.avg == 35.0f);
+    CHECK(thermal_take_window().count == 0);
+
+    // Into an empty window as well
+    sample_at(25.0f);
+    failed = thermal_take_window();
+    thermal_restore_window(&failed);
+    window = thermal_take_window();
+    CHECK(window.count == 1);
+    CHECK(window.min == 25.0f && window.max == 25.0f && window.avg == 25.0f);
+}
+
+static void test_main(void) {
+    test_restore();
+
+    finished = true;
+    host_stop("thermal done");
+    vTaskDelay(portMAX_DELAY);
+}
+
+int main(int argc, char** argv) {
+    host_clock_init(TEST_EPOCH, 0);
+    host_run(test_main, (int64_t)60 * 1000000);
+    CHECK(finished);
+
+    return check_result("thermal");
+}
@@ -0,0 +1,82 @@
+#include <sys/time.h>
+
+#include "check.h"
+#include "esp_sntp.h"
+#include "host.h"
+#include "time_sync.h"
+#include "wifi_manager.h"
+
+#define TEST_EPOCH 1754805600
+
+// Device clock runs fast by this much (in ppm), measured as -TEST_DRIFT
+#define TEST_DRIFT 200
+
+#define HOUR 3600
+
+static bool finished = false;
+
+static int64_t clock_error_ms(void) {
+    // Device clock against the time SNTP answers with
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t device = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    int64_t reference = (int64_t)TEST_EPOCH * 1000 + host_time_us() / 1000;
+
+    return device - reference;
+}
+
+static int64_t abs_ms(int64_t ms) {
+    return ms < 0 ? -ms : ms;
+}
+
+static void wait_s(int seconds) {
+    vTaskDelay(pdMS_TO_TICKS(seconds * 1000));
+}
+
+static void test_main(void) {
+    // Clock reads 1970 after a power loss with nothing saved
+    CHECK(time_restore() == -1);
+    CHECK(time_needs_sync(HOUR));
+    CHECK(init_wifi() == 0);
+
+    // Returns on the first response and steps the clock to it
+    int64_t start = host_time_us();
+    CHECK(calibrate_time() == 0);
+    CHECK(host_time_us() - start < (int64_t)HOST_SNTP_MS * 2000);
+    CHECK(abs_ms(clock_error_ms()) <= 1);
+    CHECK(get_time_status().synced);
+    CHECK(!time_needs_sync(HOUR));
+
+    // Background syncs measure the drift, the first only sets the clock
+    wait_s(2 * TIME_SYNC_INTERVAL / 1000 + 60);
+    time_status status = get_time_status();
+    CHECK(status.drift_ppm <= -TEST_DRIFT + 2 &&
+        status.drift_ppm >= -TEST_DRIFT - 2);
+    CHECK(abs_ms(clock_error_ms()) < 100);
+
+    // Without syncs, e.g. across deep sleep, the drift is removed on restore
+    esp_sntp_stop();
+    wait_s(4 * HOUR);
+    CHECK(clock_error_ms() > 4 * HOUR * TEST_DRIFT / 1000 - 100);
+    CHECK(time_needs_sync(HOUR));
+    CHECK(time_restore() == 0);
+    CHECK(abs_ms(clock_error_ms()) < 50);
+
+    // Restarting the client brings the clock back to the server time
+    wait_s(HOUR);
+    CHECK(calibrate_time() == 0);
+    CHECK(abs_ms(clock_error_ms()) <= 1);
+    CHECK(!time_needs_sync(HOUR));
+
+    finished = true;
+    host_stop("time_sync done");
+    vTaskDelay(portMAX_DELAY);
+}
+
+int main(int argc, char** argv) {
+    host_clock_init(TEST_EPOCH, TEST_DRIFT);
+    host_run(test_main, (int64_t)24 * HOUR * 1000000);
+    CHECK(finished);
+
+    return check_result("time_sync");
+}
@@ -0,0 +1,83 @@
+#include "filter.h"
+
+#include <string.h>
+
+void filter_reset(sens_filter* filter) {
+    filter_config config = filter->config;
+    memset(filter, 0, sizeof(sens_filter));
+    filter->config = config;
+    filter->output = -1;
+}
+
+static int median_of(const sens_filter* filter) {
+    // Insertion sort of a copy, window is at most 9 samples
+    uint16_t sorted[FILTER_MEDIAN_MAX];
+    int len = filter->win_len;
+    for (int i = 0; i < len; i++) {
+        uint16_t value = filter->window[i];
+        int j = i;
+        while (j > 0 && sorted[j-1] > value) {
+            sorted[j] = sorted[j-1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+
+    return sorted[len / 2];
+}
+
+int filter_push(sens_filter* filter, int raw) {
+    const filter_config* config = &filter->config;
+
+    // Oversampling
+    if (config->oversample > 1) {
+        filter->os_sum += raw;
+        filter->os_count++;
+        if (filter->os_count < config->oversample) {
+            return 0;
+        }
+        raw = filter->os_sum / filter->os_count;
+        filter->os_sum = 0;
+        filter->os_count = 0;
+    }
+
+    // Median of last N samples
+    int median_len = config->median;
+    if (median_len > FILTER_MEDIAN_MAX) {
+        median_len = FILTER_MEDIAN_MAX;
+    }
+    if (median_len > 1) {
+        filter->window[filter->win_pos] = (uint16_t)raw;
+        filter->win_pos = (filter->win_pos + 1) % median_len;
+        if (filter->win_len < median_len) {
+            filter->win_len++;
+        }
+        raw = median_of(filter);
+    }
+
+    // Exponential moving average in Q8
+    if (config->ema_shift > 0) {
+        if (!filter->ema_ready) {
+            filter->ema = raw << 8;
+            filter->ema_ready = true;
+        }
+        else {
+            filter->ema += ((raw << 8) - filter->ema) >> config->ema_shift;
+        }
+        raw = (filter->ema + 128) >> 8;
+    }
+
+    filter->output = raw;
+    return 1;
+}
+
+int filter_burst_len(const sens_filter* filter) {
+    int oversample = filter->config.oversample > 1 ? 
+        filter->config.oversample : 1;
+    int median = filter->config.median > 1 ? filter->config.median : 1;
+    if (median > FILTER_MEDIAN_MAX) {
+        median = FILTER_MEDIAN_MAX;
+    }
+
+    return oversample * median;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file filter.h
+ * @brief Fixed-point digital filters for ADC readings
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ * 
+ * @details Provides a per-channel filter stage between ADC acquisition and
+ * map(). Raw counts pass through oversampling, a median-of-N window and an
+ * exponential moving average. All kernels use integer math only.
+ * 
+ */
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @def FILTER_MEDIAN_MAX
+ * @brief Longest median window
+ * 
+ */
+#define FILTER_MEDIAN_MAX 9
+
+/**
+ * @brief Filter settings of one channel
+ * 
+ * A value of 0 turns a stage off.
+ * 
+ */
+typedef struct {
+    uint8_t oversample;         /**< Raw samples averaged per filtered sample */
+    uint8_t median;             /**< Median window length (odd, max 9) */
+    uint8_t ema_shift;          /**< EMA weight of new samples is 1/2^shift */
+} filter_config;
+
+/**
+ * @brief Filter state of one channel
+ * 
+ */
+typedef struct {
+    filter_config config;       /**< Filter settings */
+    int32_t os_sum;             /**< Sum of samples in oversampling stage */
+    uint8_t os_count;           /**< Samples in oversampling stage */
+    uint16_t window[FILTER_MEDIAN_MAX]; /**< Median window (ring) */
+    uint8_t win_len;            /**< Samples in median window */
+    uint8_t win_pos;            /**< Next write position in median window */
+    int32_t ema;                /**< EMA state in Q8 fixed point */
+    bool ema_ready;             /**< EMA seeded with first sample */
+    volatile int32_t output;    /**< Latest filtered value, -1 if none */
+} sens_filter;
+
+/**
+ * @brief Reset filter state
+ * 
+ * Settings in filter->config are kept.
+ * 
+ * @param[in, out] filter Filter state
+ * 
+ */
+void filter_reset(sens_filter* filter);
+
+/**
+ * @brief Add a raw sample to the filter
+ * 
+ * @param[in, out] filter Filter state
+ * @param[in] raw Raw ADC reading
+ * 
+ * @retval 1 New filtered value available
+ * @retval 0 Sample buffered in oversampling stage
+ * 
+ */
+int filter_push(sens_filter* filter, int raw);
+
+/**
+ * @brief Number of raw samples needed to fill the filter
+ * 
+ * @param[in] filter Filter state
+ * 
+ * @return Oversampling times median window length
+ * 
+ */
+int filter_burst_len(const sens_filter* filter);
+
+#endif
@@ -0,0 +1,244 @@
+#include "gzip_stream.h"
+
+#include <string.h>
+
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+#define END_OF_BLOCK 256
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+    67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5,
+    5, 5, 5, 0
+};
+
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+    769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+    11, 11, 12, 12, 13, 13
+};
+
+static void flush_out(gzip_stream* stream) {
+    if (stream->out_len > 0 && !stream->error &&
+        stream->output(stream->out, stream->out_len, stream->ctx) != 0) {
+            stream->error = true;
+    }
+    stream->out_len = 0;
+}
+
+static void put_byte(gzip_stream* stream, uint8_t byte) {
+    stream->out[stream->out_len++] = byte;
+    if (stream->out_len == GZIP_OUT_SIZE) {
+        flush_out(stream);
+    }
+}
+
+static void put_bits(gzip_stream* stream, uint32_t value, int count) {
+    // Deflate packs bits starting from the least significant
+    stream->bits |= value << stream->bit_count;
+    stream->bit_count += count;
+    while (stream->bit_count >= 8) {
+        put_byte(stream, (uint8_t)stream->bits);
+        stream->bits >>= 8;
+        stream->bit_count -= 8;
+    }
+}
+
+static void put_code(gzip_stream* stream, uint32_t code, int len) {
+    // Huffman codes are packed starting from the most significant bit
+    uint32_t reversed = 0;
+    for (int i = 0; i < len; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    put_bits(stream, reversed, len);
+}
+
+static void put_symbol(gzip_stream* stream, int symbol) {
+    // Static Huffman code (RFC 1951 section 3.2.6)
+    if (symbol < 144) {
+        put_code(stream, 0x30 + symbol, 8);
+    }
+    else if (symbol < 256) {
+        put_code(stream, 0x190 + symbol - 144, 9);
+    }
+    else if (symbol < 280) {
+        put_code(stream, symbol - 256, 7);
+    }
+    else {
+        put_code(stream, 0xC0 + symbol - 280, 8);
+    }
+}
+
+static void put_match(gzip_stream* stream, int len, int dist) {
+    int code = 28;
+    while (length_base[code] > len) {
+        code--;
+    }
+    put_symbol(stream, 257 + code);
+    put_bits(stream, len - length_base[code], length_extra[code]);
+
+    code = 29;
+    while (dist_base[code] > dist) {
+        code--;
+    }
+    put_code(stream, code, 5);
+    put_bits(stream, dist - dist_base[code], dist_extra[code]);
+}
+
+static void put_le32(gzip_stream* stream, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        put_byte(stream, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, int len) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190,
+        0x6B6B51F4, 0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344,
+        0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278,
+        0xBDBDF21C
+    };
+
+    crc = ~crc;
+    for (int i = 0; i < len; i++) {
+        crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+
+    return ~crc;
+}
+
+static int hash(const uint8_t* data) {
+    uint32_t key = (data[0] << 16) | (data[1] << 8) | data[2];
+    return (key * 2654435761u) >> (32 - GZIP_HASH_BITS);
+}
+
+static void compress(gzip_stream* stream, bool finish) {
+    // Keep enough lookahead for a full match until the last chunk
+    int end = finish ? stream->fill : stream->fill - MAX_MATCH;
+
+    while (stream->pos < end) {
+        int pos = stream->pos;
+        int len = 0;
+        int dist = 0;
+
+        if (pos + MIN_MATCH <= stream->fill) {
+            int h = hash(stream->window + pos);
+            int candidate = stream->head[h];
+            stream->head[h] = pos;
+
+            if (candidate >= 0) {
+                int max = stream->fill - pos;
+                if (max > MAX_MATCH) {
+                    max = MAX_MATCH;
+                }
+                while (len < max &&
+                    stream->window[candidate + len] == stream->window[pos + len]) {
+                        len++;
+                }
+                dist = pos - candidate;
+            }
+        }
+
+        if (len < MIN_MATCH) {
+            put_symbol(stream, stream->window[pos]);
+            stream->pos++;
+            continue;
+        }
+
+        put_match(stream, len, dist);
+
+        // Matched bytes can start later matches
+        for (int i = 1; i < len && pos + i + MIN_MATCH <= stream->fill; i++) {
+            stream->head[hash(stream->window + pos + i)] = pos + i;
+        }
+        stream->pos += len;
+    }
+}
+
+static void slide(gzip_stream* stream) {
+    // Keep one window of history before the next byte to compress
+    int shift = stream->pos - GZIP_WINDOW;
+    if (shift <= 0) {
+        return;
+    }
+
+    memmove(stream->window, stream->window + shift, stream->fill - shift);
+    stream->fill -= shift;
+    stream->pos -= shift;
+    for (int i = 0; i < (1 << GZIP_HASH_BITS); i++) {
+        stream->head[i] = stream->head[i] >= shift ?
+            stream->head[i] - shift : -1;
+    }
+}
+
+void gzip_init(gzip_stream* stream, gzip_output output, void* ctx) {
+    memset(stream, 0, sizeof(gzip_stream));
+    memset(stream->head, 0xFF, sizeof(stream->head));
+    stream->output = output;
+    stream->ctx = ctx;
+
+    // Header: magic, deflate, no flags, no time, unknown OS
+    static const uint8_t header[10] = {
+        0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF
+    };
+    for (int i = 0; i < 10; i++) {
+        put_byte(stream, header[i]);
+    }
+
+    // All data goes in one static Huffman block, the final block is empty
+    put_bits(stream, 0, 1);
+    put_bits(stream, 1, 2);
+}
+
+int gzip_write(gzip_stream* stream, const void* data, int len) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    stream->crc = crc32_update(stream->crc, bytes, len);
+    stream->size += len;
+
+    while (len > 0 && !stream->error) {
+        int copy_len = (int)sizeof(stream->window) - stream->fill;
+        if (len < copy_len) {
+            copy_len = len;
+        }
+        memcpy(stream->window + stream->fill, bytes, copy_len);
+        stream->fill += copy_len;
+        bytes += copy_len;
+        len -= copy_len;
+
+        if (stream->fill == (int)sizeof(stream->window)) {
+            compress(stream, false);
+            slide(stream);
+        }
+    }
+
+    return stream->error ? -1 : 0;
+}
+
+int gzip_finish(gzip_stream* stream) {
+    compress(stream, true);
+    put_symbol(stream, END_OF_BLOCK);
+
+    put_bits(stream, 1, 1);
+    put_bits(stream, 1, 2);
+    put_symbol(stream, END_OF_BLOCK);
+
+    // Pad to a byte boundary
+    if (stream->bit_count > 0) {
+        put_bits(stream, 0, 8 - stream->bit_count);
+    }
+
+    put_le32(stream, stream->crc);
+    put_le32(stream, stream->size);
+    flush_out(stream);
+
+    return stream->error ? -1 : 0;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file gzip_stream.h
+ * @brief Incremental gzip compressor
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Compresses data written in chunks of any size into a gzip stream
+ * and hands the compressed bytes to a callback as soon as an output buffer
+ * fills, e.g. straight into an HTTP request body. Memory use is fixed no matter
+ * how much data is compressed: matches are only searched for within a small
+ * sliding window and the static Huffman codes are used, which works well for
+ * repetitive JSON.
+ *
+ */
+
+#ifndef GZIP_STREAM_H
+#define GZIP_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @def GZIP_WINDOW
+ * @brief Distance back that matches are searched for (in bytes)
+ *
+ */
+#define GZIP_WINDOW 1024
+
+/**
+ * @def GZIP_HASH_BITS
+ * @brief Size of the match hash table (log2 of entries)
+ *
+ */
+#define GZIP_HASH_BITS 10
+
+/**
+ * @def GZIP_OUT_SIZE
+ * @brief Size of the output buffer passed to the callback (in bytes)
+ *
+ */
+#define GZIP_OUT_SIZE 512
+
+/**
+ * @brief Consumer for compressed data
+ *
+ * @param[in] data Compressed bytes
+ * @param[in] len Length of data
+ * @param[in] ctx User context
+ *
+ * @retval 0 Data accepted
+ * @retval -1 Stop compressing
+ *
+ */
+typedef int (*gzip_output)(const uint8_t* data, int len, void* ctx);
+
+/**
+ * @brief Compressor state
+ *
+ * @note About 4.5 KB, allocate on the heap.
+ *
+ */
+typedef struct {
+    uint8_t window[2 * GZIP_WINDOW];    /**< History and data to compress */
+    int16_t head[1 << GZIP_HASH_BITS];  /**< Last window position per hash */
+    int fill;                           /**< Bytes in window */
+    int pos;                            /**< Next window byte to compress */
+    uint32_t bits;                      /**< Bits not yet written to out */
+    int bit_count;                      /**< Number of bits in bits */
+    uint8_t out[GZIP_OUT_SIZE];         /**< Compressed data not yet passed on */
+    int out_len;                        /**< Bytes in out */
+    uint32_t crc;                       /**< CRC-32 of uncompressed data */
+    uint32_t size;                      /**< Length of uncompressed data */
+    gzip_output output;                 /**< Compressed data consumer */
+    void* ctx;                          /**< User context for output */
+    bool error;                         /**< Output callback failed */
+} gzip_stream;
+
+/**
+ * @brief Initialize compressor and write the gzip header
+ *
+ * @param[out] stream Compressor state
+ * @param[in] output Compressed data consumer
+ * @param[in] ctx User context for output
+ *
+ */
+void gzip_init(gzip_stream* stream, gzip_output output, void* ctx);
+
+/**
+ * @brief Compress the next chunk of data
+ *
+ * @param[in, out] stream Compressor state
+ * @param[in] data Uncompressed data
+ * @param[in] len Length of data
+ *
+ * @retval 0 Success
+ * @retval -1 Output callback failed
+ *
+ */
+int gzip_write(gzip_stream* stream, const void* data, int len);
+
+/**
+ * @brief Compress remaining data and write the gzip trailer
+ *
+ * @param[in, out] stream Compressor state
+ *
+ * @retval 0 Success
+ * @retval -1 Output callback failed
+ *
+ */
+int gzip_finish(gzip_stream* stream);
+
+#endif
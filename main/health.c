@@ -0,0 +1,384 @@
+#include "health.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "offline_queue.h"
+#include "rest_api.h"
+#include "secrets.h"
+
+/**
+ * @brief CPU time of a task at the start of the report window
+ *
+ */
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t counter;
+} cpu_baseline;
+
+static SemaphoreHandle_t lock = NULL;
+static portMUX_TYPE http_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// HTTP counters since boot
+static uint32_t requests = 0;
+static uint32_t failures = 0;
+static uint32_t retries = 0;
+
+/**
+ * @brief HTTP timing in a report window
+ *
+ */
+typedef struct {
+    uint32_t requests;
+    uint32_t connects;
+    uint64_t connect_sum;
+    uint32_t first_bytes;
+    uint64_t first_byte_sum;
+    uint64_t total_sum;
+    uint32_t total_max;
+} http_window;
+
+static http_window window;
+static http_window taken;       // Window of the last reset, until published
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+static cpu_baseline baseline[HEALTH_MAX_TASKS];
+static int num_baseline = 0;
+static uint32_t baseline_total = 0;
+
+// Baseline before the last reset, until published
+static cpu_baseline taken_baseline[HEALTH_MAX_TASKS];
+static int num_taken_baseline = 0;
+static uint32_t taken_baseline_total = 0;
+#endif
+
+static bool published = false;
+static int64_t last_publish = 0;
+
+static void console_task(void* pvParameters) {
+    while (1) {
+        int c = getchar();
+        if (c == 'h' || c == 'H') {
+            health_print();
+        }
+        else if (c == EOF) {
+            // Console input does not block, so poll it
+            clearerr(stdin);
+            vTaskDelay(pdMS_TO_TICKS(250));
+        }
+    }
+}
+
+int health_init(void) {
+    if (lock != NULL) {
+        return 0;
+    }
+
+    lock = xSemaphoreCreateMutex();
+    if (lock == NULL) {
+        printf("ERROR creating health lock.\n");
+        return -1;
+    }
+
+    if (xTaskCreate(console_task, "HealthConsoleTask", 3072, NULL, 1,
+        NULL) != pdPASS) {
+            printf("ERROR starting health console task.\n");
+            return -1;
+    }
+
+    return 0;
+}
+
+void health_http_request(const http_timing* timing, bool ok) {
+    taskENTER_CRITICAL(&http_lock);
+    requests++;
+    if (!ok) {
+        failures++;
+    }
+    window.requests++;
+    if (timing->connect_ms > 0) {
+        window.connects++;
+        window.connect_sum += timing->connect_ms;
+    }
+    if (timing->first_byte_ms > 0) {
+        window.first_bytes++;
+        window.first_byte_sum += timing->first_byte_ms;
+    }
+    window.total_sum += timing->total_ms;
+    if (timing->total_ms > window.total_max) {
+        window.total_max = timing->total_ms;
+    }
+    taskEXIT_CRITICAL(&http_lock);
+}
+
+void health_http_retry(void) {
+    taskENTER_CRITICAL(&http_lock);
+    retries++;
+    taskEXIT_CRITICAL(&http_lock);
+}
+
+static void snapshot_http(http_health* http, bool reset) {
+    taskENTER_CRITICAL(&http_lock);
+    http->requests = requests;
+    http->failures = failures;
+    http->retries = retries;
+    http->connect_ms = window.connects > 0 ?
+        window.connect_sum / window.connects : 0;
+    http->first_byte_ms = window.first_bytes > 0 ?
+        window.first_byte_sum / window.first_bytes : 0;
+    http->total_ms = window.requests > 0 ?
+        window.total_sum / window.requests : 0;
+    http->total_max_ms = window.total_max;
+    if (reset) {
+        taken = window;
+        memset(&window, 0, sizeof(window));
+    }
+    taskEXIT_CRITICAL(&http_lock);
+}
+
+static void restore_http(void) {
+    // Requests since the reset stay in the window
+    taskENTER_CRITICAL(&http_lock);
+    window.requests += taken.requests;
+    window.connects += taken.connects;
+    window.connect_sum += taken.connect_sum;
+    window.first_bytes += taken.first_bytes;
+    window.first_byte_sum += taken.first_byte_sum;
+    window.total_sum += taken.total_sum;
+    if (taken.total_max > window.total_max) {
+        window.total_max = taken.total_max;
+    }
+    memset(&taken, 0, sizeof(taken));
+    taskEXIT_CRITICAL(&http_lock);
+}
+
+static void snapshot_tasks(health_report* report, bool reset) {
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    if (reset) {
+        num_taken_baseline = 0;
+    }
+
+    // Array must hold every task or nothing is returned
+    UBaseType_t size = uxTaskGetNumberOfTasks() + 2;
+    TaskStatus_t* status = malloc(size * sizeof(TaskStatus_t));
+    if (status == NULL) {
+        return;
+    }
+
+    uint32_t total = 0;
+    int count = uxTaskGetSystemState(status, size, &total);
+
+    // Counters run on every core at once
+    uint64_t elapsed = (uint64_t)(total - baseline_total) * portNUM_PROCESSORS;
+
+    for (int i = 0; i < count && report->num_tasks < HEALTH_MAX_TASKS; i++) {
+        task_health* task = &report->tasks[report->num_tasks++];
+        strlcpy(task->name, status[i].pcTaskName, sizeof(task->name));
+        task->stack_free = status[i].usStackHighWaterMark;
+
+        uint32_t start = 0;
+        for (int j = 0; j < num_baseline; j++) {
+            if (baseline[j].handle == status[i].xHandle) {
+                start = baseline[j].counter;
+                break;
+            }
+        }
+        uint32_t used = status[i].ulRunTimeCounter - start;
+        task->cpu = elapsed > 0 ? (uint64_t)used * 100 / elapsed : 0;
+    }
+
+    if (reset) {
+        memcpy(taken_baseline, baseline, sizeof(baseline));
+        num_taken_baseline = num_baseline;
+        taken_baseline_total = baseline_total;
+    }
+    if (reset || num_baseline == 0) {
+        num_baseline = 0;
+        for (int i = 0; i < count && num_baseline < HEALTH_MAX_TASKS; i++) {
+            baseline[num_baseline].handle = status[i].xHandle;
+            baseline[num_baseline].counter = status[i].ulRunTimeCounter;
+            num_baseline++;
+        }
+        baseline_total = total;
+    }
+
+    free(status);
+#endif
+}
+
+static void restore_tasks(void) {
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    // CPU use is counted from the baseline before the reset again
+    if (num_taken_baseline > 0) {
+        memcpy(baseline, taken_baseline, sizeof(baseline));
+        num_baseline = num_taken_baseline;
+        baseline_total = taken_baseline_total;
+    }
+#endif
+}
+
+void health_snapshot(health_report* report, bool reset) {
+    memset(report, 0, sizeof(health_report));
+    report->uptime = esp_timer_get_time() / 1000000;
+
+    report->heap_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    report->heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    report->heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    if (report->heap_free > 0) {
+        report->heap_frag = 100 -
+            (uint64_t)report->heap_largest * 100 / report->heap_free;
+    }
+
+    snapshot_http(&report->http, reset);
+
+    conn_stats conn = get_conn_stats();
+    report->handshakes = conn.handshakes;
+    report->reuses = conn.reuses;
+    report->queue_backlog = queue_backlog();
+    report->queue_dropped = queue_dropped();
+
+    if (lock != NULL) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        snapshot_tasks(report, reset);
+        xSemaphoreGive(lock);
+    }
+}
+
+void health_print(void) {
+    health_report* report = malloc(sizeof(health_report));
+    if (report == NULL) {
+        printf("ERROR allocating health report.\n");
+        return;
+    }
+    health_snapshot(report, false);
+
+    printf("Uptime: %lu s\n", (unsigned long)report->uptime);
+    printf("Heap: %lu free, %lu min free, %lu largest block, %d%% fragmented\n",
+        (unsigned long)report->heap_free,
+        (unsigned long)report->heap_min_free,
+        (unsigned long)report->heap_largest,
+        report->heap_frag);
+    printf("HTTP: %lu requests, %lu failed, %lu retried, "
+        "%lu/%lu/%lu ms connect/first byte/total, %lu ms max\n",
+        (unsigned long)report->http.requests,
+        (unsigned long)report->http.failures,
+        (unsigned long)report->http.retries,
+        (unsigned long)report->http.connect_ms,
+        (unsigned long)report->http.first_byte_ms,
+        (unsigned long)report->http.total_ms,
+        (unsigned long)report->http.total_max_ms);
+    printf("TLS: %lu handshakes, %lu reuses\n",
+        (unsigned long)report->handshakes, (unsigned long)report->reuses);
+    printf("Queue: %d pending, %d dropped\n", report->queue_backlog,
+        report->queue_dropped);
+    for (int i = 0; i < report->num_tasks; i++) {
+        printf("  %-16s %3d%% CPU, %5lu bytes stack free\n",
+            report->tasks[i].name, report->tasks[i].cpu,
+            (unsigned long)report->tasks[i].stack_free);
+    }
+
+    free(report);
+}
+
+static int write_health(rest_writer* writer, void* ctx) {
+    const health_report* report = (const health_report*)ctx;
+
+    rest_printf(writer,
+        "{\"%lld\": {\"Uptime\": %lu, "
+        "\"Heap_Free\": %lu, "
+        "\"Heap_Min_Free\": %lu, "
+        "\"Heap_Largest\": %lu, "
+        "\"Heap_Frag\": %d, ",
+        (long long)time(NULL),
+        (unsigned long)report->uptime,
+        (unsigned long)report->heap_free,
+        (unsigned long)report->heap_min_free,
+        (unsigned long)report->heap_largest,
+        report->heap_frag
+    );
+    rest_printf(writer,
+        "\"Http_Requests\": %lu, "
+        "\"Http_Failures\": %lu, "
+        "\"Http_Retries\": %lu, "
+        "\"Http_Connect_Ms\": %lu, "
+        "\"Http_First_Byte_Ms\": %lu, "
+        "\"Http_Total_Ms\": %lu, "
+        "\"Http_Total_Max_Ms\": %lu, ",
+        (unsigned long)report->http.requests,
+        (unsigned long)report->http.failures,
+        (unsigned long)report->http.retries,
+        (unsigned long)report->http.connect_ms,
+        (unsigned long)report->http.first_byte_ms,
+        (unsigned long)report->http.total_ms,
+        (unsigned long)report->http.total_max_ms
+    );
+    rest_printf(writer,
+        "\"Tls_Handshakes\": %lu, "
+        "\"Tls_Reuses\": %lu, "
+        "\"Queue_Backlog\": %d, "
+        "\"Queue_Dropped\": %d, "
+        "\"Tasks\": {",
+        (unsigned long)report->handshakes,
+        (unsigned long)report->reuses,
+        report->queue_backlog,
+        report->queue_dropped
+    );
+    for (int i = 0; i < report->num_tasks; i++) {
+        rest_printf(writer, "%s\"%s\": {\"Cpu\": %d, \"Stack\": %lu}",
+            i == 0 ? "" : ", ",
+            report->tasks[i].name,
+            report->tasks[i].cpu,
+            (unsigned long)report->tasks[i].stack_free
+        );
+    }
+
+    return rest_write(writer, "}}}", 3);
+}
+
+int health_publish(void) {
+    int64_t now = esp_timer_get_time() / 1000;
+    if (published && now - last_publish < HEALTH_REPORT_DELAY) {
+        return 0;
+    }
+
+    health_report* report = malloc(sizeof(health_report));
+    if (report == NULL) {
+        printf("ERROR allocating health report.\n");
+        return -1;
+    }
+    health_snapshot(report, true);
+
+    esp_http_client_handle_t client = acquire_client("health", FIREBASE_URL,
+        FIREBASE_API_KEY);
+    int status = -1;
+    if (client != NULL) {
+        status = stream_request(client, HTTP_METHOD_PATCH, "application/json",
+            REST_ENCODING_IDENTITY, write_health, report);
+        release_client(client, status == -1);
+    }
+    free(report);
+
+    if (status == -1) {
+        // Window is sent with the next record instead
+        printf("ERROR uploading health record.\n");
+        restore_http();
+        if (lock != NULL) {
+            xSemaphoreTake(lock, portMAX_DELAY);
+            restore_tasks();
+            xSemaphoreGive(lock);
+        }
+        return -1;
+    }
+
+    published = true;
+    last_publish = now;
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file health.h
+ * @brief Runtime instrumentation and health reports
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Collects CPU time and stack headroom of every task, heap usage and
+ * fragmentation, HTTP request timing and failure counters. A compact health
+ * record is uploaded to the "health" table alongside the parameter sync, and
+ * the same report is printed over serial when 'h' is received on the console.
+ *
+ * @note Per-task figures need CONFIG_FREERTOS_USE_TRACE_FACILITY and CPU time
+ * needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS (see sdkconfig.defaults).
+ *
+ */
+
+#ifndef HEALTH_H
+#define HEALTH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @def HEALTH_REPORT_DELAY
+ * @brief Time between uploaded health records (in ms)
+ *
+ */
+#define HEALTH_REPORT_DELAY 900000
+
+/**
+ * @def HEALTH_MAX_TASKS
+ * @brief Most tasks included in a report
+ *
+ */
+#define HEALTH_MAX_TASKS 24
+
+/**
+ * @brief Timing of one HTTP request
+ *
+ */
+typedef struct {
+    uint32_t connect_ms;        /**< TCP connect and TLS handshake, 0 if reused */
+    uint32_t first_byte_ms;     /**< Start to first response header, 0 if none */
+    uint32_t total_ms;          /**< Start to end of request */
+} http_timing;
+
+/**
+ * @brief HTTP request statistics
+ *
+ * Counters run since boot, timings cover the current report window.
+ *
+ */
+typedef struct {
+    uint32_t requests;          /**< Requests sent */
+    uint32_t failures;          /**< Requests failed */
+    uint32_t retries;           /**< Requests resent on a new connection */
+    uint32_t connect_ms;        /**< Mean connect and TLS handshake time */
+    uint32_t first_byte_ms;     /**< Mean time to first response byte */
+    uint32_t total_ms;          /**< Mean request time */
+    uint32_t total_max_ms;      /**< Longest request */
+} http_health;
+
+/**
+ * @brief Figures of one task
+ *
+ */
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];   /**< Task name */
+    uint32_t stack_free;        /**< Lowest stack headroom since start (bytes) */
+    uint8_t cpu;                /**< CPU time in report window (percent) */
+} task_health;
+
+/**
+ * @brief Health report
+ *
+ */
+typedef struct {
+    uint32_t uptime;            /**< Time since boot (s) */
+    uint32_t heap_free;         /**< Free heap (bytes) */
+    uint32_t heap_min_free;     /**< Lowest free heap since boot (bytes) */
+    uint32_t heap_largest;      /**< Largest free heap block (bytes) */
+    uint8_t heap_frag;          /**< Free heap not in largest block (percent) */
+    http_health http;           /**< HTTP request statistics */
+    uint32_t handshakes;        /**< Full TLS handshakes of pooled clients */
+    uint32_t reuses;            /**< Requests on an open pooled connection */
+    int queue_backlog;          /**< Readings waiting in the offline queue */
+    int queue_dropped;          /**< Readings overwritten before upload */
+    int num_tasks;              /**< Number of entries in tasks */
+    task_health tasks[HEALTH_MAX_TASKS]; /**< Per-task figures */
+} health_report;
+
+/**
+ * @brief Start the instrumentation and the serial console trigger
+ *
+ * @retval 0 Success
+ * @retval -1 Setup failed
+ *
+ */
+int health_init(void);
+
+/**
+ * @brief Record a finished HTTP request
+ *
+ * @param[in] timing Request timing
+ * @param[in] ok Request succeeded
+ *
+ */
+void health_http_request(const http_timing* timing, bool ok);
+
+/**
+ * @brief Record a request resent on a new connection
+ *
+ */
+void health_http_retry(void);
+
+/**
+ * @brief Collect a health report
+ *
+ * @param[out] report Health report
+ * @param[in] reset Start a new report window for CPU time and HTTP timing
+ *
+ */
+void health_snapshot(health_report* report, bool reset);
+
+/**
+ * @brief Print a health report over serial
+ *
+ * Does not start a new report window.
+ *
+ */
+void health_print(void);
+
+/**
+ * @brief Upload a health record if HEALTH_REPORT_DELAY has passed
+ *
+ * The record is stored under its timestamp in the "health" table and starts
+ * a new report window. After a failed upload the window is kept, so the next
+ * record covers it too.
+ *
+ * @retval 0 Record sent or not due
+ * @retval -1 Upload failed
+ *
+ */
+int health_publish(void);
+
+#endif
@@ -0,0 +1,420 @@
+#include "json_stream.h"
+
+#include <limits.h>
+#include <string.h>
+
+enum {
+    ST_VALUE,               // Expecting a value
+    ST_VALUE_OR_END,        // After '[', expecting a value or ']'
+    ST_KEY_OR_END,          // After '{', expecting a key or '}'
+    ST_KEY,                 // After ',' in an object, expecting a key
+    ST_COLON,               // After a key, expecting ':'
+    ST_COMMA_OR_END,        // After a value, expecting ',' or a closing bracket
+    ST_STRING,              // Inside a string
+    ST_LITERAL,             // Inside a number, true, false or null
+    ST_DONE,                // Complete document parsed
+    ST_ERROR
+};
+
+// Part of a number read so far
+enum {
+    NUM_SIGN,               // '-'
+    NUM_ZERO,               // Leading '0'
+    NUM_INT,                // Integer digits
+    NUM_POINT,              // '.'
+    NUM_FRACTION,           // Fraction digits
+    NUM_EXP,                // 'e' or 'E'
+    NUM_EXP_SIGN,           // Sign of exponent
+    NUM_EXP_DIGITS          // Exponent digits
+};
+
+static const char* const keywords[] = { "true", "false", "null" };
+
+void json_init(json_parser* parser, json_callback callback, void* ctx) {
+    memset(parser, 0, sizeof(json_parser));
+    parser->callback = callback;
+    parser->ctx = ctx;
+    parser->state = ST_VALUE;
+}
+
+static bool is_array(const json_parser* parser) {
+    return parser->depth > 0 && parser->depth <= 32 &&
+        (parser->arrays & (1u << (parser->depth - 1)));
+}
+
+static void after_value(json_parser* parser) {
+    parser->state = parser->depth == 0 ? ST_DONE : ST_COMMA_OR_END;
+}
+
+static void emit(json_parser* parser, json_type type, const char* value,
+    int len) {
+        if (parser->callback != NULL) {
+            parser->callback(parser, type, value, len, parser->ctx);
+        }
+}
+
+static int push(json_parser* parser, bool array) {
+    // Container type is needed for every level to match brackets
+    if (parser->depth >= 32) {
+        return -1;
+    }
+
+    emit(parser, array ? JSON_ARRAY_START : JSON_OBJECT_START, NULL, 0);
+
+    if (array) {
+        parser->arrays |= 1u << parser->depth;
+    }
+    else {
+        parser->arrays &= ~(1u << parser->depth);
+    }
+    if (parser->depth < JSON_MAX_DEPTH) {
+        parser->indices[parser->depth] = 0;
+        parser->keys[parser->depth][0] = '\0';
+    }
+    parser->depth++;
+    parser->state = array ? ST_VALUE_OR_END : ST_KEY_OR_END;
+
+    return 0;
+}
+
+static int pop(json_parser* parser, bool array) {
+    if (parser->depth == 0 || is_array(parser) != array) {
+        return -1;
+    }
+
+    parser->depth--;
+    emit(parser, array ? JSON_ARRAY_END : JSON_OBJECT_END, NULL, 0);
+    after_value(parser);
+
+    return 0;
+}
+
+static void append_token(json_parser* parser, const char* data, int len) {
+    int space = JSON_TOKEN_MAX - 1 - parser->token_len;
+    if (len > space) {
+        len = space;
+    }
+    memcpy(parser->token + parser->token_len, data, len);
+    parser->token_len += len;
+    parser->token[parser->token_len] = '\0';
+}
+
+static void finish_token(json_parser* parser, json_type type,
+    const char* data, int start, int end) {
+        const char* value = data + start;
+        int len = end - start;
+
+        // Join with the part received in earlier chunks
+        if (parser->split) {
+            if (end > 0) {
+                append_token(parser, data, end);
+            }
+            value = parser->token;
+            len = parser->token_len;
+        }
+
+        if (type == JSON_STRING && parser->is_key) {
+            if (parser->depth <= JSON_MAX_DEPTH) {
+                char* key = parser->keys[parser->depth - 1];
+                int key_len = len < JSON_KEY_MAX - 1 ? len : JSON_KEY_MAX - 1;
+                memcpy(key, value, key_len);
+                key[key_len] = '\0';
+            }
+            parser->state = ST_COLON;
+        }
+        else {
+            emit(parser, type, value, len);
+            after_value(parser);
+        }
+
+        parser->split = false;
+        parser->token_len = 0;
+}
+
+static json_type literal_type(const json_parser* parser) {
+    if (parser->keyword == NULL) {
+        return JSON_NUMBER;
+    }
+
+    return parser->keyword[0] == 'n' ? JSON_NULL : JSON_BOOL;
+}
+
+static int start_literal(json_parser* parser, char c) {
+    parser->keyword = NULL;
+    for (int i = 0; i < (int)(sizeof(keywords) / sizeof(keywords[0])); i++) {
+        if (c == keywords[i][0]) {
+            parser->keyword = keywords[i];
+            parser->literal = 1;
+            return 0;
+        }
+    }
+
+    if (c == '-') {
+        parser->literal = NUM_SIGN;
+    }
+    else if (c == '0') {
+        parser->literal = NUM_ZERO;
+    }
+    else if (c >= '1' && c <= '9') {
+        parser->literal = NUM_INT;
+    }
+    else {
+        return -1;
+    }
+
+    return 0;
+}
+
+static bool literal_complete(const json_parser* parser) {
+    if (parser->keyword != NULL) {
+        return parser->keyword[parser->literal] == '\0';
+    }
+
+    return parser->literal == NUM_ZERO || parser->literal == NUM_INT ||
+        parser->literal == NUM_FRACTION || parser->literal == NUM_EXP_DIGITS;
+}
+
+static int next_number_part(int part, char c) {
+    bool digit = c >= '0' && c <= '9';
+    bool exp = c == 'e' || c == 'E';
+
+    switch (part) {
+        case NUM_SIGN:
+            return c == '0' ? NUM_ZERO : digit ? NUM_INT : -1;
+        case NUM_ZERO:
+            return c == '.' ? NUM_POINT : exp ? NUM_EXP : -1;
+        case NUM_INT:
+            return digit ? NUM_INT : c == '.' ? NUM_POINT : exp ? NUM_EXP : -1;
+        case NUM_POINT:
+        case NUM_FRACTION:
+            return digit ? NUM_FRACTION :
+                part == NUM_FRACTION && exp ? NUM_EXP : -1;
+        case NUM_EXP:
+            return digit ? NUM_EXP_DIGITS :
+                (c == '+' || c == '-') ? NUM_EXP_SIGN : -1;
+        case NUM_EXP_SIGN:
+        case NUM_EXP_DIGITS:
+            return digit ? NUM_EXP_DIGITS : -1;
+        default:
+            return -1;
+    }
+}
+
+static int continue_literal(json_parser* parser, char c) {
+    // 0 if c is part of the literal, 1 if it follows a complete one
+    if (parser->keyword != NULL) {
+        if (parser->keyword[parser->literal] == c && c != '\0') {
+            parser->literal++;
+            return 0;
+        }
+    }
+    else {
+        int part = next_number_part(parser->literal, c);
+        if (part != -1) {
+            parser->literal = part;
+            return 0;
+        }
+    }
+
+    return literal_complete(parser) ? 1 : -1;
+}
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int start_value(json_parser* parser, char c) {
+    if (c == '{') {
+        return push(parser, false);
+    }
+    if (c == '[') {
+        return push(parser, true);
+    }
+    if (c == '"') {
+        parser->is_key = false;
+        parser->escape = false;
+        parser->state = ST_STRING;
+        return 0;
+    }
+    if (start_literal(parser, c) == 0) {
+        parser->state = ST_LITERAL;
+        return 0;
+    }
+
+    return -1;
+}
+
+int json_feed(json_parser* parser, const char* data, int len) {
+    // Start of a value in this chunk, 0 if it began in an earlier chunk
+    int start = 0;
+
+    for (int i = 0; i < len && parser->state != ST_ERROR; i++) {
+        char c = data[i];
+        int status = 0;
+
+        switch (parser->state) {
+            case ST_STRING:
+                if (parser->escape) {
+                    parser->escape = false;
+                }
+                else if (c == '\\') {
+                    parser->escape = true;
+                }
+                else if (c == '"') {
+                    finish_token(parser, JSON_STRING, data, start, i);
+                }
+                break;
+            case ST_LITERAL:
+                status = continue_literal(parser, c);
+                if (status == 1) {
+                    finish_token(parser, literal_type(parser), data, start, i);
+                    // Delimiter belongs to the next state
+                    i--;
+                    status = 0;
+                }
+                break;
+            case ST_VALUE:
+            case ST_VALUE_OR_END:
+                if (is_space(c)) {
+                    break;
+                }
+                if (c == ']' && parser->state == ST_VALUE_OR_END) {
+                    status = pop(parser, true);
+                    break;
+                }
+                status = start_value(parser, c);
+                start = parser->state == ST_STRING ? i + 1 : i;
+                break;
+            case ST_KEY_OR_END:
+            case ST_KEY:
+                if (is_space(c)) {
+                    break;
+                }
+                if (c == '}' && parser->state == ST_KEY_OR_END) {
+                    status = pop(parser, false);
+                    break;
+                }
+                if (c != '"') {
+                    status = -1;
+                    break;
+                }
+                parser->is_key = true;
+                parser->escape = false;
+                parser->state = ST_STRING;
+                start = i + 1;
+                break;
+            case ST_COLON:
+                if (is_space(c)) {
+                    break;
+                }
+                if (c != ':') {
+                    status = -1;
+                    break;
+                }
+                parser->state = ST_VALUE;
+                break;
+            case ST_COMMA_OR_END:
+                if (is_space(c)) {
+                    break;
+                }
+                if (c == ',') {
+                    if (is_array(parser)) {
+                        if (parser->depth <= JSON_MAX_DEPTH) {
+                            parser->indices[parser->depth - 1]++;
+                        }
+                        parser->state = ST_VALUE;
+                    }
+                    else {
+                        parser->state = ST_KEY;
+                    }
+                }
+                else if (c == '}' || c == ']') {
+                    status = pop(parser, c == ']');
+                }
+                else {
+                    status = -1;
+                }
+                break;
+            case ST_DONE:
+                if (!is_space(c)) {
+                    status = -1;
+                }
+                break;
+            default:
+                status = -1;
+                break;
+        }
+
+        if (status != 0) {
+            parser->state = ST_ERROR;
+        }
+    }
+
+    if (parser->state == ST_ERROR) {
+        return -1;
+    }
+
+    // Keep the unfinished part of a value for the next chunk
+    if (parser->state == ST_STRING || parser->state == ST_LITERAL) {
+        if (parser->split) {
+            append_token(parser, data, len);
+        }
+        else {
+            parser->token_len = 0;
+            append_token(parser, data + start, len - start);
+            parser->split = true;
+        }
+    }
+
+    return 0;
+}
+
+int json_finish(json_parser* parser) {
+    if (parser->state == ST_LITERAL) {
+        if (!literal_complete(parser)) {
+            parser->state = ST_ERROR;
+            return -1;
+        }
+        finish_token(parser, literal_type(parser), NULL, 0, 0);
+    }
+
+    return parser->state == ST_DONE ? 0 : -1;
+}
+
+const char* json_path_key(const json_parser* parser, int level) {
+    if (level < 1 || level > parser->depth || level > JSON_MAX_DEPTH ||
+        (parser->arrays & (1u << (level - 1)))) {
+            return NULL;
+    }
+
+    return parser->keys[level - 1];
+}
+
+int json_path_index(const json_parser* parser, int level) {
+    if (level < 1 || level > parser->depth || level > JSON_MAX_DEPTH ||
+        !(parser->arrays & (1u << (level - 1)))) {
+            return -1;
+    }
+
+    return parser->indices[level - 1];
+}
+
+int json_to_int(const char* value, int len) {
+    int sign = 1;
+    int result = 0;
+    int i = 0;
+
+    if (len > 0 && value[0] == '-') {
+        sign = -1;
+        i++;
+    }
+    for (; i < len && value[i] >= '0' && value[i] <= '9'; i++) {
+        int digit = value[i] - '0';
+        if (result > (INT_MAX - digit) / 10) {
+            return sign == 1 ? INT_MAX : INT_MIN;
+        }
+        result = result * 10 + digit;
+    }
+
+    return sign * result;
+}
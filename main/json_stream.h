@@ -0,0 +1,176 @@
+/**
+ * @file json_stream.h
+ * @brief Incremental JSON tokenizer
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Parses a JSON document fed in chunks of any size, e.g. straight
+ * from an HTTP client read, and reports every value through a callback. Memory
+ * use is fixed no matter how big the document is. Values are passed as
+ * pointers into the fed chunk, only a value split across two chunks is copied
+ * into a small token buffer.
+ *
+ */
+
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @def JSON_MAX_DEPTH
+ * @brief Deepest container level with tracked keys and indices
+ *
+ * @note Deeper levels are still parsed, but their path is not available.
+ *
+ */
+#define JSON_MAX_DEPTH 8
+
+/**
+ * @def JSON_KEY_MAX
+ * @brief Longest object key kept (in bytes, including terminator)
+ *
+ * @note Longer keys are truncated.
+ *
+ */
+#define JSON_KEY_MAX 32
+
+/**
+ * @def JSON_TOKEN_MAX
+ * @brief Longest value that may be split across chunks (in bytes)
+ *
+ * @note Longer split values are truncated.
+ *
+ */
+#define JSON_TOKEN_MAX 64
+
+/**
+ * @brief Type of parsed JSON element
+ *
+ */
+typedef enum {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_OBJECT_START,
+    JSON_OBJECT_END,
+    JSON_ARRAY_START,
+    JSON_ARRAY_END
+} json_type;
+
+typedef struct json_parser json_parser;
+
+/**
+ * @brief Callback for each parsed element
+ *
+ * For values and container starts, the parser depth is the number of
+ * containers enclosing the element. The element's key or index at each level
+ * can be read with json_path_key() and json_path_index().
+ *
+ * @param[in] parser Parser state
+ * @param[in] type Element type
+ * @param[in] value Raw value text (strings without quotes, not unescaped)
+ * @param[in] len Length of value
+ * @param[in] ctx User context
+ *
+ */
+typedef void (*json_callback)(const json_parser* parser, json_type type,
+    const char* value, int len, void* ctx);
+
+/**
+ * @brief Incremental parser state
+ *
+ */
+struct json_parser {
+    json_callback callback;             /**< Element callback */
+    void* ctx;                          /**< User context for callback */
+    int state;                          /**< Tokenizer state */
+    int depth;                          /**< Number of open containers */
+    uint32_t arrays;                    /**< Bit set if level is an array */
+    char keys[JSON_MAX_DEPTH][JSON_KEY_MAX]; /**< Current key per level */
+    int indices[JSON_MAX_DEPTH];        /**< Current index per level */
+    char token[JSON_TOKEN_MAX];         /**< Value split across chunks */
+    int token_len;                      /**< Length of token */
+    bool split;                         /**< Current value spans chunks */
+    bool is_key;                        /**< Current string is a key */
+    bool escape;                        /**< Previous string char was '\' */
+    const char* keyword;                /**< Keyword read, NULL for a number */
+    int literal;                        /**< Keyword chars or number part */
+};
+
+/**
+ * @brief Initialize parser
+ *
+ * @param[out] parser Parser state
+ * @param[in] callback Element callback
+ * @param[in] ctx User context for callback
+ *
+ */
+void json_init(json_parser* parser, json_callback callback, void* ctx);
+
+/**
+ * @brief Feed the next chunk of the document
+ *
+ * Numbers and the keywords true, false and null are checked against the JSON
+ * grammar as they are read, e.g. "tru" and "01" are syntax errors.
+ *
+ * @param[in, out] parser Parser state
+ * @param[in] data Chunk of JSON text
+ * @param[in] len Length of chunk
+ *
+ * @retval 0 Success
+ * @retval -1 Syntax error
+ *
+ */
+int json_feed(json_parser* parser, const char* data, int len);
+
+/**
+ * @brief Finish parsing after the last chunk
+ *
+ * Completes a top-level number or literal that ended with the document.
+ *
+ * @param[in, out] parser Parser state
+ *
+ * @retval 0 Complete document parsed
+ * @retval -1 Syntax error or incomplete document
+ *
+ */
+int json_finish(json_parser* parser);
+
+/**
+ * @brief Get key of the current element at a level
+ *
+ * @param[in] parser Parser state
+ * @param[in] level Container level (1 - depth)
+ *
+ * @return Key string, or NULL if the level is an array or not tracked
+ *
+ */
+const char* json_path_key(const json_parser* parser, int level);
+
+/**
+ * @brief Get index of the current element at a level
+ *
+ * @param[in] parser Parser state
+ * @param[in] level Container level (1 - depth)
+ *
+ * @return Array index, or -1 if the level is an object or not tracked
+ *
+ */
+int json_path_index(const json_parser* parser, int level);
+
+/**
+ * @brief Convert a raw number value to an integer
+ *
+ * @param[in] value Raw value text
+ * @param[in] len Length of value
+ *
+ * @return Integer part of number, saturated to INT_MIN or INT_MAX
+ *
+ */
+int json_to_int(const char* value, int len);
+
+#endif
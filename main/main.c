@@ -23,6 +23,10 @@
  * @see sensor.h
  * @see planter_units.h
  * @see rest_api.h
+ * @see offline_queue.h
+ * @see param_stream.h
+ * @see power.h
+ * @see scheduler.h
  * @see secrets.h
  * 
  */
@@ -30,11 +34,17 @@
 #include <string.h>
 #include <time.h>
 
+#include "health.h"
+#include "offline_queue.h"
+#include "param_stream.h"
+#include "power.h"
 #include "sensor.h"
 #include "planter_utils.h"
 #include "rest_api.h"
+#include "scheduler.h"
 #include "secrets.h"
 #include "solenoid.h"
+#include "thermal.h"
 
 /**
  * @def RECORD_DELAY
@@ -43,6 +53,88 @@
  */
 #define RECORD_DELAY 3600000
 
+/**
+ * @def SYNC_DELAY
+ * @brief Delay interval between WiFi checks and parameter polls (in ms)
+ * 
+ */
+#define SYNC_DELAY 60000
+
+/**
+ * @def ADC_READ_MODE
+ * @brief Sampling mode of moisture sensors
+ * 
+ * SENS_MODE_CONTINUOUS scans all sensors with DMA in the background, 
+ * SENS_MODE_ONESHOT reads a sensor only when requested. Sensors on ADC2 need
+ * SENS_MODE_ONESHOT.
+ * 
+ */
+#define ADC_READ_MODE SENS_MODE_CONTINUOUS
+
+/**
+ * @def BATCH_UPLOAD
+ * @brief Upload mode for sensor readings
+ * 
+ * When set to 1, every reading of a cycle is written with a single multi-path
+ * PATCH request. When set to 0, each reading is sent in its own POST request.
+ * 
+ */
+#define BATCH_UPLOAD 1
+
+/**
+ * @def BACKLOG_ENCODING
+ * @brief Compression of offline queue uploads
+ * 
+ * REST_ENCODING_GZIP compresses queued readings while they are sent, which
+ * shortens the time on air when a large backlog is drained. 
+ * REST_ENCODING_IDENTITY sends them as plain JSON.
+ * 
+ * @note The server must accept gzip request bodies.
+ * 
+ */
+#define BACKLOG_ENCODING REST_ENCODING_IDENTITY
+
+/**
+ * @def PARAM_STREAMING
+ * @brief Parameter update mode
+ * 
+ * When set to 1, watering parameters are received through a Firebase event
+ * stream and only polled while the stream is down. When set to 0, parameters
+ * are polled every minute.
+ * 
+ */
+#define PARAM_STREAMING 1
+
+/**
+ * @def LOW_POWER_MODE
+ * @brief Power mode
+ * 
+ * When set to 1, the board runs the events that are due and deep sleeps until
+ * the next one. WiFi is only started when an event needs it and parameters
+ * are polled every LOW_POWER_SYNC_DELAY instead of streamed. When set to 0,
+ * the board stays awake with WiFi connected.
+ * 
+ */
+#define LOW_POWER_MODE 0
+
+/**
+ * @def LOW_POWER_SYNC_DELAY
+ * @brief Delay interval between parameter polls in low power mode (in ms)
+ * 
+ */
+#define LOW_POWER_SYNC_DELAY 900000
+
+/**
+ * @def SENSOR_FILTER
+ * @brief Default filter of moisture sensors
+ * 
+ * Averages 4 raw samples, takes the median of 5 averages and smooths the
+ * result with an EMA weight of 1/4.
+ * 
+ */
+#define SENSOR_FILTER { .config = { .oversample = 4, .median = 5, \
+    .ema_shift = 2 } }
+
 /**
  * @brief Array of soil moisture sensors used
  * 
@@ -50,27 +142,35 @@
 sensor sensors[] = {
     {
         .name = "SENSOR_1",
+        .unit = ADC_UNIT_1,
         .channel = ADC_CHANNEL_3,
         .mean_dry = 2712,
-        .mean_wet = 970
+        .mean_wet = 970,
+        .filter = SENSOR_FILTER
     },
     {
         .name = "SENSOR_2",
+        .unit = ADC_UNIT_1,
         .channel = ADC_CHANNEL_4,
         .mean_dry = 2710,
-        .mean_wet = 1059
+        .mean_wet = 1059,
+        .filter = SENSOR_FILTER
     },
     {
         .name = "SENSOR_3",
+        .unit = ADC_UNIT_1,
         .channel = ADC_CHANNEL_5,
         .mean_dry = 2721,
-        .mean_wet = 1072
+        .mean_wet = 1072,
+        .filter = SENSOR_FILTER
     },
     {
         .name = "SENSOR_4",
+        .unit = ADC_UNIT_1,
         .channel = ADC_CHANNEL_6,
         .mean_dry = 4095,
-        .mean_wet = 2040
+        .mean_wet = 2040,
+        .filter = SENSOR_FILTER
     }
 };
 
@@ -110,96 +210,521 @@ valve valves[] = {
  */
 const int num_valves = 4;
 
+/**
+ * @def MAX_OPEN_VALVES
+ * @brief Maximum number of valves open at the same time
+ * 
+ * @note Set according to the water supply, pump and pressure limits.
+ * 
+ */
+#define MAX_OPEN_VALVES 2
+
+/**
+ * @brief Store a reading in the offline queue
+ * 
+ * @param[in] record Reading to store
+ */
+static void queue_reading(const sensor_record* record) {
+    queue_record queued = {
+        .timestamp = (uint32_t)record->timestamp,
+        .moisture = record->moisture,
+        .sensor_id = record->sensor_id
+    };
+
+    if (queue_push(&queued) == -1) {
+        printf("ERROR queueing reading for %s.\n", record->name);
+    }
+}
+
+/**
+ * @brief Reading of one sensor with the local time it was taken
+ * 
+ */
+typedef struct {
+    const sensor_record* record;
+    struct tm timeinfo;
+} timed_reading;
+
+/**
+ * @brief Write a sensor reading as a JSON request body
+ * 
+ * @param[in] writer Request body
+ * @param[in] ctx Reading to write (timed_reading)
+ * 
+ * @retval 0 Reading written
+ * @retval -1 Write failed
+ */
+static int write_reading(rest_writer* writer, void* ctx) {
+    const timed_reading* reading = (const timed_reading*)ctx;
+    return rest_printf(writer,
+        "{\"Name\": \"%s\", "
+        "\"Month\": %d, "
+        "\"Day\": %d, "
+        "\"Hour\": %d, "
+        "\"Moisture\": %d.%02d}",
+        reading->record->name,
+        reading->timeinfo.tm_mon+1,
+        reading->timeinfo.tm_mday,
+        reading->timeinfo.tm_hour,
+        reading->record->moisture / 100,
+        reading->record->moisture % 100
+    );
+}
+
+/**
+ * @brief Send each sensor reading in its own POST request
+ * 
+ * Readings that fail to send are stored in the offline queue.
+ * 
+ * @param[in] client HTTP client handle for the "sensor_data" table
+ * @param[in] records Readings of the cycle
+ * @param[in] num_records Number of readings
+ * 
+ * @retval 0 All readings sent
+ * @retval 1 At least one reading failed
+ */
+static int upload_individual(esp_http_client_handle_t client, 
+    const sensor_record* records, int num_records) {
+        int failed = 0;
+        timed_reading reading;
+        get_local_time(&reading.timeinfo);
+
+        // Transmit data from all sensors
+        for (int i = 0; i < num_records; i++) {
+            reading.record = &records[i];
+
+            // Attempt to send data if failed once
+            if (stream_request(client, HTTP_METHOD_POST, "application/json",
+                REST_ENCODING_IDENTITY, write_reading, &reading) == -1) {
+                    printf("ERROR during POST request. Retrying... ");
+                    vTaskDelay(pdMS_TO_TICKS(5000));
+                    if (stream_request(client, HTTP_METHOD_POST, 
+                        "application/json", REST_ENCODING_IDENTITY, 
+                        write_reading, &reading) == -1) {
+                            printf("FAIL.\n");
+                            queue_reading(&records[i]);
+                            failed = 1;
+                    }
+                    else {
+                        printf("SUCCESS.\n");
+                        continue;
+                    }
+            }
+    
+            // Small delay between sensor transfers
+            vTaskDelay(pdMS_TO_TICKS(1000));
+        }
+
+        return failed;
+}
+
+/**
+ * @brief Send all sensor readings of a cycle in one PATCH request
+ * 
+ * Readings are stored in the offline queue if the upload fails.
+ * 
+ * @param[in] client HTTP client handle for the "sensor_data" table
+ * @param[in] records Readings of the cycle
+ * @param[in] num_records Number of readings
+ * 
+ * @retval 0 Readings sent
+ * @retval 1 Upload failed
+ */
+static int upload_batch(esp_http_client_handle_t client, 
+    const sensor_record* records, int num_records) {
+        if (num_records == 0) {
+            return 0;
+        }
+
+        // Attempt to send data if failed once
+        if (patch_records(client, records, num_records) == -1) {
+            printf("ERROR during batch upload. Retrying... ");
+            vTaskDelay(pdMS_TO_TICKS(5000));
+            if (patch_records(client, records, num_records) == -1) {
+                printf("FAIL.\n");
+                for (int i = 0; i < num_records; i++) {
+                    queue_reading(&records[i]);
+                }
+                return 1;
+            }
+            printf("SUCCESS.\n");
+        }
+
+        return 0;
+}
+
+/**
+ * @brief Upload readings stored in the offline queue
+ * 
+ * Sends queued readings one flash page at a time and removes each batch once
+ * it is accepted by the server.
+ * 
+ * @param[in] client HTTP client handle for the "sensor_data" table
+ * 
+ * @retval 0 Queue drained
+ * @retval 1 Upload or queue update failed, remaining readings are kept
+ */
+static int drain_queue(esp_http_client_handle_t client) {
+    // A full page is too large for the task stacks, and the queue is only
+    // drained by one task at a time
+    static queue_record queued[QUEUE_PAGE_RECORDS];
+    static sensor_record records[QUEUE_PAGE_RECORDS];
+
+    int count;
+    while ((count = queue_peek(queued, QUEUE_PAGE_RECORDS)) > 0) {
+        for (int i = 0; i < count; i++) {
+            int id = queued[i].sensor_id;
+            records[i].name = id < num_channels ? sensors[id].name : "UNKNOWN";
+            records[i].timestamp = queued[i].timestamp;
+            records[i].moisture = queued[i].moisture;
+            records[i].sensor_id = id;
+        }
+
+        if (send_records(client, &json_codec, records, count, 
+            BACKLOG_ENCODING) == -1) {
+                printf("ERROR uploading queued readings.\n");
+                return 1;
+        }
+
+        // Page left in the queue would be uploaded again on the next pass
+        if (queue_pop() != 0) {
+            printf("ERROR removing uploaded readings from queue.\n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Chip temperature summary of a reporting window
+ * 
+ */
+typedef struct {
+    thermal_window window;
+    time_t timestamp;
+} thermal_report;
+
+/**
+ * @brief Write a chip temperature summary as a JSON request body
+ * 
+ * @param[in] writer Request body
+ * @param[in] ctx Summary to write (thermal_report)
+ * 
+ * @retval 0 Summary written
+ * @retval -1 Write failed
+ */
+static int write_thermal(rest_writer* writer, void* ctx) {
+    const thermal_report* report = (const thermal_report*)ctx;
+    struct tm timeinfo;
+    localtime_r(&report->timestamp, &timeinfo);
+
+    return rest_printf(writer,
+        "{\"%lld-CHIP_TEMP\": {\"Name\": \"CHIP_TEMP\", "
+        "\"Month\": %d, "
+        "\"Day\": %d, "
+        "\"Hour\": %d, "
+        "\"Temp_Min\": %.1f, "
+        "\"Temp_Max\": %.1f, "
+        "\"Temp_Avg\": %.1f, "
+        "\"Samples\": %d}}",
+        (long long)report->timestamp,
+        timeinfo.tm_mon+1,
+        timeinfo.tm_mday,
+        timeinfo.tm_hour,
+        report->window.min,
+        report->window.max,
+        report->window.avg,
+        report->window.count
+    );
+}
+
+/**
+ * @brief Upload the chip temperature summary of the reporting window
+ * 
+ * The window keeps collecting samples until it is uploaded.
+ * 
+ * @param[in] client HTTP client handle for the "sensor_data" table
+ * @param[in] timestamp Time of the report
+ * 
+ * @retval 0 Summary sent or no samples
+ * @retval 1 Upload failed
+ */
+static int upload_thermal(esp_http_client_handle_t client, time_t timestamp) {
+    thermal_report report = {
+        .window = thermal_take_window(),
+        .timestamp = timestamp
+    };
+    if (report.window.count == 0) {
+        return 0;
+    }
+
+    if (stream_request(client, HTTP_METHOD_PATCH, "application/json", 
+        REST_ENCODING_IDENTITY, write_thermal, &report) == -1) {
+            printf("ERROR uploading chip temperature.\n");
+            thermal_restore_window(&report.window);
+            return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Print the stack headroom of the calling task at each new low
+ * 
+ * @param[in] name Task name to print
+ * @param[in, out] lowest Lowest headroom printed so far (bytes)
+ */
+static void report_stack(const char* name, UBaseType_t* lowest) {
+    UBaseType_t headroom = uxTaskGetStackHighWaterMark(NULL);
+    if (headroom < *lowest) {
+        *lowest = headroom;
+        printf("%s stack: %u bytes free.\n", name, (unsigned)headroom);
+    }
+}
+
 /**
  * @brief Periodically update WiFi and watering parameters
  * 
- * Checks the WiFi connection and updates the watering parameters in the
- * database every minute.
+ * Checks the WiFi connection, samples the chip temperature and updates the
+ * watering parameters in the database when woken by the scheduler, every
+ * minute. Polling is skipped while the parameter stream is connected. A health
+ * record is uploaded every HEALTH_REPORT_DELAY.
  * 
  * @param[in] pvParameters unused
  */
 void update_task(void *pvParameters) {
-    TickType_t xLastWakeTime = xTaskGetTickCount();
-    const TickType_t delay = pdMS_TO_TICKS(60000);
-
+    UBaseType_t lowest = UINT32_MAX;
     while (1) {
+        thermal_sample();
         check_wifi();
-        parameter_comms();
+        if (!PARAM_STREAMING || !param_stream_connected()) {
+            parameter_comms();
+        }
+        time_persist();
+        health_publish();
+        report_stack("Update task", &lowest);
 
-        xTaskDelayUntil(&xLastWakeTime, delay);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
 }
 
 /**
- * @brief Monitor soil moisture levels and control watering.
+ * @brief Read all sensors and upload the readings
  * 
- * Reads sensor data and controls solenoid valves based on the scheduled
- * watering times. Sensor data is sent to the Firebase Realtime Database every
- * hour.
+ * Readings are queued while WiFi is down and sent with the next successful
+ * upload.
  * 
- * @param[in] pvParameters unused 
+ * @param[in] adc_handle ADC reader of the sensors
+ * @param[out] records Space for one reading per sensor
  */
-void watering_task(void *pvParameters) {
-    adc_oneshot_unit_handle_t adc1_handle = init_adc(ADC_UNIT_1, sensors, 
-        num_channels);
+static void report_cycle(adc_reader* adc_handle, sensor_record* records) {
+    int wifi_status = check_wifi();
 
-    TickType_t xLastWakeTime = xTaskGetTickCount();
-    const TickType_t delay = pdMS_TO_TICKS(RECORD_DELAY);
-    
+    // Read all sensors with a shared timestamp, failed reads are left out
+    time_t now = time(NULL);
+    int num_records = 0;
+    for (int i = 0; i < num_channels; i++) {
+        int moisture = sens_read_moisture(adc_handle, &sensors[i]);
+        if (moisture == -1) {
+            printf("ERROR reading %s, skipping it.\n", sensors[i].name);
+            continue;
+        }
+        records[num_records].name = sensors[i].name;
+        records[num_records].sensor_id = i;
+        records[num_records].timestamp = now;
+        records[num_records].moisture = moisture;
+        num_records++;
+    }
+
+    esp_http_client_handle_t client = NULL;
+    if (wifi_status != -1) {
+        client = acquire_client("sensor_data", FIREBASE_URL, FIREBASE_API_KEY);
+    }
+    if (client == NULL) {
+        // Offline or no client, keep readings for later
+        printf("%s, queueing readings.\n", wifi_status == -1 ? 
+            "WiFi unavailable" : "ERROR no HTTP client");
+        for (int i = 0; i < num_records; i++) {
+            queue_reading(&records[i]);
+        }
+        queue_flush();
+        return;
+    }
+#if BATCH_UPLOAD
+    int failed = upload_batch(client, records, num_records);
+#else
+    int failed = upload_individual(client, records, num_records);
+#endif
+
+    // Connection is good, send readings stored while offline
+    if (!failed && queue_backlog() > 0) {
+        printf("Uploading %d queued readings.\n", queue_backlog());
+        failed = drain_queue(client);
+    }
+    if (!failed) {
+        failed = upload_thermal(client, now);
+    }
+    queue_flush();
+    release_client(client, failed);
+    client = NULL;
+
+    conn_stats stats = get_conn_stats();
+    printf("Connections: %" PRIu32 " handshakes, %" PRIu32 " reuses, "
+        "%" PRIu32 " reconnects.\n",
+        stats.handshakes, stats.reuses, stats.reconnects);
+}
+
+/**
+ * @brief Monitor soil moisture levels.
+ * 
+ * Reads sensor data and sends it to the Firebase Realtime Database when woken
+ * by the scheduler, every hour. Watering is started by the scheduler itself.
+ * 
+ * @param[in] pvParameters ADC reader of the sensors (adc_reader*)
+ */
+void report_task(void *pvParameters) {
+    adc_reader* adc_handle = (adc_reader*)pvParameters;
+
+    sensor_record* records = malloc(num_channels * sizeof(sensor_record));
+    if (records == NULL) {
+        printf("ERROR allocating sensor records.\n");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    UBaseType_t lowest = UINT32_MAX;
     while (1) {
-        check_wifi();
-        if (get_current_hour() == watering_times[0] || 
-            get_current_hour() == watering_times[1]) {
-                for (int i = 0; i < num_valves; i++) {
-                    set_valve_position(valves[i], VALVE_LOW);
-                    vTaskDelay(pdMS_TO_TICKS(water_duration*1000));
-                    set_valve_position(valves[i], VALVE_HIGH);
-                    vTaskDelay(pdMS_TO_TICKS(water_duration*2000));
-                }
+        report_cycle(adc_handle, records);
+        report_stack("Report task", &lowest);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+#if LOW_POWER_MODE
+/**
+ * @brief Check if an event type is in a list of due events
+ * 
+ * @param[in] due Due events
+ * @param[in] num_due Number of due events
+ * @param[in] type Event type
+ * 
+ * @retval true Event type is due
+ * @retval false Event type is not due
+ */
+static bool is_due(const sched_event* due, int num_due, sched_type type) {
+    for (int i = 0; i < num_due; i++) {
+        if (due[i].type == type) {
+            return true;
         }
-    
-        esp_http_client_handle_t client = setup_client("sensor_data", 
-            FIREBASE_URL, FIREBASE_API_KEY);
-        // Read & transmit data from all sensors
-        for (int i = 0; i < num_channels; i++) {
-            // Formatted JSON for transmission
-            char post_json[256];
-            snprintf(post_json, 256,
-                "{\"Name\": \"%s\", "
-                "\"Month\": %d, "
-                "\"Day\": %d, "
-                "\"Hour\": %d, "
-                "\"Moisture\": %.2f}",
-                sensors[i].name,
-                get_current_month(),
-                get_current_day(),
-                get_current_hour(),
-                map(sensors[i], read_sens(adc1_handle, sensors[i].channel))*100
-            );
-        
-            // Attempt to send data if failed once
-            if (post_data(client, post_json) == -1) {
-                printf("ERROR during POST request. Retrying... ");
-                vTaskDelay(pdMS_TO_TICKS(5000));
-                if (post_data(client, post_json) == -1) {
-                    printf("FAIL.\n");
-                }
-                else {
-                    printf("SUCCESS.\n");
-                    continue;
-                }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Run the events that are due and deep sleep until the next one
+ * 
+ * Watering parameters, calibration and the time of the last cycle are kept in
+ * RTC memory, so WiFi and SNTP are only started when a due event needs them.
+ * Every event runs on a cold boot.
+ * 
+ * @note Does not return
+ */
+static void low_power_cycle(void) {
+    bool resumed = power_resume(sensors, num_channels);
+    if (resumed) {
+        power_stats stats = get_power_stats();
+        printf("Power: cycle %" PRIu32 ", awake %" PRIu32 " ms, WiFi %" PRIu32
+            " ms, asleep %" PRIu32 " ms, %" PRIu32 " uA (%" PRIu32 " uA "
+            "average).\n",
+            stats.cycles, stats.awake_ms, stats.wifi_ms, stats.sleep_ms,
+            stats.cycle_current_ua, stats.avg_current_ua);
+    }
+
+    // Clock keeps running in deep sleep, only the drift is corrected
+    time_restore();
+
+    // Valves read their sensors for closed-loop watering
+    adc_reader* adc_handle = init_adc(sensors, num_channels,
+        SENS_MODE_ONESHOT);
+    if (setup_valve(valves, num_valves) == -1 || 
+        valve_scheduler_start(valves, num_valves, MAX_OPEN_VALVES, 
+            adc_handle) == -1) {
+            printf("ERROR setting up valves.\n");
+    }
+    if (queue_init() == -1) {
+        printf("ERROR setting up offline queue.\n");
+    }
+    if (thermal_init() == 0) {
+        thermal_sample();
+    }
+
+    sched_config schedule = {
+        .valves = valves,
+        .num_valves = num_valves,
+        .report_interval = RECORD_DELAY / 1000,
+        .sync_interval = LOW_POWER_SYNC_DELAY / 1000
+    };
+    scheduler_configure(&schedule);
+
+    time_t now = time(NULL);
+    sched_event due[SCHED_MAX_EVENTS];
+    int num_due = 0;
+    bool cold = !resumed || now < SCHED_TIME_VALID;
+    if (cold) {
+        due[num_due++] = (sched_event){ .type = SCHED_PARAM_SYNC };
+        due[num_due++] = (sched_event){ .type = SCHED_REPORT };
+    }
+    else {
+        num_due = scheduler_due(power_last_cycle(), now, due, 
+            SCHED_MAX_EVENTS);
+    }
+
+    // Network is only needed for reports and parameter polls
+    if (is_due(due, num_due, SCHED_REPORT) || 
+        is_due(due, num_due, SCHED_PARAM_SYNC)) {
+            power_wifi_started();
+            if (init_wifi() != 0) {
+                printf("ERROR connecting to WiFi.\n");
             }
-    
-            // Small delay between sensor transfers
-            vTaskDelay(pdMS_TO_TICKS(1000));
+
+            if (time_needs_sync(POWER_RESYNC_AGE)) {
+                calibrate_time();
+            }
+    }
+    if (cold) {
+        now = time(NULL);
+    }
+
+    // Newest parameters first, so watering uses them
+    if (is_due(due, num_due, SCHED_PARAM_SYNC)) {
+        parameter_comms();
+    }
+    for (int i = 0; i < num_due; i++) {
+        if (due[i].type == SCHED_WATER) {
+            scheduler_water(due[i].valve_id);
         }
-        esp_http_client_cleanup(client);
-        client = NULL;
-    
-        // Delay
-        xTaskDelayUntil(&xLastWakeTime, delay);
     }
+    if (is_due(due, num_due, SCHED_REPORT)) {
+        sensor_record* records = malloc(num_channels * sizeof(sensor_record));
+        if (adc_handle != NULL && records != NULL) {
+            report_cycle(adc_handle, records);
+        }
+        free(records);
+    }
+
+    // Valves must be closed before sleeping
+    while (valves_active() > 0) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    queue_flush();
+    time_persist();
+
+    power_sleep(now, scheduler_next_after(now), sensors, num_channels, valves,
+        num_valves);
 }
+#endif
 
 /**
  * @brief Main application
@@ -221,6 +746,7 @@ void watering_task(void *pvParameters) {
  * @code
  * {
  *     .name = "SENSOR_1",
+ *     .unit = ADC_UNIT_1,
  *     .channel = ADC_CHANNEL_3,
  *     .mean_dry = DEFAULT_DRY,
  *     .mean_wet = DEFAULT_WET
@@ -232,9 +758,20 @@ void watering_task(void *pvParameters) {
  * 
  */
 void app_main(void) {
+#if LOW_POWER_MODE
+    // Deep sleeps at the end of every cycle
+    low_power_cycle();
+#endif
+
     // ADC Sensor Configuration
     printf("ADC setup... ");
-    printf("DONE.\n");
+    adc_reader* adc_handle = init_adc(sensors, num_channels, ADC_READ_MODE);
+    if (adc_handle == NULL) {
+        printf("FAIL.\n");
+    }
+    else {
+        printf("DONE.\n");
+    }
 
 
     // GPIO Configuration
@@ -242,52 +779,110 @@ void app_main(void) {
     gpio_set_direction(GPIO_NUM_1, GPIO_MODE_INPUT);
     gpio_set_pull_mode(GPIO_NUM_1, GPIO_PULLDOWN_ONLY);
     
-    if (setup_valve(valves, num_valves) == -1) {
-        printf("FAIL.\n");
+    if (led_start() == -1 ||
+        setup_valve(valves, num_valves) == -1 || 
+        valve_scheduler_start(valves, num_valves, MAX_OPEN_VALVES, 
+            adc_handle) == -1) {
+            printf("FAIL.\n");
     }
     printf("DONE.\n");
 
 
+    // Offline queue for readings that cannot be uploaded
+    printf("Offline queue setup... ");
+    if (queue_init() == -1) {
+        printf("FAIL.\n");
+    }
+    else {
+        printf("DONE. %d readings queued.\n", queue_backlog());
+    }
+
+
+    // Chip temperature telemetry
+    printf("Temperature sensor setup... ");
+    if (thermal_init() == -1) {
+        printf("FAIL.\n");
+    }
+    else {
+        printf("DONE.\n");
+    }
+
+    printf("Health monitoring setup... ");
+    if (health_init() == -1) {
+        printf("FAIL.\n");
+    }
+    else {
+        printf("DONE.\n");
+    }
+
+
+    // Clock from before the reset, so scheduling does not wait for WiFi
+    printf("Restoring time... ");
+    if (time_restore() == -1) {
+        printf("UNKNOWN.\n");
+    }
+    else {
+        printf("DONE.\n");
+    }
+
+
     // WiFi initialization
-    // TODO: Add offline functionality
+    // Returns as soon as an IP is received
     printf("WiFi setup... ");
-    for (int i = 0; i < 3; i++) {
-        if (init_wifi()) {
-            printf("RETRY.\n");
-            printf("WiFi setup... ");
-            continue;
-        }
-        break;
+    if (init_wifi() != 0) {
+        printf("FAIL.\n");
+    }
+    else {
+        printf("DONE.\n");
     }
-    printf("DONE.\n");
 
 
     // Time synchronization
     printf("Calibrating time... ");
-    calibrate_time();
-    printf("DONE.\n");
+    if (calibrate_time() == -1) {
+        printf("FAIL.\n");
+    }
+    else {
+        printf("DONE.\n");
+    }
 
     // Wait for user input to start recording
-    for (int i = 0; i < 3; i++) {
-        display_rgb(0, 0, 255, 500);
-        vTaskDelay(pdMS_TO_TICKS(500));
-    }
+    led_pattern ready = { .b = 255, .on_ms = 500, .off_ms = 500, .count = 3 };
+    led_show(&ready);
     // button_interrupt("Press button to start.\n");
     printf("Starting...\n");
-    for (int i = 0; i < 3; i++) {
-        display_rgb(255, 0, 0, 500);
-        vTaskDelay(500 / portTICK_PERIOD_MS);
-    }
+    led_pattern starting = { .r = 255, .on_ms = 500, .off_ms = 500, .count = 3 };
+    led_show(&starting);
 
     // Calibrate sensors
     // Default is to run calibration, but can be commented out for DEFAULT
     // values found in sensor.h file
-    // sens_calibrate(adc1_handle, sensors, num_channels);
+    // sens_calibrate(adc_handle, sensors, num_channels);
     
     // Set initial parameters
     parameter_comms();
 
     // Start background tasks
-    xTaskCreate(watering_task, "HourlyWateringTask", 10240, NULL, 5, NULL);
-    xTaskCreate(update_task, "MinutelyUpdatingTask", 5830, NULL, 5, NULL);
+    TaskHandle_t report_handle = NULL;
+    TaskHandle_t update_handle = NULL;
+    xTaskCreate(report_task, "HourlyReportTask", 10240, adc_handle, 5, 
+        &report_handle);
+    xTaskCreate(update_task, "MinutelyUpdatingTask", 5830, NULL, 5, 
+        &update_handle);
+#if PARAM_STREAMING
+    xTaskCreate(param_stream_task, "ParamStreamTask", 6144, NULL, 5, NULL);
+#endif
+
+    // Wake tasks and open valves on the wall clock
+    sched_config schedule = {
+        .valves = valves,
+        .num_valves = num_valves,
+        .report_task = report_handle,
+        .report_interval = RECORD_DELAY / 1000,
+        .sync_task = update_handle,
+        .sync_interval = SYNC_DELAY / 1000
+    };
+    if (scheduler_start(&schedule) == -1) {
+        printf("ERROR starting scheduler.\n");
+    }
 }
\ No newline at end of file
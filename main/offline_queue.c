@@ -0,0 +1,361 @@
+#include "offline_queue.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_partition.h"
+
+/**
+ * @brief Flash page header
+ *
+ * The consumed flag is cleared in place (1 -> 0 bits only) once a page has
+ * been uploaded, so marking a page does not need an erase.
+ *
+ */
+typedef struct {
+    uint32_t seq;               /**< Page sequence number, 0xFFFFFFFF if empty */
+    uint8_t count;              /**< Number of records in page */
+    uint8_t consumed;           /**< 0xFF pending, 0x00 uploaded */
+    uint16_t checksum;          /**< Checksum of seq, count and data */
+} page_header;
+
+/**
+ * @brief Flash page
+ *
+ * Records are packed with the telemetry encoding and the rest of the data is
+ * padded with 0xFF, so the checksum covers the same bytes on every page.
+ *
+ */
+typedef struct {
+    page_header header;
+    uint8_t data[QUEUE_PAGE_SIZE - sizeof(page_header)];
+} queue_page;
+
+#define PAGES_PER_SECTOR (QUEUE_SECTOR_SIZE / QUEUE_PAGE_SIZE)
+#define CONSUMED_OFFSET offsetof(page_header, consumed)
+#define PEEK_NONE -2
+#define PEEK_RAM -1
+
+static queue_storage storage;
+static bool ready = false;
+static int num_pages;
+static int head;                // Next page to write
+static int tail;                // Oldest pending page
+static uint32_t next_seq;
+static int flash_backlog;       // Pending records in flash
+static int dropped;
+static queue_page buffer;       // Page being filled in RAM
+static telemetry_packer packer; // Writes records into buffer
+static int peeked = PEEK_NONE;
+
+static int partition_read(void* ctx, uint32_t offset, void* dst, uint32_t len) {
+    return esp_partition_read(ctx, offset, dst, len) == ESP_OK ? 0 : -1;
+}
+
+static int partition_write(void* ctx, uint32_t offset, const void* src,
+    uint32_t len) {
+        return esp_partition_write(ctx, offset, src, len) == ESP_OK ? 0 : -1;
+}
+
+static int partition_erase(void* ctx, uint32_t offset, uint32_t len) {
+    return esp_partition_erase_range(ctx, offset, len) == ESP_OK ? 0 : -1;
+}
+
+static uint16_t page_checksum(const queue_page* page) {
+    // Fletcher-16 over everything but the checksum and consumed flag
+    uint16_t sum1 = 0;
+    uint16_t sum2 = 0;
+    const uint8_t* bytes = (const uint8_t*)&page->header.seq;
+    int len = sizeof(page->header.seq);
+    for (int i = 0; i < len; i++) {
+        sum1 = (sum1 + bytes[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+    sum1 = (sum1 + page->header.count) % 255;
+    sum2 = (sum2 + sum1) % 255;
+
+    bytes = page->data;
+    len = sizeof(page->data);
+    for (int i = 0; i < len; i++) {
+        sum1 = (sum1 + bytes[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+
+    return (sum2 << 8) | sum1;
+}
+
+static int read_header(int page, page_header* header) {
+    return storage.read(storage.ctx, page * QUEUE_PAGE_SIZE, header,
+        sizeof(page_header));
+}
+
+static int read_page(int page, queue_page* out) {
+    if (storage.read(storage.ctx, page * QUEUE_PAGE_SIZE, out,
+        sizeof(queue_page)) != 0) {
+            return -1;
+    }
+    if (out->header.count == 0 || out->header.count > QUEUE_PAGE_RECORDS ||
+        out->header.checksum != page_checksum(out)) {
+            return -1;
+    }
+
+    return 0;
+}
+
+static int unpack_page(const queue_page* page, queue_record* records) {
+    int count = unpack_records(page->data, sizeof(page->data), records,
+        page->header.count);
+
+    return count == page->header.count ? count : -1;
+}
+
+static void reset_buffer(void) {
+    pack_init(&packer, buffer.data, sizeof(buffer.data));
+    buffer.header.count = 0;
+}
+
+static bool header_pending(const page_header* header) {
+    return header->seq != 0xFFFFFFFF && header->consumed == 0xFF &&
+        header->count > 0 && header->count <= QUEUE_PAGE_RECORDS;
+}
+
+int queue_init_storage(const queue_storage* backend) {
+    if (backend == NULL || backend->size < QUEUE_SECTOR_SIZE) {
+        return -1;
+    }
+
+    storage = *backend;
+    num_pages = (storage.size / QUEUE_SECTOR_SIZE) * PAGES_PER_SECTOR;
+    flash_backlog = 0;
+    dropped = 0;
+    reset_buffer();
+    peeked = PEEK_NONE;
+
+    // Newest page holds the highest sequence number
+    int newest = -1;
+    uint32_t newest_seq = 0;
+    for (int i = 0; i < num_pages; i++) {
+        page_header header;
+        if (read_header(i, &header) != 0) {
+            return -1;
+        }
+        if (header.seq != 0xFFFFFFFF &&
+            (newest == -1 || header.seq > newest_seq)) {
+                newest = i;
+                newest_seq = header.seq;
+        }
+    }
+
+    if (newest == -1) {
+        // Empty storage, first write erases sector 0
+        head = 0;
+        tail = 0;
+        next_seq = 0;
+        ready = true;
+        return 0;
+    }
+
+    head = (newest + 1) % num_pages;
+    tail = head;
+    next_seq = newest_seq + 1;
+
+    // Oldest pending page is the tail, a page retired by a failed write can
+    // sit between pending pages and is skipped when draining
+    uint32_t oldest_seq = 0;
+    for (int i = 0; i < num_pages; i++) {
+        queue_page contents;
+        if (read_page(i, &contents) != 0 ||
+            !header_pending(&contents.header)) {
+                continue;
+        }
+        if (flash_backlog == 0 || contents.header.seq < oldest_seq) {
+            tail = i;
+            oldest_seq = contents.header.seq;
+        }
+        flash_backlog += contents.header.count;
+    }
+
+    ready = true;
+    return 0;
+}
+
+int queue_init(void) {
+    const esp_partition_t* partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+        QUEUE_PARTITION_LABEL);
+    if (partition == NULL) {
+        printf("ERROR finding \"%s\" partition.\n", QUEUE_PARTITION_LABEL);
+        return -1;
+    }
+
+    queue_storage backend = {
+        .read = partition_read,
+        .write = partition_write,
+        .erase = partition_erase,
+        .size = partition->size - (partition->size % QUEUE_SECTOR_SIZE),
+        .ctx = (void*)partition
+    };
+
+    return queue_init_storage(&backend);
+}
+
+static void drop_tail_page(void) {
+    page_header header;
+    if (read_header(tail, &header) == 0 && header_pending(&header)) {
+        dropped += header.count;
+        flash_backlog -= header.count;
+    }
+    tail = (tail + 1) % num_pages;
+}
+
+int queue_flush(void) {
+    if (!ready) {
+        return -1;
+    }
+    if (buffer.header.count == 0) {
+        return 0;
+    }
+
+    // Erase a sector only when the ring enters it
+    if (head % PAGES_PER_SECTOR == 0) {
+        // Oldest pending pages in the sector are overwritten
+        while (flash_backlog > 0 &&
+            tail / PAGES_PER_SECTOR == head / PAGES_PER_SECTOR) {
+                if (peeked == tail) {
+                    peeked = PEEK_NONE;
+                }
+                drop_tail_page();
+        }
+        if (storage.erase(storage.ctx, head * QUEUE_PAGE_SIZE,
+            QUEUE_SECTOR_SIZE) != 0) {
+                printf("ERROR erasing queue sector.\n");
+                return -1;
+        }
+    }
+
+    memset(buffer.data + packer.len, 0xFF, sizeof(buffer.data) - packer.len);
+    buffer.header.seq = next_seq;
+    buffer.header.consumed = 0xFF;
+    buffer.header.checksum = page_checksum(&buffer);
+
+    int status = storage.write(storage.ctx, head * QUEUE_PAGE_SIZE, &buffer,
+        sizeof(queue_page));
+
+    if (status != 0) {
+        // Page slot cannot be rewritten without an erase, so retire it and
+        // keep the records buffered for the next flush
+        uint8_t consumed = 0x00;
+        storage.write(storage.ctx, head * QUEUE_PAGE_SIZE + CONSUMED_OFFSET,
+            &consumed, 1);
+        head = (head + 1) % num_pages;
+        next_seq++;
+        printf("ERROR writing queue page.\n");
+        return -1;
+    }
+
+    if (flash_backlog == 0) {
+        tail = head;
+    }
+    head = (head + 1) % num_pages;
+    next_seq++;
+
+    flash_backlog += buffer.header.count;
+    reset_buffer();
+    if (peeked == PEEK_RAM) {
+        peeked = PEEK_NONE;
+    }
+
+    return 0;
+}
+
+int queue_push(const queue_record* record) {
+    if (!ready) {
+        return -1;
+    }
+
+    // Record does not fit, so the page is written and a new one started
+    if (pack_record(&packer, record) != 0) {
+        if (queue_flush() != 0 || pack_record(&packer, record) != 0) {
+            return -1;
+        }
+    }
+    buffer.header.count = packer.count;
+
+    if (packer.size - packer.len < TELEMETRY_RECORD_MIN) {
+        return queue_flush();
+    }
+
+    return 0;
+}
+
+int queue_peek(queue_record* records, int max) {
+    peeked = PEEK_NONE;
+    if (!ready || max < QUEUE_PAGE_RECORDS) {
+        return -1;
+    }
+
+    // Oldest records are in flash
+    while (flash_backlog > 0 && tail != head) {
+        queue_page contents;
+        int count;
+        if (read_page(tail, &contents) != 0 ||
+            !header_pending(&contents.header) ||
+            (count = unpack_page(&contents, records)) < 0) {
+                // Corrupted page, skip it
+                drop_tail_page();
+                continue;
+        }
+
+        peeked = tail;
+        return count;
+    }
+    flash_backlog = 0;
+
+    // Records not flushed yet
+    if (buffer.header.count > 0) {
+        peeked = PEEK_RAM;
+        return unpack_page(&buffer, records);
+    }
+
+    return 0;
+}
+
+int queue_pop(void) {
+    if (peeked == PEEK_NONE) {
+        return -1;
+    }
+
+    if (peeked == PEEK_RAM) {
+        reset_buffer();
+        peeked = PEEK_NONE;
+        return 0;
+    }
+
+    page_header header;
+    if (read_header(peeked, &header) != 0) {
+        return -1;
+    }
+
+    uint8_t consumed = 0x00;
+    if (storage.write(storage.ctx, peeked * QUEUE_PAGE_SIZE + CONSUMED_OFFSET,
+        &consumed, 1) != 0) {
+            printf("ERROR marking queue page.\n");
+            return -1;
+    }
+
+    flash_backlog -= header.count;
+    tail = (peeked + 1) % num_pages;
+    peeked = PEEK_NONE;
+
+    return 0;
+}
+
+int queue_backlog(void) {
+    return flash_backlog + buffer.header.count;
+}
+
+int queue_dropped(void) {
+    return dropped;
+}
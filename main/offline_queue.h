@@ -0,0 +1,171 @@
+/**
+ * @file offline_queue.h
+ * @brief Persistent store-and-forward queue for sensor records
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Provides an append-only ring buffer of packed sensor records kept on
+ * a dedicated flash partition. Readings that cannot be uploaded are
+ * queued and drained in batches once the WiFi connection is back. Records are
+ * collected in RAM and written to flash one page at a time, and a flash sector
+ * is only erased when the ring wraps around to it, which bounds flash wear.
+ *
+ * Flash access goes through a queue_storage structure so the queue can run
+ * against any partition-like backend (e.g. a file on a host machine).
+ *
+ */
+
+#ifndef OFFLINE_QUEUE_H
+#define OFFLINE_QUEUE_H
+
+#include <stdint.h>
+
+#include "telemetry.h"
+
+/**
+ * @def QUEUE_PARTITION_LABEL
+ * @brief Label of the flash partition used by the queue
+ *
+ * @note Partition must be declared in partitions.csv
+ *
+ */
+#define QUEUE_PARTITION_LABEL "offline"
+
+/**
+ * @def QUEUE_SECTOR_SIZE
+ * @brief Flash erase unit (in bytes)
+ *
+ */
+#define QUEUE_SECTOR_SIZE 4096
+
+/**
+ * @def QUEUE_PAGE_SIZE
+ * @brief Flash write unit (in bytes)
+ *
+ */
+#define QUEUE_PAGE_SIZE 256
+
+/**
+ * @def QUEUE_PAGE_RECORDS
+ * @brief Maximum number of records stored in one page
+ *
+ * Records are stored in the packed telemetry encoding, so a page holds fewer
+ * records when their timestamps are far apart.
+ *
+ * @see telemetry.h
+ *
+ */
+#define QUEUE_PAGE_RECORDS \
+    ((QUEUE_PAGE_SIZE - 8 - TELEMETRY_HEADER_SIZE) / TELEMETRY_RECORD_MIN)
+
+/**
+ * @brief Sensor record stored in the queue
+ *
+ */
+typedef telemetry_record queue_record;
+
+/**
+ * @brief Flash backend used by the queue
+ *
+ * Each callback returns 0 on success and -1 on failure. Offsets are relative
+ * to the start of the storage area.
+ *
+ */
+typedef struct {
+    int (*read)(void* ctx, uint32_t offset, void* dst, uint32_t len);
+    int (*write)(void* ctx, uint32_t offset, const void* src, uint32_t len);
+    int (*erase)(void* ctx, uint32_t offset, uint32_t len);
+    uint32_t size;              /**< Storage size, multiple of sector size */
+    void* ctx;                  /**< Backend context passed to callbacks */
+} queue_storage;
+
+/**
+ * @brief Initialize queue on the flash partition
+ *
+ * Finds the partition labelled QUEUE_PARTITION_LABEL and recovers any records
+ * left from before a reset.
+ *
+ * @retval 0 Success
+ * @retval -1 Partition not found
+ *
+ */
+int queue_init(void);
+
+/**
+ * @brief Initialize queue on a custom storage backend
+ *
+ * @param[in] storage Storage backend
+ *
+ * @retval 0 Success
+ * @retval -1 Invalid storage
+ *
+ */
+int queue_init_storage(const queue_storage* storage);
+
+/**
+ * @brief Add a record to the queue
+ *
+ * Records are buffered in RAM and written out when a page fills up or
+ * queue_flush() is called.
+ *
+ * @param[in] record Record to add
+ *
+ * @retval 0 Success
+ * @retval -1 Queue not initialized or write failed
+ *
+ */
+int queue_push(const queue_record* record);
+
+/**
+ * @brief Write buffered records to flash
+ *
+ * @retval 0 Success
+ * @retval -1 Write failed
+ *
+ * @note Call at the end of every cycle that pushed records so they survive a
+ * reset.
+ *
+ */
+int queue_flush(void);
+
+/**
+ * @brief Read the oldest batch of records without removing it
+ *
+ * @param[out] records Destination for records
+ * @param[in] max Size of records, at least QUEUE_PAGE_RECORDS
+ *
+ * @return Number of records read, 0 if the queue is empty
+ * @retval -1 Read failed
+ *
+ * @see queue_pop()
+ *
+ */
+int queue_peek(queue_record* records, int max);
+
+/**
+ * @brief Remove the batch returned by the last queue_peek()
+ *
+ * @retval 0 Success
+ * @retval -1 Write failed
+ *
+ */
+int queue_pop(void);
+
+/**
+ * @brief Number of records waiting for upload
+ *
+ * @return Backlog count
+ *
+ */
+int queue_backlog(void);
+
+/**
+ * @brief Number of records overwritten before upload
+ *
+ * @return Dropped record count since boot
+ *
+ */
+int queue_dropped(void);
+
+#endif
@@ -0,0 +1,222 @@
+#include "param_stream.h"
+
+#include "planter_utils.h"
+#include "rest_api.h"
+#include "secrets.h"
+
+static volatile bool connected = false;
+
+static esp_http_client_handle_t open_stream(void) {
+    char* url = make_url("parameters", FIREBASE_URL, FIREBASE_API_KEY);
+    if (url == NULL) {
+        return NULL;
+    }
+
+    esp_http_client_config_t config = {
+        .url = url,
+        .cert_pem = certificate_pem_start,
+        .timeout_ms = STREAM_TIMEOUT,
+        .keep_alive_enable = true
+    };
+
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    free(url);
+    if (client == NULL) {
+        printf("Error initializing stream client.\n");
+        return NULL;
+    }
+    esp_http_client_set_header(client, "Accept", "text/event-stream");
+
+    // Firebase redirects streams to the server holding the database
+    for (int i = 0; i < 3; i++) {
+        if (esp_http_client_open(client, 0) != ESP_OK) {
+            printf("ERROR opening parameter stream.\n");
+            break;
+        }
+        esp_http_client_fetch_headers(client);
+
+        int status = esp_http_client_get_status_code(client);
+        if (status == 200) {
+            return client;
+        }
+        if (status != 307 && status != 302) {
+            printf("ERROR parameter stream status: %d\n", status);
+            break;
+        }
+
+        esp_http_client_set_redirection(client);
+        esp_http_client_close(client);
+    }
+
+    close_client(client);
+    return NULL;
+}
+
+/**
+ * @brief Server-sent event reader state
+ *
+ */
+typedef struct {
+    char field[8];              /**< Field name of current line */
+    int field_len;
+    bool in_value;              /**< Past the ':' of current line */
+    bool skip_space;            /**< Drop one space after ':' */
+    char event[16];             /**< Name of current event */
+    int event_len;
+    bool parsing;               /**< Feeding data line to binder */
+    params_binder binder;
+} sse_reader;
+
+static void end_data(sse_reader* reader) {
+    reader->parsing = false;
+
+    // Report back only when a setting changed, our own PATCH of the
+    // confirmation values is echoed as an event too
+    if (params_end(&reader->binder) == 1) {
+        printf("Parameters updated: %d hours, %d s.\n", num_watering_times,
+            water_duration);
+        confirm_parameters();
+    }
+}
+
+static void end_line(sse_reader* reader) {
+    if (reader->parsing) {
+        end_data(reader);
+    }
+    else if (!reader->in_value && reader->field_len == 0) {
+        // Blank line ends an event
+        reader->event_len = 0;
+        reader->event[0] = '\0';
+    }
+    else if (strcmp(reader->field, "event") == 0) {
+        reader->event[reader->event_len] = '\0';
+        if (strcmp(reader->event, "cancel") == 0 ||
+            strcmp(reader->event, "auth_revoked") == 0) {
+                printf("Parameter stream closed by server: %s\n",
+                    reader->event);
+                connected = false;
+        }
+    }
+
+    reader->field_len = 0;
+    reader->field[0] = '\0';
+    reader->in_value = false;
+}
+
+static void start_value(sse_reader* reader) {
+    reader->in_value = true;
+    reader->skip_space = true;
+    reader->field[reader->field_len] = '\0';
+
+    if (strcmp(reader->field, "event") == 0) {
+        reader->event_len = 0;
+    }
+    else if (strcmp(reader->field, "data") == 0 &&
+        (strcmp(reader->event, "put") == 0 ||
+        strcmp(reader->event, "patch") == 0)) {
+            params_begin(&reader->binder, 1);
+            reader->parsing = true;
+    }
+}
+
+static void read_stream(esp_http_client_handle_t client) {
+    // Holds a whole binder, kept off the stack TLS runs on
+    sse_reader* reader = calloc(1, sizeof(sse_reader));
+    if (reader == NULL) {
+        printf("ERROR allocating parameter stream reader.\n");
+        return;
+    }
+
+    while (connected) {
+        char chunk[128];
+        int read_len = esp_http_client_read(client, chunk, sizeof(chunk));
+        if (read_len <= 0) {
+            // Keep-alive events stopped or connection closed
+            break;
+        }
+
+        // Start of event data in chunk, fed to the binder in one piece
+        int data_start = -1;
+        for (int i = 0; i < read_len && connected; i++) {
+            char c = chunk[i];
+            if (c == '\r') {
+                continue;
+            }
+
+            if (c == '\n') {
+                if (data_start >= 0) {
+                    params_feed(&reader->binder, chunk + data_start,
+                        i - data_start);
+                    data_start = -1;
+                }
+                end_line(reader);
+                continue;
+            }
+
+            if (!reader->in_value) {
+                if (c == ':') {
+                    start_value(reader);
+                }
+                else if (reader->field_len < (int)sizeof(reader->field) - 1) {
+                    reader->field[reader->field_len++] = c;
+                }
+                continue;
+            }
+
+            if (reader->skip_space) {
+                reader->skip_space = false;
+                if (c == ' ') {
+                    continue;
+                }
+            }
+
+            if (reader->parsing) {
+                if (data_start < 0) {
+                    data_start = i;
+                }
+            }
+            else if (strcmp(reader->field, "event") == 0 &&
+                reader->event_len < (int)sizeof(reader->event) - 1) {
+                    reader->event[reader->event_len++] = c;
+            }
+        }
+
+        // Event data continues in the next chunk
+        if (data_start >= 0) {
+            params_feed(&reader->binder, chunk + data_start,
+                read_len - data_start);
+        }
+    }
+
+    free(reader);
+}
+
+void param_stream_task(void *pvParameters) {
+    int retry_delay = 5000;
+
+    while (1) {
+        esp_http_client_handle_t client = open_stream();
+        if (client != NULL) {
+            printf("Parameter stream connected.\n");
+            connected = true;
+            retry_delay = 5000;
+
+            read_stream(client);
+
+            connected = false;
+            close_client(client);
+            printf("Parameter stream dropped, polling.\n");
+        }
+
+        // Back off while polling covers for the stream
+        vTaskDelay(pdMS_TO_TICKS(retry_delay));
+        retry_delay *= 2;
+        if (retry_delay > STREAM_RETRY_MAX) {
+            retry_delay = STREAM_RETRY_MAX;
+        }
+    }
+}
+
+bool param_stream_connected(void) {
+    return connected;
+}
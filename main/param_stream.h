@@ -0,0 +1,60 @@
+/**
+ * @file param_stream.h
+ * @brief Firebase event stream for watering parameters
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Holds a single "Accept: text/event-stream" connection on the
+ * parameters table and applies "put"/"patch" events to the watering values as
+ * soon as they arrive. Event data is fed to the parameters binder as it is
+ * read, so events of any length are handled with fixed memory. While the
+ * stream is connected, polling with parameter_comms() is not needed.
+ *
+ */
+
+#ifndef PARAM_STREAM_H
+#define PARAM_STREAM_H
+
+#include <stdbool.h>
+
+/**
+ * @def STREAM_TIMEOUT
+ * @brief Time without data before the stream is considered dropped (in ms)
+ *
+ * @note Firebase sends a keep-alive event every 30 seconds.
+ *
+ */
+#define STREAM_TIMEOUT 60000
+
+/**
+ * @def STREAM_RETRY_MAX
+ * @brief Longest delay between reconnection attempts (in ms)
+ *
+ */
+#define STREAM_RETRY_MAX 300000
+
+/**
+ * @brief Keep the parameters event stream open
+ *
+ * Connects to the parameters table, applies stream events to the watering
+ * values and confirms changes with confirm_parameters(). Reconnects with
+ * increasing delay when the stream drops.
+ *
+ * @param[in] pvParameters unused
+ *
+ * @see param_stream_connected()
+ *
+ */
+void param_stream_task(void *pvParameters);
+
+/**
+ * @brief Check if the parameters event stream is connected
+ *
+ * @retval true Stream connected, polling not needed
+ * @retval false Stream down, parameters must be polled
+ *
+ */
+bool param_stream_connected(void);
+
+#endif
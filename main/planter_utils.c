@@ -1,7 +1,23 @@
 #include "planter_utils.h"
 
-int watering_times[2] = {-1, -1};
-int water_duration = 1;
+#include "esp_attr.h"
+#include "scheduler.h"
+
+// Kept in RTC memory so parameters survive deep sleep
+RTC_DATA_ATTR int watering_times[MAX_WATERING_TIMES];
+RTC_DATA_ATTR int num_watering_times = 0;
+RTC_DATA_ATTR int water_duration = 1;
+RTC_DATA_ATTR int moisture_low = 0;
+RTC_DATA_ATTR int moisture_high = 0;
+RTC_DATA_ATTR valve_times valve_schedules[MAX_VALVE_SCHEDULES];
+RTC_DATA_ATTR int num_valve_schedules = 0;
+
+static portMUX_TYPE params_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Local time of the current minute
+static portMUX_TYPE clock_lock = portMUX_INITIALIZER_UNLOCKED;
+static struct tm cached_time;
+static time_t cached_minute = -1;
 
 void button_interrupt(char* str) {
     // Print message
@@ -16,274 +32,539 @@ void button_interrupt(char* str) {
     }
 }
 
-void display_rgb(const int r, const int g, const int b, const int delay) {
-    static led_strip_handle_t led_strip;
-
-    // Configure strip to include RGB pin on board
-    led_strip_config_t strip_config = {
-        .strip_gpio_num = RGB_PIN,
-        .max_leds = 1
-    };
-    led_strip_rmt_config_t rmt_config = {
-        .resolution_hz = 10 * 1000 * 1000
-    };
-    led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip);
-
-    // Set pixel to RGB values
-    led_strip_set_pixel(led_strip, 0, r, g, b);
-    led_strip_refresh(led_strip);
-
-    // Keep RGB on for specified number of seconds
-    vTaskDelay(delay / portTICK_PERIOD_MS);
-
-    // Turn off RGB
-    led_strip_clear(led_strip);
-    
-    // Remove LED strip device
-    led_strip_del(led_strip);
+void print_current_time(void) {
+    time_t now;
+    char strftime_buf[64];
+    struct tm timeinfo;
+
+    time(&now);
+
+    localtime_r(&now, &timeinfo);
+    strftime(strftime_buf, sizeof(strftime_buf), "%c", &timeinfo);
+    printf("The current time in Los Angeles is: %s\n", strftime_buf);
 }
 
-int init_wifi(void) {
-    // Initialize NVS partition
-    if (nvs_flash_init() != ESP_OK) {
-        printf("ERROR initializing NVS flash.\n");
-        return -1;
+void get_local_time(struct tm* timeinfo) {
+    time_t now = time(NULL);
+    time_t minute = now - now % 60;
+
+    taskENTER_CRITICAL(&clock_lock);
+    bool cached = minute == cached_minute;
+    if (cached) {
+        *timeinfo = cached_time;
     }
+    taskEXIT_CRITICAL(&clock_lock);
 
-    // Initialize TCP/IP stack
-    if (esp_netif_init() != ESP_OK) {
-        printf("ERROR initializing NETIF.\n");
-        return -1;
+    if (cached) {
+        timeinfo->tm_sec = now % 60;
+        return;
     }
 
-    // Initialize event loop for creating wifi station
-    if (esp_event_loop_create_default() != ESP_OK) {
-        printf("ERROR creating event loop.\n");
-        return -1;
+    // Time zone rules only evaluated once per minute
+    localtime_r(&now, timeinfo);
+
+    taskENTER_CRITICAL(&clock_lock);
+    cached_time = *timeinfo;
+    cached_minute = minute;
+    taskEXIT_CRITICAL(&clock_lock);
+}
+
+int get_current_month(void) {
+    struct tm timeinfo;
+    get_local_time(&timeinfo);
+
+    return timeinfo.tm_mon+1;
+}
+
+int get_current_day(void) {
+    struct tm timeinfo;
+    get_local_time(&timeinfo);
+
+    return timeinfo.tm_mday;
+}
+
+int get_current_hour(void) {
+    struct tm timeinfo;
+    get_local_time(&timeinfo);
+
+    return timeinfo.tm_hour;
+}
+
+int get_current_min(void) {
+    struct tm timeinfo;
+    get_local_time(&timeinfo);
+
+    return timeinfo.tm_min;
+}
+
+static void path_component(const params_binder* binder,
+    const json_parser* parser, int base, int n, const char** key, int* index) {
+        // Components from the event path come first
+        if (n < binder->path_len) {
+            *key = binder->path[n];
+            *index = (*key[0] >= '0' && *key[0] <= '9') ? atoi(*key) : -1;
+            return;
+        }
+
+        // Followed by the elements below the parsed value
+        int level = base + 1 + (n - binder->path_len);
+        *key = json_path_key(parser, level);
+        *index = json_path_index(parser, level);
+}
+
+static void set_event_path(params_binder* binder, const char* value, int len) {
+    binder->path_set = true;
+    binder->path_len = 0;
+
+    // Split "/a/b" into components
+    int i = 0;
+    while (i < len) {
+        while (i < len && value[i] == '/') {
+            i++;
+        }
+        int start = i;
+        while (i < len && value[i] != '/') {
+            i++;
+        }
+        if (i == start) {
+            break;
+        }
+        if (binder->path_len == 3) {
+            // Deeper paths are not parameters used by the device
+            binder->path_len++;
+            break;
+        }
+
+        int comp_len = i - start < JSON_KEY_MAX - 1 ? i - start : 
+            JSON_KEY_MAX - 1;
+        memcpy(binder->path[binder->path_len], value + start, comp_len);
+        binder->path[binder->path_len][comp_len] = '\0';
+        binder->path_len++;
     }
-    esp_netif_create_default_wifi_sta();
+}
 
-    // Initialize WiFi with default config
-    wifi_init_config_t default_config = WIFI_INIT_CONFIG_DEFAULT();
-    if (esp_wifi_init(&default_config) != ESP_OK) {
-        printf("ERROR initializing WiFi.\n");
-        return -1;
+static void set_time_entry(int* times, int* num_times, int index, int hour) {
+    // Entries skipped by a sparse update are unused
+    for (int i = *num_times; i < index; i++) {
+        times[i] = -1;
     }
 
-    // Set WiFi parameters
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = USER_SSID,
-            .password = USER_PASS,
-            .sae_pwe_h2e = WPA3_SAE_PWE_HUNT_AND_PECK,
-            .failure_retry_cnt = 3
-        }
-    };
-    if (esp_wifi_set_mode(WIFI_MODE_STA) != ESP_OK) {
-        printf("ERROR setting WiFi mode.\n");
-        return -1;
+    times[index] = hour;
+    if (index >= *num_times) {
+        *num_times = index + 1;
     }
-    if (esp_wifi_set_config(WIFI_IF_STA, &wifi_config) != ESP_OK) {
-        printf("ERROR setting WiFi config.\n");
-        return -1;
+}
+
+static void load_valve_entries(planter_params* params) {
+    // Single valve changed, keep the others
+    if (params->num_valves == -1) {
+        taskENTER_CRITICAL(&params_lock);
+        params->num_valves = num_valve_schedules;
+        memcpy(params->valves, valve_schedules, sizeof(valve_schedules));
+        taskEXIT_CRITICAL(&params_lock);
     }
+}
 
-    // Start WiFi
-    if (esp_wifi_start() != ESP_OK) {
-        printf("ERROR starting WiFi.\n");
-        return -1;
+static valve_times* find_valve_entry(planter_params* params, const char* name) {
+    load_valve_entries(params);
+
+    for (int i = 0; i < params->num_valves; i++) {
+        if (strcmp(params->valves[i].valve, name) == 0) {
+            return &params->valves[i];
+        }
     }
-    
-    // Attemp WiFi connection
-    if (esp_wifi_connect() != ESP_OK) {
-        printf("WiFi connect unsuccessful.\n");
-        return -1;
+    if (params->num_valves == MAX_VALVE_SCHEDULES) {
+        return NULL;
     }
 
-    vTaskDelay(pdMS_TO_TICKS(7000));
+    valve_times* entry = &params->valves[params->num_valves];
+    memset(entry, 0, sizeof(valve_times));
+    strlcpy(entry->valve, name, sizeof(entry->valve));
+    params->num_valves++;
 
-    return 0;
+    return entry;
 }
 
-int check_wifi(void) {
-    wifi_ap_record_t ap_info;
-    if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
-        if (esp_wifi_connect() != ESP_OK) {
-            return -1;
+static void remove_valve_entry(planter_params* params, const char* name) {
+    load_valve_entries(params);
+
+    for (int i = 0; i < params->num_valves; i++) {
+        if (strcmp(params->valves[i].valve, name) == 0) {
+            params->valves[i] = params->valves[params->num_valves - 1];
+            params->num_valves--;
+            return;
         }
-        return 1;
     }
-
-    return 0;
 }
 
-void calibrate_time(void) {
-    sntp_set_sync_interval(15000);
-    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
-    esp_sntp_setservername(0, "pool.ntp.org");
-    esp_sntp_init();
-    
-    // 16 second delay to account for sync time
-    vTaskDelay(16000 / portTICK_PERIOD_MS);
-
-    // Set timezone to PST
-    setenv("TZ", "PST8PDT,M3.2.0,M11.1.0", 1);
-    tzset();
-}
+static void params_callback(const json_parser* parser, json_type type,
+    const char* value, int len, void* ctx) {
+        params_binder* binder = (params_binder*)ctx;
+        planter_params* params = &binder->params;
+
+        // Stream events wrap the changed value in {"path": ..., "data": ...}
+        int base = 0;
+        if (binder->event) {
+            const char* envelope_key = json_path_key(parser, 1);
+            if (envelope_key == NULL) {
+                return;
+            }
+            if (parser->depth == 1 && type == JSON_STRING &&
+                strcmp(envelope_key, "path") == 0) {
+                    set_event_path(binder, value, len);
+                    return;
+            }
+            if (!binder->path_set || strcmp(envelope_key, "data") != 0) {
+                return;
+            }
+            base = 1;
+        }
 
-void print_current_time(void) {
-    time_t now;
-    char strftime_buf[64];
-    struct tm timeinfo;
+        int num_components = binder->path_len + parser->depth - base;
+        if (num_components < 1 || num_components > 3) {
+            return;
+        }
 
-    time(&now);
+        const char* key;
+        int index;
+        path_component(binder, parser, base, 0, &key, &index);
+        if (key == NULL) {
+            return;
+        }
 
-    localtime_r(&now, &timeinfo);
-    strftime(strftime_buf, sizeof(strftime_buf), "%c", &timeinfo);
-    printf("The current time in Los Angeles is: %s\n", strftime_buf);
+        if (strcmp(key, "Water_Duration_Set") == 0) {
+            if (num_components == 1 && type == JSON_NUMBER) {
+                // Milliseconds of the duration must fit in an int
+                int duration = json_to_int(value, len);
+                if (duration > MAX_WATER_DURATION) {
+                    printf("ERROR watering duration %d s too long.\n",
+                        duration);
+                    return;
+                }
+                params->water_duration = duration;
+            }
+        }
+        else if (strcmp(key, "Moisture_Low_Set") == 0 ||
+            strcmp(key, "Moisture_High_Set") == 0) {
+                if (num_components != 1) {
+                    return;
+                }
+
+                // Removing either bound turns closed-loop watering off
+                int* bound = strcmp(key, "Moisture_Low_Set") == 0 ? 
+                    &params->moisture_low : &params->moisture_high;
+                if (type == JSON_NUMBER) {
+                    *bound = json_to_int(value, len);
+                }
+                else if (type == JSON_NULL) {
+                    params->moisture_low = 0;
+                    params->moisture_high = 0;
+                }
+        }
+        else if (strcmp(key, "Water_Times_Set") == 0) {
+            if (num_components == 1 && type == JSON_ARRAY_START) {
+                // Whole array replaced
+                params->num_times = 0;
+            }
+            else if (num_components == 2 && type == JSON_NUMBER) {
+                path_component(binder, parser, base, 1, &key, &index);
+                if (index < 0 || index >= MAX_WATERING_TIMES) {
+                    return;
+                }
+
+                // Single entry changed, keep the others
+                if (params->num_times == -1) {
+                    taskENTER_CRITICAL(&params_lock);
+                    params->num_times = num_watering_times;
+                    memcpy(params->watering_times, watering_times,
+                        sizeof(watering_times));
+                    taskEXIT_CRITICAL(&params_lock);
+                }
+                set_time_entry(params->watering_times, &params->num_times,
+                    index, json_to_int(value, len));
+            }
+        }
+        else if (strcmp(key, "Valve_Times_Set") == 0) {
+            if (num_components == 1) {
+                // Whole map replaced or deleted
+                if (type == JSON_OBJECT_START || type == JSON_NULL) {
+                    params->num_valves = 0;
+                }
+                return;
+            }
+
+            const char* name;
+            path_component(binder, parser, base, 1, &name, &index);
+            if (name == NULL) {
+                return;
+            }
+
+            if (num_components == 2 && type == JSON_NULL) {
+                remove_valve_entry(params, name);
+            }
+            else if (num_components == 2 && type == JSON_ARRAY_START) {
+                valve_times* entry = find_valve_entry(params, name);
+                if (entry != NULL) {
+                    entry->num_times = 0;
+                }
+            }
+            else if (num_components == 3 && type == JSON_NUMBER) {
+                path_component(binder, parser, base, 2, &key, &index);
+                if (index < 0 || index >= MAX_WATERING_TIMES) {
+                    return;
+                }
+
+                valve_times* entry = find_valve_entry(params, name);
+                if (entry != NULL) {
+                    set_time_entry(entry->times, &entry->num_times, index,
+                        json_to_int(value, len));
+                }
+            }
+        }
 }
 
-int get_current_month(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-
-    time_t now = tv.tv_sec;
-    struct tm* timeinfo = localtime(&now);
+void params_begin(params_binder* binder, int event) {
+    memset(binder, 0, sizeof(params_binder));
+    binder->event = event;
+    binder->params.water_duration = -1;
+    binder->params.moisture_low = -1;
+    binder->params.moisture_high = -1;
+    binder->params.num_times = -1;
+    binder->params.num_valves = -1;
+    json_init(&binder->parser, params_callback, binder);
+}
 
-    return timeinfo->tm_mon+1;
+int params_feed(params_binder* binder, const char* data, int len) {
+    return json_feed(&binder->parser, data, len);
 }
 
-int get_current_day(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
+static bool same_valve_entries(const planter_params* params) {
+    if (params->num_valves != num_valve_schedules) {
+        return false;
+    }
 
-    time_t now = tv.tv_sec;
-    struct tm* timeinfo = localtime(&now);
+    for (int i = 0; i < params->num_valves; i++) {
+        const valve_times* a = &params->valves[i];
+        const valve_times* b = &valve_schedules[i];
+        if (strcmp(a->valve, b->valve) != 0 || a->num_times != b->num_times ||
+            memcmp(a->times, b->times, a->num_times * sizeof(int)) != 0) {
+                return false;
+        }
+    }
 
-    return timeinfo->tm_mday;
+    return true;
 }
 
-int get_current_hour(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
+int params_end(params_binder* binder) {
+    if (json_finish(&binder->parser) == -1) {
+        printf("ERROR when parsing parameter JSON.\n");
+        return -1;
+    }
 
-    time_t now = tv.tv_sec;
-    struct tm* timeinfo = localtime(&now);
+    planter_params* params = &binder->params;
+    int changed = 0;
 
-    return timeinfo->tm_hour;
-}
+    // Firebase leaves out empty maps, so no entry means no valve overrides
+    if (!binder->event && params->num_valves == -1) {
+        params->num_valves = 0;
+    }
 
-int get_current_min(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
+    // It also deletes null values, so a missing bound turns closed-loop
+    // watering off
+    if (!binder->event &&
+        (params->moisture_low == -1 || params->moisture_high == -1)) {
+            params->moisture_low = 0;
+            params->moisture_high = 0;
+    }
 
-    time_t now = tv.tv_sec;
-    struct tm* timeinfo = localtime(&now);
+    // Update values on ESP32 if needed
+    taskENTER_CRITICAL(&params_lock);
+    if (params->num_times >= 0 && (params->num_times != num_watering_times ||
+        memcmp(params->watering_times, watering_times,
+            params->num_times * sizeof(int)) != 0)) {
+                memcpy(watering_times, params->watering_times,
+                    params->num_times * sizeof(int));
+                num_watering_times = params->num_times;
+                changed = 1;
+    }
+    if (params->water_duration >= 0 &&
+        params->water_duration != water_duration) {
+            water_duration = params->water_duration;
+            changed = 1;
+    }
+    if (params->moisture_low >= 0 && params->moisture_low != moisture_low) {
+        moisture_low = params->moisture_low;
+        changed = 1;
+    }
+    if (params->moisture_high >= 0 && 
+        params->moisture_high != moisture_high) {
+            moisture_high = params->moisture_high;
+            changed = 1;
+    }
+    if (params->num_valves >= 0 && !same_valve_entries(params)) {
+        memcpy(valve_schedules, params->valves,
+            params->num_valves * sizeof(valve_times));
+        num_valve_schedules = params->num_valves;
+        changed = 1;
+    }
+    taskEXIT_CRITICAL(&params_lock);
 
-    return timeinfo->tm_min;
+    if (changed) {
+        scheduler_recompute();
+    }
+
+    return changed;
 }
 
-float get_chip_temp() {
-    temperature_sensor_handle_t temp_handle = NULL;
-    temperature_sensor_config_t temp_sensor_config_low = 
-        TEMPERATURE_SENSOR_CONFIG_DEFAULT(-10, 80);
-    if (temperature_sensor_install(&temp_sensor_config_low, &temp_handle) != ESP_OK) {
-        return -1.00;
+int get_watering_times(const char* valve_name, int* times) {
+    int num_times = 0;
+
+    taskENTER_CRITICAL(&params_lock);
+    const int* source = watering_times;
+    num_times = num_watering_times;
+    for (int i = 0; i < num_valve_schedules; i++) {
+        if (strcmp(valve_schedules[i].valve, valve_name) == 0) {
+            source = valve_schedules[i].times;
+            num_times = valve_schedules[i].num_times;
+            break;
+        }
     }
+    memcpy(times, source, num_times * sizeof(int));
+    taskEXIT_CRITICAL(&params_lock);
 
-    temperature_sensor_enable(temp_handle);
+    return num_times;
+}
 
-    float tsens_out = -1;    
-    temperature_sensor_get_celsius(temp_handle, &tsens_out);
-    temperature_sensor_disable(temp_handle);
+static int feed_params(const char* data, int len, void* ctx) {
+    return params_feed((params_binder*)ctx, data, len);
+}
 
-    temperature_sensor_uninstall(temp_handle);
-    return tsens_out;
+/**
+ * @brief Watering parameters in use, copied for the confirmation request
+ * 
+ */
+typedef struct {
+    int times[MAX_WATERING_TIMES];
+    int num_times;
+    int duration;
+    int moisture_low;
+    int moisture_high;
+    valve_times valves[MAX_VALVE_SCHEDULES];
+    int num_valves;
+} params_snapshot;
+
+static void write_times(rest_writer* writer, const int* times, 
+    int num_times) {
+        rest_write(writer, "[", 1);
+        for (int i = 0; i < num_times; i++) {
+            rest_printf(writer, "%s%d", i == 0 ? "" : ", ", times[i]);
+        }
+        rest_write(writer, "]", 1);
 }
 
-int parameter_comms() {
-    // Create client for GET request
-    esp_http_client_handle_t client = setup_client("parameters", 
-            FIREBASE_URL, FIREBASE_API_KEY);
-        
-    char return_data[150];
-    if (get_data(client, return_data, 150)== -1) {
-        printf("ERROR executing GET request.\n");
-        printf("%s\n", return_data);
+static int write_confirm(rest_writer* writer, void* ctx) {
+    const params_snapshot* params = (const params_snapshot*)ctx;
+
+    rest_printf(writer,
+        "{\"Water_Duration_Confirm\": %d, "
+        "\"Moisture_Low_Confirm\": %d, "
+        "\"Moisture_High_Confirm\": %d, "
+        "\"Water_Times_Confirm\": ",
+        params->duration,
+        params->moisture_low,
+        params->moisture_high
+    );
+    write_times(writer, params->times, params->num_times);
+
+    rest_printf(writer, ", \"Valve_Times_Confirm\": {");
+    for (int i = 0; i < params->num_valves; i++) {
+        rest_printf(writer, "%s\"%s\": ", i == 0 ? "" : ", ", 
+            params->valves[i].valve);
+        write_times(writer, params->valves[i].times, 
+            params->valves[i].num_times);
+    }
+
+    return rest_write(writer, "}}", 2);
+}
+
+static int patch_confirm(esp_http_client_handle_t client) {
+    // Snapshot of values in use, on the heap as TLS needs the task stack
+    params_snapshot* params = malloc(sizeof(params_snapshot));
+    if (params == NULL) {
+        printf("ERROR allocating parameter snapshot.\n");
+        return -1;
+    }
+    taskENTER_CRITICAL(&params_lock);
+    params->num_times = num_watering_times;
+    params->duration = water_duration;
+    params->moisture_low = moisture_low;
+    params->moisture_high = moisture_high;
+    params->num_valves = num_valve_schedules;
+    memcpy(params->times, watering_times, sizeof(params->times));
+    memcpy(params->valves, valve_schedules, sizeof(params->valves));
+    taskEXIT_CRITICAL(&params_lock);
+
+    int status = stream_request(client, HTTP_METHOD_PATCH, "application/json", 
+        REST_ENCODING_IDENTITY, write_confirm, params);
+    free(params);
+    if (status == -1) {
+        printf("ERROR patching parameters.\n");
         return -1;
     }
 
-    // Values returned from server
-    int nums_set[2];
-    int water_time;
+    return 0;
+}
 
-    char* duration_set_ptr = strstr(return_data, "\"Water_Duration_Set\"");
-    if (duration_set_ptr == NULL) {
-        printf("ERROR when parsing duration JSON: \"Water_Duration_Set\"");
+int confirm_parameters(void) {
+    esp_http_client_handle_t client = acquire_client("parameters", 
+            FIREBASE_URL, FIREBASE_API_KEY);
+    if (client == NULL) {
         return -1;
     }
-    char* duration_set_comma_ptr = strstr(duration_set_ptr, ":");
-    char* duration_set_val = duration_set_comma_ptr + 1;
-    water_time = atoi(duration_set_val);
-
-    // Find first occurance of "Water_Times_Set"
-    char* times_set_ptr = strstr(return_data, "\"Water_Times_Set\"");
-    if (times_set_ptr == NULL) {
-        printf("ERROR when parsing parameter JSON: \"Water_Times_Set\".\n");
+
+    int status = patch_confirm(client);
+    release_client(client, status == -1);
+
+    return status;
+}
+
+int parameter_comms() {
+    // Borrow pooled client for GET and PATCH requests
+    esp_http_client_handle_t client = acquire_client("parameters", 
+            FIREBASE_URL, FIREBASE_API_KEY);
+    if (client == NULL) {
         return -1;
     }
-    char* times_set_val1_ptr = strstr(times_set_ptr, "[");
-    if (times_set_val1_ptr == NULL) {
-        printf("ERROR when parsing parameter JSON: '['.\n");
+        
+    // Parse response as it is received, parser state kept off the stack
+    params_binder* binder = malloc(sizeof(params_binder));
+    if (binder == NULL) {
+        printf("ERROR allocating parameter parser.\n");
+        release_client(client, 0);
         return -1;
     }
-    
-    // Get first hour
-    char* times_set_num_first = times_set_val1_ptr + 1;
-    nums_set[0] = atoi(times_set_num_first);
-
-    // Get second hour
-    char* times_set_val2_ptr = strstr(times_set_num_first, ",");
-    if (times_set_val2_ptr == NULL) {
-        printf("ERROR when parsing parameter JSON: ','.\n");
+    params_begin(binder, 0);
+    if (get_stream(client, feed_params, binder) == -1) {
+        printf("ERROR executing GET request.\n");
+        free(binder);
+        release_client(client, 1);
         return -1;
     }
-    char* times_set_num_second = times_set_val2_ptr + 1;
-    nums_set[1] = atoi(times_set_num_second);
 
-    // Update hours on ESP32 if needed
-    for (int i = 0; i < 2; i++) {
-        if (watering_times[i] != nums_set[i]) {
-            watering_times[i] = nums_set[i];
-        }
-    }
-    if (water_time != water_duration) {
-        water_duration = water_time;
+    int status = params_end(binder);
+    free(binder);
+    if (status == -1) {
+        release_client(client, 0);
+        return -1;
     }
 
-    // Cleanup GET client
-    esp_http_client_cleanup(client);
-
-    // Create PATCH client
-    client = setup_client("parameters", FIREBASE_URL, FIREBASE_API_KEY);
-
-    char patch_json[150];
-    snprintf(patch_json, 150, 
-        "{\"Chip_Temp\": %f, "
-        "\"Water_Duration_Confirm\": %d, "
-        "\"Water_Times_Confirm\": [%d, %d]}",
-        get_chip_temp(),
-        water_duration,
-        watering_times[0],
-        watering_times[1]
-    );
-    
-    if (patch_data(client, patch_json) == -1) {
-        printf("ERROR patching parameters.\n");
+    // Reuse the same connection for the PATCH request
+    if (patch_confirm(client) == -1) {
+        release_client(client, 1);
         return -1;
     }
 
-    esp_http_client_cleanup(client);
+    release_client(client, 0);
 
     return 0;
 
@@ -16,104 +16,104 @@
 
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
-#include "driver/temperature_sensor.h"
 #include "esp_mac.h"
 #include "esp_wifi.h"
-#include "led_strip.h"
 #include "esp_sntp.h"
 #include "esp_tls.h"
 #include "nvs_flash.h"
+#include "json_stream.h"
 #include "rest_api.h"
 #include "secrets.h"
+#include "status_led.h"
+#include "time_sync.h"
+#include "wifi_manager.h"
 
 /**
- * @brief Watering times
+ * @def MAX_WATERING_TIMES
+ * @brief Maximum number of watering hours per day
  * 
  */
-extern int watering_times[2];
+#define MAX_WATERING_TIMES 24
 
 /**
- * @brief Duration to keep solenoid valve open
+ * @brief Watering times (hours of day)
  * 
  */
-extern int water_duration;
+extern int watering_times[MAX_WATERING_TIMES];
 
 /**
- * @def RGB_PIN
- * @brief GPIO pin number for RGB control
- * 
- * @note This pin number can be different for every development board. Please
- * check to make sure this matches your boards.
+ * @brief Number of entries used in watering_times
  * 
  */
-#define RGB_PIN 38
+extern int num_watering_times;
 
 /**
- * @brief Wait for button press with prompt message
- * 
- * Displays a prompt message and blocks execution of code until the button is
- * pressed.
- * 
- * @param[in] str Prompt message to display
+ * @def MAX_WATER_DURATION
+ * @brief Longest accepted watering duration (in seconds)
  * 
  */
-void button_interrupt(char* str);
+#define MAX_WATER_DURATION 86400
 
 /**
- * @brief Display RGB value on ESP32
- * 
- * Sets the RGB to the specified color value and keeps the RGB on for a given
- * duration before turning it off.
- * 
- * @param[in] r Red color intensity (0-255)
- * @param[in] g Green color intensity (0-255)
- * @param[in] b Blue color intensity (0-255)
- * @param[in] delay Duration to keep RGB on (in ms)
- * 
- * @warning Ensure RGB_PIN is configured before calling.
+ * @brief Duration to keep solenoid valve open
  * 
  */
-void display_rgb(const int r, const int g, const int b, const int delay);
+extern int water_duration;
 
 /**
- * @brief Initialize WiFi module on ESP32
- * 
- * Configures and establishes WiFi connection on ESP32 using credentials
- * specified in secrets.h file. Initializes NVS flash and WiFi driver.
+ * @brief Moisture below which a zone is watered (in percent)
  * 
- * @retval 0 WiFi connection successful
- * @retval 1 WiFi connection unsuccessful
+ */
+extern int moisture_low;
+
+/**
+ * @brief Moisture at which watering of a zone stops (in percent)
  * 
- * @note WiFi credentials must be defined in secrets.h
- * @warning Must be called before communicating with Firebase servers
+ * Watering is closed-loop while set, water_duration is then the longest total
+ * open time of a watering. 0 waters by time only.
  * 
  */
-int init_wifi(void);
+extern int moisture_high;
 
 /**
- * @brief Check WiFi connection and reconnect if necessary.
+ * @def MAX_VALVE_SCHEDULES
+ * @brief Maximum number of valves with their own watering times
  * 
- * Checks the WiFi connection on the ESP32 and reconnects to the AP if
- * connection is dropped.
+ */
+#define MAX_VALVE_SCHEDULES 4
+
+/**
+ * @brief Watering times of a single valve
  * 
- * @retval 0 Connection valid
- * @retval 1 Reconnected
- * @retval -1 Reconnection fail
+ */
+typedef struct {
+    char valve[JSON_KEY_MAX];   /**< Valve name */
+    int times[MAX_WATERING_TIMES]; /**< Watering hours */
+    int num_times;              /**< Number of entries used in times */
+} valve_times;
+
+/**
+ * @brief Per valve watering times, overriding watering_times
  * 
  */
-int check_wifi(void);
+extern valve_times valve_schedules[MAX_VALVE_SCHEDULES];
 
+/**
+ * @brief Number of entries used in valve_schedules
+ * 
+ */
+extern int num_valve_schedules;
 
 /**
- * @brief Synchronize system time using SNTP
+ * @brief Wait for button press with prompt message
  * 
- * Configures SNTP client and synchronizes ESP32's system time with the network
- * server, "pool.ntp.org", for timestamp generation.
+ * Displays a prompt message and blocks execution of code until the button is
+ * pressed.
  * 
- * @note WiFi must be initialized before calibration.
+ * @param[in] str Prompt message to display
  * 
  */
-void calibrate_time(void);
+void button_interrupt(char* str);
 
 /**
  * @brief Print current system time to console
@@ -126,6 +126,17 @@ void calibrate_time(void);
 void print_current_time(void);
 
 
+/**
+ * @brief Get current local time
+ * 
+ * Thread-safe snapshot of the broken-down local time. The calendar fields are
+ * cached and only recomputed when the clock enters a new minute.
+ * 
+ * @param[out] timeinfo Current local time
+ * 
+ */
+void get_local_time(struct tm* timeinfo);
+
 /**
  * @brief Get current month
  * 
@@ -158,14 +169,6 @@ int get_current_hour(void);
  */
 int get_current_min(void);
 
-/**
- * @brief Get ESP32 chip temperature
- * 
- * @return Current chip temperature as float
- * 
- */
-float get_chip_temp();
-
 /**
  * @brief Update watering times
  * 
@@ -178,4 +181,109 @@ float get_chip_temp();
  */
 int parameter_comms();
 
+/**
+ * @brief Watering parameters read from the parameters document
+ * 
+ */
+typedef struct {
+    int water_duration;         /**< Valve open duration, -1 if not sent */
+    int moisture_low;           /**< Start of watering, -1 if not sent */
+    int moisture_high;          /**< End of watering, -1 if not sent */
+    int watering_times[MAX_WATERING_TIMES]; /**< Watering hours */
+    int num_times;              /**< Number of watering hours, -1 if not sent */
+    valve_times valves[MAX_VALVE_SCHEDULES]; /**< Per valve watering hours */
+    int num_valves;             /**< Number of valve entries, -1 if not sent */
+} planter_params;
+
+/**
+ * @brief Streaming binder from parameters JSON to planter_params
+ * 
+ */
+typedef struct {
+    json_parser parser;         /**< Incremental JSON parser */
+    planter_params params;      /**< Values parsed so far */
+    bool event;                 /**< Parsing a stream event envelope */
+    bool path_set;              /**< Event path received */
+    int path_len;               /**< Number of event path components */
+    char path[3][JSON_KEY_MAX]; /**< Event path components */
+} params_binder;
+
+/**
+ * @brief Start parsing a parameters document
+ * 
+ * The document can either be the parameters table itself or the data of a
+ * Firebase stream "put"/"patch" event, e.g.
+ * {"path": "/Water_Times_Set/1", "data": 19}.
+ * 
+ * "Water_Duration_Set" above MAX_WATER_DURATION is ignored.
+ * 
+ * Valves listed in "Valve_Times_Set" use their own watering hours instead of
+ * "Water_Times_Set", e.g. {"Valve_Times_Set": {"VALVE_1": [6, 18]}}.
+ * 
+ * "Moisture_Low_Set" and "Moisture_High_Set" set the moisture band of
+ * closed-loop watering in percent, e.g. {"Moisture_Low_Set": 35,
+ * "Moisture_High_Set": 55}. Null turns it off, as does a missing bound in the
+ * table itself.
+ * 
+ * @param[out] binder Binder state
+ * @param[in] event Non-zero for a stream event
+ * 
+ * @see params_feed()
+ * @see params_end()
+ * 
+ */
+void params_begin(params_binder* binder, int event);
+
+/**
+ * @brief Feed the next chunk of a parameters document
+ * 
+ * @param[in, out] binder Binder state
+ * @param[in] data Chunk of JSON text
+ * @param[in] len Length of chunk
+ * 
+ * @retval 0 Success
+ * @retval -1 Parse error
+ * 
+ */
+int params_feed(params_binder* binder, const char* data, int len);
+
+/**
+ * @brief Finish parsing and update the watering values stored on the ESP32
+ * 
+ * Values missing from the document keep their current setting. The scheduler
+ * is told to recompute its events when a value changed.
+ * 
+ * @param[in, out] binder Binder state
+ * 
+ * @retval 1 Parameters changed
+ * @retval 0 Parameters unchanged
+ * @retval -1 Parse error
+ * 
+ */
+int params_end(params_binder* binder);
+
+/**
+ * @brief Get the watering hours of a valve
+ * 
+ * @param[in] valve_name Name of valve
+ * @param[out] times Destination for hours, MAX_WATERING_TIMES entries
+ * 
+ * @return Number of hours copied
+ * @note Unused entries of a sparse update are set to -1 and must be skipped.
+ * 
+ */
+int get_watering_times(const char* valve_name, int* times);
+
+/**
+ * @brief Report current watering parameters to Firebase
+ * 
+ * Sends the watering values in use with a PATCH request on the parameters
+ * table.
+ * 
+ * @retval 0 success
+ * @retval -1 fail
+ * 
+ */
+int confirm_parameters(void);
+
 #endif
\ No newline at end of file
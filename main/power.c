@@ -0,0 +1,136 @@
+#include "power.h"
+
+#include <string.h>
+#include <sys/time.h>
+
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+
+#define POWER_MAGIC 0x504C4E54
+
+/**
+ * @brief State kept in RTC memory across deep sleep
+ * 
+ */
+typedef struct {
+    uint32_t magic;             // POWER_MAGIC once initialized
+    time_t last_cycle;
+    int64_t sleep_start_ms;     // Clock time when deep sleep started
+    uint32_t awake_ms;          // Awake time of the cycle before sleep
+    uint32_t wifi_ms;
+    bool saved[ADC_MAX_UNITS][ADC_MAX_CHANNELS]; // Calibration of a sensor
+    int mean_dry[ADC_MAX_UNITS][ADC_MAX_CHANNELS];
+    int mean_wet[ADC_MAX_UNITS][ADC_MAX_CHANNELS];
+    uint64_t charge;            // Total charge since power on (in uA*ms)
+    uint64_t total_ms;
+    power_stats stats;
+} power_state;
+
+RTC_DATA_ATTR static power_state state;
+static int64_t wifi_start_us = -1;
+
+static int64_t clock_ms(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+bool power_resume(sensor* sensors, int len) {
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER ||
+        state.magic != POWER_MAGIC) {
+            memset(&state, 0, sizeof(power_state));
+            state.magic = POWER_MAGIC;
+            return false;
+    }
+
+    for (int i = 0; i < len; i++) {
+        adc_unit_t unit = sensors[i].unit;
+        adc_channel_t chan = sensors[i].channel;
+        if (unit < ADC_MAX_UNITS && chan < ADC_MAX_CHANNELS && 
+            state.saved[unit][chan]) {
+                sens_set_calibration(&sensors[i], state.mean_dry[unit][chan], 
+                    state.mean_wet[unit][chan]);
+        }
+    }
+
+    // Add the cycle that just ended to the counters
+    int64_t sleep_ms = clock_ms() - state.sleep_start_ms;
+    if (sleep_ms < 0) {
+        sleep_ms = 0;
+    }
+    uint64_t charge = (uint64_t)state.awake_ms * POWER_ACTIVE_UA +
+        (uint64_t)state.wifi_ms * POWER_WIFI_UA + 
+        (uint64_t)sleep_ms * POWER_SLEEP_UA;
+    uint64_t cycle_ms = state.awake_ms + sleep_ms;
+
+    state.charge += charge;
+    state.total_ms += cycle_ms;
+    state.stats.cycles++;
+    state.stats.awake_ms = state.awake_ms;
+    state.stats.wifi_ms = state.wifi_ms;
+    state.stats.sleep_ms = (uint32_t)sleep_ms;
+    if (cycle_ms > 0) {
+        state.stats.cycle_current_ua = (uint32_t)(charge / cycle_ms);
+        state.stats.avg_current_ua = (uint32_t)(state.charge / state.total_ms);
+    }
+
+    return true;
+}
+
+void power_wifi_started(void) {
+    if (wifi_start_us == -1) {
+        wifi_start_us = esp_timer_get_time();
+    }
+}
+
+time_t power_last_cycle(void) {
+    return state.last_cycle;
+}
+
+void power_sleep(time_t cycle_time, time_t wake_at, const sensor* sensors,
+    int len, const valve* valves, int num_valves) {
+        state.magic = POWER_MAGIC;
+        state.last_cycle = cycle_time;
+
+        // Calibration may have changed since boot, kept by unit and channel
+        memset(state.saved, 0, sizeof(state.saved));
+        for (int i = 0; i < len; i++) {
+            adc_unit_t unit = sensors[i].unit;
+            adc_channel_t chan = sensors[i].channel;
+            if (unit < ADC_MAX_UNITS && chan < ADC_MAX_CHANNELS) {
+                state.saved[unit][chan] = true;
+                state.mean_dry[unit][chan] = sensors[i].mean_dry;
+                state.mean_wet[unit][chan] = sensors[i].mean_wet;
+            }
+        }
+
+        // Timer restarts with every wake up
+        int64_t now_us = esp_timer_get_time();
+        state.awake_ms = (uint32_t)(now_us / 1000);
+        state.wifi_ms = wifi_start_us == -1 ? 0 : 
+            (uint32_t)((now_us - wifi_start_us) / 1000);
+
+        int64_t now_ms = clock_ms();
+        int64_t sleep_ms = wake_at == -1 ? POWER_MAX_SLEEP : 
+            (int64_t)wake_at * 1000 - now_ms;
+        if (sleep_ms < POWER_MIN_SLEEP) {
+            sleep_ms = POWER_MIN_SLEEP;
+        }
+        state.sleep_start_ms = now_ms;
+
+        // Keep valves closed while their pins are not driven
+        for (int i = 0; i < num_valves; i++) {
+            gpio_hold_en(valves[i].pin);
+        }
+        gpio_deep_sleep_hold_en();
+
+        printf("Sleeping for %lld ms.\n", (long long)sleep_ms);
+        esp_sleep_enable_timer_wakeup((uint64_t)sleep_ms * 1000);
+        esp_deep_sleep_start();
+}
+
+power_stats get_power_stats(void) {
+    return state.stats;
+}
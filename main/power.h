@@ -0,0 +1,141 @@
+/**
+ * @file power.h
+ * @brief Deep sleep duty cycling between scheduled events
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Keeps the state needed between wake ups in RTC memory, which
+ * survives deep sleep: sensor calibration, time of the last cycle and power
+ * counters. Watering parameters are kept in RTC memory by planter_utils.c,
+ * the clock by time_sync.c and unsent readings by the flash backed offline
+ * queue.
+ *
+ * The average current is estimated from the time spent awake, with WiFi on
+ * and in deep sleep, using the typical currents below.
+ *
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "sensor.h"
+#include "solenoid.h"
+
+/**
+ * @def POWER_ACTIVE_UA
+ * @brief Typical current while awake with WiFi off (in uA)
+ *
+ */
+#define POWER_ACTIVE_UA 40000
+
+/**
+ * @def POWER_WIFI_UA
+ * @brief Typical extra current while WiFi is on (in uA)
+ *
+ */
+#define POWER_WIFI_UA 80000
+
+/**
+ * @def POWER_SLEEP_UA
+ * @brief Typical current in deep sleep (in uA)
+ *
+ */
+#define POWER_SLEEP_UA 10
+
+/**
+ * @def POWER_RESYNC_AGE
+ * @brief Time after which the RTC clock is synchronized again (in s)
+ *
+ * @note The RTC clock drifts during deep sleep.
+ *
+ */
+#define POWER_RESYNC_AGE 21600
+
+/**
+ * @def POWER_MIN_SLEEP
+ * @brief Shortest deep sleep (in ms)
+ *
+ */
+#define POWER_MIN_SLEEP 1000
+
+/**
+ * @def POWER_MAX_SLEEP
+ * @brief Longest deep sleep when no event is scheduled (in ms)
+ *
+ */
+#define POWER_MAX_SLEEP 3600000
+
+/**
+ * @brief Power counters
+ *
+ */
+typedef struct {
+    uint32_t cycles;            /**< Deep sleep cycles since power on */
+    uint32_t awake_ms;          /**< Awake time of last cycle */
+    uint32_t wifi_ms;           /**< WiFi on time of last cycle */
+    uint32_t sleep_ms;          /**< Deep sleep time of last cycle */
+    uint32_t cycle_current_ua;  /**< Average current of last cycle */
+    uint32_t avg_current_ua;    /**< Average current since power on */
+} power_stats;
+
+/**
+ * @brief Restore state after a deep sleep wake up
+ *
+ * Copies the calibration kept in RTC memory back to the sensors and updates
+ * the power counters with the cycle that just ended.
+ *
+ * @param[in, out] sensors Array of sensor structures
+ * @param[in] len Number of sensors
+ *
+ * @retval true Woken from deep sleep, state restored
+ * @retval false Cold boot, sensors keep their defaults
+ *
+ */
+bool power_resume(sensor* sensors, int len);
+
+/**
+ * @brief Mark WiFi as started in this cycle
+ *
+ */
+void power_wifi_started(void);
+
+/**
+ * @brief Get the time events were last checked
+ *
+ * @return Time of last cycle, 0 if none
+ *
+ */
+time_t power_last_cycle(void);
+
+/**
+ * @brief Save state and enter deep sleep until the next event
+ *
+ * Valve pins are held closed during deep sleep. Does not return.
+ *
+ * @param[in] cycle_time Time events were checked in this cycle
+ * @param[in] wake_at Time of next event, -1 for POWER_MAX_SLEEP
+ * @param[in] sensors Array of sensor structures
+ * @param[in] len Number of sensors
+ * @param[in] valves Array of valves
+ * @param[in] num_valves Number of valves
+ *
+ * @warning Buffered offline queue records must be flushed before calling
+ *
+ */
+void power_sleep(time_t cycle_time, time_t wake_at, const sensor* sensors,
+    int len, const valve* valves, int num_valves);
+
+/**
+ * @brief Get power counters
+ *
+ * @return Copy of the counters
+ *
+ */
+power_stats get_power_stats(void);
+
+#endif
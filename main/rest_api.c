@@ -1,11 +1,182 @@
 #include "rest_api.h"
 
+#include <stdarg.h>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#include "health.h"
+
+/**
+ * @brief Persistent client slot in the connection pool
+ * 
+ */
+typedef struct {
+    esp_http_client_handle_t handle;    /**< Long-lived client handle */
+    char base_url[128];                 /**< Firebase host served by slot */
+    bool in_use;                        /**< Slot is borrowed by a task */
+    bool connected;                     /**< Slot has connected before */
+    bool fresh;                         /**< Current request opened a new connection */
+    data_callback rx_callback;          /**< GET response consumer */
+    void* rx_ctx;                       /**< Context for rx_callback */
+    int rx_total;                       /**< Bytes received for request */
+    bool rx_error;                      /**< rx_callback rejected data */
+    int64_t connected_us;               /**< Time connection was opened */
+    int64_t first_byte_us;              /**< Time response headers arrived */
+    int64_t last_used_us;               /**< Time the last request finished */
+} conn_slot;
+
+/**
+ * @brief Destination of a GET response copied into a buffer
+ * 
+ */
+typedef struct {
+    char* buffer;
+    int len;
+    int cap;
+} copy_sink;
+
+static conn_slot pool[REST_POOL_SIZE];
+static conn_stats stats;
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static esp_err_t pool_event_handler(esp_http_client_event_t* evt) {
+    conn_slot* slot = (conn_slot*)evt->user_data;
+    if (slot == NULL) {
+        return ESP_OK;
+    }
+
+    switch (evt->event_id) {
+        case HTTP_EVENT_ON_CONNECTED:
+            taskENTER_CRITICAL(&pool_lock);
+            stats.handshakes++;
+            if (slot->connected) {
+                stats.reconnects++;
+            }
+            taskEXIT_CRITICAL(&pool_lock);
+            slot->connected = true;
+            slot->fresh = true;
+            slot->connected_us = esp_timer_get_time();
+            break;
+        case HTTP_EVENT_HEADERS_SENT:
+            if (!slot->fresh) {
+                taskENTER_CRITICAL(&pool_lock);
+                stats.reuses++;
+                taskEXIT_CRITICAL(&pool_lock);
+            }
+            break;
+        case HTTP_EVENT_ON_HEADER:
+            if (slot->first_byte_us == 0) {
+                slot->first_byte_us = esp_timer_get_time();
+            }
+            break;
+        case HTTP_EVENT_ON_DATA:
+            // Hand GET response to consumer straight from the client buffer
+            slot->rx_total += evt->data_len;
+            if (slot->rx_callback != NULL && !slot->rx_error &&
+                slot->rx_callback(evt->data, evt->data_len, 
+                    slot->rx_ctx) != 0) {
+                        slot->rx_error = true;
+            }
+            break;
+        default:
+            break;
+    }
+
+    return ESP_OK;
+}
+
+static conn_slot* get_slot(esp_http_client_handle_t client) {
+    void* user_data = NULL;
+    if (esp_http_client_get_user_data(client, &user_data) != ESP_OK) {
+        return NULL;
+    }
+
+    return (conn_slot*)user_data;
+}
+
+static int64_t start_timing(conn_slot* slot) {
+    if (slot != NULL) {
+        slot->connected_us = 0;
+        slot->first_byte_us = 0;
+    }
+
+    return esp_timer_get_time();
+}
+
+static void finish_timing(conn_slot* slot, int64_t start, bool ok) {
+    http_timing timing = {
+        .total_ms = (esp_timer_get_time() - start) / 1000
+    };
+    if (slot != NULL && slot->connected_us != 0) {
+        timing.connect_ms = (slot->connected_us - start) / 1000;
+    }
+    if (slot != NULL && slot->first_byte_us != 0) {
+        timing.first_byte_ms = (slot->first_byte_us - start) / 1000;
+    }
+
+    health_http_request(&timing, ok);
+}
+
+static void close_if_idle(esp_http_client_handle_t client, conn_slot* slot) {
+    // Server has most likely dropped a connection left idle this long
+    if (slot != NULL && slot->last_used_us != 0 && 
+        esp_timer_get_time() - slot->last_used_us > 
+        (int64_t)REST_IDLE_CLOSE_MS * 1000) {
+            esp_http_client_close(client);
+    }
+}
+
+static esp_err_t perform_request(esp_http_client_handle_t client) {
+    conn_slot* slot = get_slot(client);
+    close_if_idle(client, slot);
+    if (slot != NULL) {
+        slot->fresh = false;
+        slot->rx_total = 0;
+    }
+
+    int64_t start = start_timing(slot);
+    esp_err_t status = esp_http_client_perform(client);
+
+    // A kept-alive connection may have been dropped by the server while idle,
+    // so reconnect once before reporting failure
+    if (status != ESP_OK && slot != NULL && !slot->fresh && 
+        slot->rx_total == 0) {
+        health_http_retry();
+        esp_http_client_close(client);
+        start = start_timing(slot);
+        status = esp_http_client_perform(client);
+    }
+    finish_timing(slot, start, status == ESP_OK);
+    if (slot != NULL) {
+        slot->last_used_us = esp_timer_get_time();
+    }
+
+    return status;
+}
+
+char* make_url(const char* data_table_name, const char* firebase_url, 
+    const char* firebase_api_key) {
+        int len = snprintf(NULL, 0, "%s%s.json?auth=%s", firebase_url, 
+            data_table_name, firebase_api_key);
+        char* url = malloc(len + 1);
+        if (url == NULL) {
+            printf("ERROR allocating URL.\n");
+            return NULL;
+        }
+        snprintf(url, len + 1, "%s%s.json?auth=%s", firebase_url, 
+            data_table_name, firebase_api_key);
+
+        return url;
+}
+
 esp_http_client_handle_t setup_client(char* data_table_name, char* firebase_url, 
     char* firebase_api_key) {
         // Construct full URL
-        char url[256];
-        snprintf(url, 256, "%s%s.json?auth=%s", firebase_url, data_table_name,
-            firebase_api_key);
+        char* url = make_url(data_table_name, firebase_url, firebase_api_key);
+        if (url == NULL) {
+            return NULL;
+        }
 
         // Configuration for HTTP client
         esp_http_client_config_t config = {
@@ -15,6 +186,7 @@ esp_http_client_handle_t setup_client(char* data_table_name, char* firebase_url,
 
         // Client creation
         esp_http_client_handle_t client = esp_http_client_init(&config);
+        free(url);
         if (client == NULL) {
             printf("Error initializing client.\n");
             return NULL;
@@ -33,7 +205,7 @@ int post_data(esp_http_client_handle_t client, const char* json_data) {
     esp_http_client_set_post_field(client, json_data, strlen(json_data));
 
     // Execute POST request
-    esp_err_t status = esp_http_client_perform(client);
+    esp_err_t status = perform_request(client);
     if (status != ESP_OK) {
         printf("HTTP POST Unsuccessful.\n");
         printf("Status Code: %s\n", esp_err_to_name(status));
@@ -48,7 +220,7 @@ int patch_data(esp_http_client_handle_t client, const char* json_data) {
     esp_http_client_set_method(client, HTTP_METHOD_PATCH);
     esp_http_client_set_post_field(client, json_data, strlen(json_data));
 
-    esp_err_t status = esp_http_client_perform(client);
+    esp_err_t status = perform_request(client);
     if (status != ESP_OK) {
         printf("HTTP PATCH Unsuccessful.\n");
         printf("Status Code: %s\n", esp_err_to_name(status));
@@ -58,27 +230,484 @@ int patch_data(esp_http_client_handle_t client, const char* json_data) {
     return 0;
 }
 
-int get_data(esp_http_client_handle_t client, char* buffer, int len) {
-    // Set client method to GET
-    esp_http_client_set_method(client, HTTP_METHOD_GET);
+static int json_encode(const sensor_record* records, int len, 
+    rest_writer* writer) {
+        rest_write(writer, "{", 1);
+
+        // Multi-path document keyed by timestamp and sensor name
+        for (int i = 0; i < len; i++) {
+            struct tm timeinfo;
+            localtime_r(&records[i].timestamp, &timeinfo);
+
+            rest_printf(writer,
+                "%s\"%lld-%s\": {\"Name\": \"%s\", "
+                "\"Month\": %d, "
+                "\"Day\": %d, "
+                "\"Hour\": %d, "
+                "\"Moisture\": %d.%02d}",
+                i == 0 ? "" : ", ",
+                (long long)records[i].timestamp,
+                records[i].name,
+                records[i].name,
+                timeinfo.tm_mon+1,
+                timeinfo.tm_mday,
+                timeinfo.tm_hour,
+                records[i].moisture / 100,
+                records[i].moisture % 100
+            );
+        }
+
+        return rest_write(writer, "}", 1);
+}
+
+static int packed_encode(const sensor_record* records, int len, 
+    rest_writer* writer) {
+        uint8_t entry[TELEMETRY_HEADER_SIZE + TELEMETRY_RECORD_MAX];
+        telemetry_packer packer;
+        pack_init(&packer, entry, sizeof(entry));
+
+        for (int i = 0; i < len; i++) {
+            telemetry_record record = {
+                .timestamp = (uint32_t)records[i].timestamp,
+                .moisture = records[i].moisture,
+                .sensor_id = records[i].sensor_id
+            };
+            if (pack_record(&packer, &record) != 0 || 
+                rest_write(writer, (const char*)entry, packer.len) != 0) {
+                    return -1;
+            }
+            // Packer keeps the previous timestamp, only the bytes are reused
+            packer.len = 0;
+        }
+
+        return 0;
+}
+
+const telemetry_codec json_codec = {
+    .content_type = "application/json",
+    .method = HTTP_METHOD_PATCH,
+    .encode = json_encode
+};
+
+const telemetry_codec packed_codec = {
+    .content_type = "application/octet-stream",
+    .method = HTTP_METHOD_POST,
+    .encode = packed_encode
+};
+
+static int write_chunk(const uint8_t* data, int len, void* ctx) {
+    esp_http_client_handle_t client = (esp_http_client_handle_t)ctx;
+
+    // Chunked transfer framing is left to the caller by the HTTP client
+    char size[12];
+    int size_len = snprintf(size, sizeof(size), "%x\r\n", len);
+    if (esp_http_client_write(client, size, size_len) != size_len ||
+        esp_http_client_write(client, (const char*)data, len) != len ||
+        esp_http_client_write(client, "\r\n", 2) != 2) {
+            return -1;
+    }
+
+    return 0;
+}
+
+static int flush_writer(rest_writer* writer) {
+    if (writer->len > 0 && !writer->error) {
+        int status = writer->gzip != NULL ?
+            gzip_write(writer->gzip, writer->buffer, writer->len) :
+            write_chunk((const uint8_t*)writer->buffer, writer->len, 
+                writer->client);
+        if (status != 0) {
+            writer->error = true;
+        }
+    }
+    writer->len = 0;
+
+    return writer->error ? -1 : 0;
+}
+
+int rest_write(rest_writer* writer, const char* data, int len) {
+    while (len > 0 && !writer->error) {
+        if (writer->len == REST_WRITE_BUFFER) {
+            flush_writer(writer);
+        }
+
+        int copy_len = REST_WRITE_BUFFER - writer->len;
+        if (len < copy_len) {
+            copy_len = len;
+        }
+        memcpy(writer->buffer + writer->len, data, copy_len);
+        writer->len += copy_len;
+        data += copy_len;
+        len -= copy_len;
+    }
+
+    return writer->error ? -1 : 0;
+}
+
+int rest_printf(rest_writer* writer, const char* format, ...) {
+    if (writer->error) {
+        return -1;
+    }
+
+    va_list args;
+    va_start(args, format);
+    va_list retry;
+    va_copy(retry, args);
+
+    int space = REST_WRITE_BUFFER - writer->len;
+    int len = vsnprintf(writer->buffer + writer->len, space, format, args);
+    va_end(args);
+
+    if (len >= 0 && len < space) {
+        writer->len += len;
+    }
+    else if (len >= 0) {
+        // Field does not fit behind the buffered data, so send that first
+        flush_writer(writer);
+        if (len < REST_WRITE_BUFFER) {
+            vsnprintf(writer->buffer, REST_WRITE_BUFFER, format, retry);
+            writer->len = len;
+        }
+        else {
+            char* field = malloc(len + 1);
+            if (field == NULL) {
+                writer->error = true;
+            }
+            else {
+                vsnprintf(field, len + 1, format, retry);
+                rest_write(writer, field, len);
+                free(field);
+            }
+        }
+    }
+    else {
+        writer->error = true;
+    }
+    va_end(retry);
+
+    return writer->error ? -1 : 0;
+}
+
+int stream_request(esp_http_client_handle_t client, 
+    esp_http_client_method_t method, const char* content_type, 
+    rest_encoding encoding, body_producer producer, void* ctx) {
+        rest_writer writer = {
+            .client = client
+        };
+        if (encoding == REST_ENCODING_GZIP) {
+            writer.gzip = malloc(sizeof(gzip_stream));
+            if (writer.gzip == NULL) {
+                printf("ERROR allocating compression buffer.\n");
+                return -1;
+            }
+        }
+
+        conn_slot* slot = get_slot(client);
+        close_if_idle(client, slot);
+        int result = -1;
+        for (int attempt = 0; attempt < 2 && result != 0; attempt++) {
+            if (slot != NULL) {
+                slot->fresh = false;
+            }
+            if (attempt > 0) {
+                health_http_retry();
+            }
+            int64_t start = start_timing(slot);
+
+            // Length is unknown until the producer is done
+            esp_http_client_set_method(client, method);
+            esp_http_client_set_header(client, "Content-Type", content_type);
+            esp_http_client_delete_header(client, "Content-Length");
+            if (writer.gzip != NULL) {
+                esp_http_client_set_header(client, "Content-Encoding", "gzip");
+            }
+
+            bool responded = false;
+            if (esp_http_client_open(client, -1) == ESP_OK) {
+                writer.len = 0;
+                writer.error = false;
+                if (writer.gzip != NULL) {
+                    gzip_init(writer.gzip, write_chunk, client);
+                }
+
+                if (producer(&writer, ctx) == 0 && flush_writer(&writer) == 0 &&
+                    (writer.gzip == NULL || gzip_finish(writer.gzip) == 0) &&
+                    esp_http_client_write(client, "0\r\n\r\n", 5) == 5 &&
+                    esp_http_client_fetch_headers(client) >= 0) {
+                        responded = true;
+                        int code = esp_http_client_get_status_code(client);
+                        int flushed = 0;
+                        esp_http_client_flush_response(client, &flushed);
+                        if (code >= 200 && code < 300) {
+                            result = 0;
+                        }
+                        else {
+                            printf("ERROR request rejected (%d).\n", code);
+                        }
+                }
+            }
+
+            // Later requests on the client are sent whole and uncompressed
+            esp_http_client_delete_header(client, "Content-Encoding");
+            esp_http_client_delete_header(client, "Transfer-Encoding");
+            esp_http_client_set_header(client, "Content-Type", 
+                "application/json");
+            if (result != 0) {
+                esp_http_client_close(client);
+            }
+
+            // Only a kept-alive connection dropped while idle is retried, 
+            // the attempt on it does not count as a failed request
+            if (responded || slot == NULL || slot->fresh || attempt > 0) {
+                finish_timing(slot, start, result == 0);
+                break;
+            }
+        }
+        if (slot != NULL) {
+            slot->last_used_us = esp_timer_get_time();
+        }
+        free(writer.gzip);
+
+        if (result != 0) {
+            printf("HTTP streamed request Unsuccessful.\n");
+        }
+
+        return result;
+}
 
+typedef struct {
+    const telemetry_codec* codec;
+    const sensor_record* records;
+    int len;
+} record_batch;
+
+static int write_records(rest_writer* writer, void* ctx) {
+    record_batch* batch = (record_batch*)ctx;
+    return batch->codec->encode(batch->records, batch->len, writer);
+}
+
+int send_records(esp_http_client_handle_t client, const telemetry_codec* codec,
+    const sensor_record* records, int len, rest_encoding encoding) {
+        record_batch batch = {
+            .codec = codec,
+            .records = records,
+            .len = len
+        };
+
+        return stream_request(client, codec->method, codec->content_type, 
+            encoding, write_records, &batch);
+}
+
+int patch_records(esp_http_client_handle_t client, 
+    const sensor_record* records, int len) {
+        return send_records(client, &json_codec, records, len, 
+            REST_ENCODING_IDENTITY);
+}
+
+static int copy_data(const char* data, int len, void* ctx) {
+    copy_sink* sink = (copy_sink*)ctx;
+
+    // Truncate to buffer size
+    int copy_len = sink->cap - 1 - sink->len;
+    if (len < copy_len) {
+        copy_len = len;
+    }
+    if (copy_len > 0) {
+        memcpy(sink->buffer + sink->len, data, copy_len);
+        sink->len += copy_len;
+    }
+
+    return 0;
+}
+
+int get_data(esp_http_client_handle_t client, char* buffer, int len) {
     // Clear buffer
     memset(buffer, 0, len);
 
-    // Execute GET request
-    esp_http_client_open(client, 0);
-    esp_http_client_fetch_headers(client);
-
-    int content_length = esp_http_client_read(client, buffer, len-1);
-    if (content_length <= 0) {
-        printf("ERROR GET request failed.\n");
+    copy_sink sink = {
+        .buffer = buffer,
+        .len = 0,
+        .cap = len
+    };
+    if (get_stream(client, copy_data, &sink) == -1 || sink.len <= 0) {
         return -1;
     }
 
     return 0;
 }
 
+int get_stream(esp_http_client_handle_t client, data_callback callback,
+    void* ctx) {
+        // Set client method to GET
+        esp_http_client_set_method(client, HTTP_METHOD_GET);
+
+        // Pooled clients receive the body through the event handler so the
+        // connection is left reusable
+        conn_slot* slot = get_slot(client);
+        if (slot != NULL) {
+            esp_http_client_set_post_field(client, NULL, 0);
+            slot->rx_callback = callback;
+            slot->rx_ctx = ctx;
+            slot->rx_error = false;
+
+            esp_err_t status = perform_request(client);
+            int content_length = slot->rx_total;
+            bool rx_error = slot->rx_error;
+            slot->rx_callback = NULL;
+
+            if (status != ESP_OK || content_length <= 0 || rx_error) {
+                printf("ERROR GET request failed.\n");
+                return -1;
+            }
+
+            return 0;
+        }
+
+        // Execute GET request
+        if (esp_http_client_open(client, 0) != ESP_OK) {
+            printf("ERROR GET request failed.\n");
+            return -1;
+        }
+        esp_http_client_fetch_headers(client);
+
+        char chunk[128];
+        int content_length = 0;
+        int read_len;
+        while ((read_len = esp_http_client_read(client, chunk, 
+            sizeof(chunk))) > 0) {
+                content_length += read_len;
+                if (callback(chunk, read_len, ctx) != 0) {
+                    printf("ERROR GET response rejected.\n");
+                    return -1;
+                }
+        }
+        if (content_length <= 0) {
+            printf("ERROR GET request failed.\n");
+            return -1;
+        }
+
+        return 0;
+}
+
 void close_client(esp_http_client_handle_t client) {
     esp_http_client_close(client);
     esp_http_client_cleanup(client);
+}
+
+esp_http_client_handle_t acquire_client(const char* data_table_name, 
+    const char* firebase_url, const char* firebase_api_key) {
+        // A cut URL would never match its slot again
+        if (strlen(firebase_url) >= sizeof(pool[0].base_url)) {
+            printf("ERROR Firebase URL too long.\n");
+            return NULL;
+        }
+
+        // Find an idle slot, preferring one already connected to the host
+        conn_slot* slot = NULL;
+        taskENTER_CRITICAL(&pool_lock);
+        for (int i = 0; i < REST_POOL_SIZE; i++) {
+            if (pool[i].in_use) {
+                continue;
+            }
+            if (pool[i].handle != NULL && 
+                strcmp(pool[i].base_url, firebase_url) == 0) {
+                    slot = &pool[i];
+                    break;
+            }
+            if (slot == NULL || (slot->handle != NULL && 
+                pool[i].handle == NULL)) {
+                    slot = &pool[i];
+            }
+        }
+        if (slot != NULL) {
+            slot->in_use = true;
+        }
+        taskEXIT_CRITICAL(&pool_lock);
+
+        // Every pooled handle is busy
+        if (slot == NULL) {
+            return setup_client((char*)data_table_name, (char*)firebase_url, 
+                (char*)firebase_api_key);
+        }
+
+        // Construct full URL
+        char* url = make_url(data_table_name, firebase_url, firebase_api_key);
+        if (url == NULL) {
+            taskENTER_CRITICAL(&pool_lock);
+            slot->in_use = false;
+            taskEXIT_CRITICAL(&pool_lock);
+            return NULL;
+        }
+
+        // Slot last served another host
+        if (slot->handle != NULL && strcmp(slot->base_url, firebase_url) != 0) {
+            close_client(slot->handle);
+            slot->handle = NULL;
+            slot->connected = false;
+            slot->last_used_us = 0;
+        }
+
+        if (slot->handle == NULL) {
+            esp_http_client_config_t config = {
+                .url = url,
+                .cert_pem = certificate_pem_start,
+                .keep_alive_enable = true,
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+                .save_client_session = true,
+#endif
+                .event_handler = pool_event_handler,
+                .user_data = slot
+            };
+
+            slot->handle = esp_http_client_init(&config);
+            free(url);
+            if (slot->handle == NULL) {
+                printf("Error initializing client.\n");
+                taskENTER_CRITICAL(&pool_lock);
+                slot->in_use = false;
+                taskEXIT_CRITICAL(&pool_lock);
+                return NULL;
+            }
+
+            esp_http_client_set_header(slot->handle, "Content-Type", 
+                "application/json");
+            strlcpy(slot->base_url, firebase_url, sizeof(slot->base_url));
+        }
+        else {
+            // Same host, so the open connection is kept
+            esp_http_client_set_url(slot->handle, url);
+            free(url);
+        }
+
+        return slot->handle;
+}
+
+void release_client(esp_http_client_handle_t client, int failed) {
+    if (client == NULL) {
+        return;
+    }
+
+    conn_slot* slot = get_slot(client);
+    if (slot == NULL) {
+        // Temporary client created while the pool was busy
+        close_client(client);
+        return;
+    }
+
+    // Drop the connection so the next request starts clean
+    if (failed) {
+        esp_http_client_close(client);
+    }
+
+    taskENTER_CRITICAL(&pool_lock);
+    slot->in_use = false;
+    taskEXIT_CRITICAL(&pool_lock);
+}
+
+conn_stats get_conn_stats(void) {
+    taskENTER_CRITICAL(&pool_lock);
+    conn_stats snapshot = stats;
+    taskEXIT_CRITICAL(&pool_lock);
+
+    return snapshot;
 }
\ No newline at end of file
@@ -7,17 +7,165 @@
  * 
  * @details Provides HTTP client functionality for communication with Firebase
  * database. Handles secure HTTPS connections using certificates and managees
- * JSON data transmission for sensor readings.
+ * JSON data transmission for sensor readings. Sensor readings are sent through
+ * a telemetry codec, so the same upload path can carry JSON for Firebase or the
+ * packed binary encoding for other servers.
  * 
  */
 
 #ifndef REST_API_H
 #define REST_API_H
 
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "esp_http_client.h"
 
+#include "gzip_stream.h"
+#include "telemetry.h"
+
+/**
+ * @def REST_POOL_SIZE
+ * @brief Number of persistent HTTP client handles kept open
+ * 
+ * Each pooled handle holds one keep-alive TLS connection to a Firebase host.
+ * Two handles allow the watering and updating tasks to communicate at the same
+ * time without waiting on each other.
+ * 
+ */
+#define REST_POOL_SIZE 2
+
+/**
+ * @def REST_IDLE_CLOSE_MS
+ * @brief Idle time after which a pooled connection is reopened (in ms)
+ * 
+ * Servers drop keep-alive connections left idle for about a minute, which the
+ * client only notices once a request on it fails. Connections idle for longer
+ * than this are closed before use and a new one is opened instead.
+ * 
+ */
+#define REST_IDLE_CLOSE_MS 50000
+
+/**
+ * @brief Connection pool counters
+ * 
+ * Used to confirm how many TLS handshakes are saved by connection reuse.
+ * 
+ */
+typedef struct {
+    uint32_t handshakes;        /**< New connections (full TLS handshakes) */
+    uint32_t reuses;            /**< Requests sent on an open connection */
+    uint32_t reconnects;        /**< Connections re-established after a drop */
+} conn_stats;
+
+/**
+ * @def REST_WRITE_BUFFER
+ * @brief Size of the buffer collecting a streamed request body (in bytes)
+ * 
+ * Small writes are collected and sent as one chunk once the buffer fills.
+ * 
+ */
+#define REST_WRITE_BUFFER 128
+
+/**
+ * @brief Single sensor reading for upload
+ * 
+ */
+typedef struct {
+    const char* name;           /**< Sensor identification string */
+    time_t timestamp;           /**< Time of reading */
+    uint16_t moisture;          /**< Moisture in hundredths of a percent */
+    uint8_t sensor_id;          /**< Index of sensor in sensor array */
+} sensor_record;
+
+/**
+ * @brief Consumer for a response received in chunks
+ * 
+ * @param[in] data Chunk of response body
+ * @param[in] len Length of chunk
+ * @param[in] ctx User context
+ * 
+ * @retval 0 Chunk accepted
+ * @retval -1 Stop processing the response
+ * 
+ */
+typedef int (*data_callback)(const char* data, int len, void* ctx);
+
+/**
+ * @brief Compression of a request body
+ * 
+ */
+typedef enum {
+    REST_ENCODING_IDENTITY,             /**< Sent as is */
+    REST_ENCODING_GZIP                  /**< Compressed while sending */
+} rest_encoding;
+
+/**
+ * @brief Streamed request body
+ * 
+ * Data written by a producer goes through a small buffer straight into the
+ * connection, so the body size is not limited by any buffer.
+ * 
+ * @see stream_request()
+ * 
+ */
+typedef struct {
+    esp_http_client_handle_t client;    /**< Client sending the request */
+    gzip_stream* gzip;                  /**< Compressor, NULL if not used */
+    char buffer[REST_WRITE_BUFFER];     /**< Data not yet sent */
+    int len;                            /**< Bytes in buffer */
+    bool error;                         /**< A write to the connection failed */
+} rest_writer;
+
+/**
+ * @brief Producer of a streamed request body
+ * 
+ * @param[in] writer Request body
+ * @param[in] ctx User context
+ * 
+ * @retval 0 Body complete
+ * @retval -1 Abort request
+ * 
+ */
+typedef int (*body_producer)(rest_writer* writer, void* ctx);
+
+/**
+ * @brief Serializer for a batch of sensor records
+ * 
+ * Each codec describes how a batch is encoded and how it is sent, so the
+ * upload path does not depend on the server. Records are written straight
+ * into the request body.
+ * 
+ */
+typedef struct {
+    const char* content_type;           /**< Content-Type of request body */
+    esp_http_client_method_t method;    /**< Request method */
+    int (*encode)(const sensor_record* records, int len, 
+        rest_writer* writer);           /**< Encode, returns 0 or -1 */
+} telemetry_codec;
+
+/**
+ * @brief Firebase multi-path JSON codec
+ * 
+ * Each record is stored under its own "<timestamp>-<name>" key with the same
+ * fields as an individual POST. Sent with PATCH.
+ * 
+ */
+extern const telemetry_codec json_codec;
+
+/**
+ * @brief Packed binary codec
+ * 
+ * Records are sent as one telemetry stream with POST, about 4 bytes per
+ * reading instead of about 80 bytes of JSON.
+ * 
+ * @see telemetry.h
+ * 
+ */
+extern const telemetry_codec packed_codec;
+
 /**
  * @brief Start of SSL certificate for Firebase HTTPS connections
  * 
@@ -34,6 +182,20 @@ extern const char certificate_pem_start[] asm("_binary_certificate_pem_start");
  */
 extern const char certificate_pem_end[]   asm("_binary_certificate_pem_end");
 
+/**
+ * @brief Build the request URL of a database table
+ * 
+ * @param[in] data_table_name Name of database table
+ * @param[in] firebase_url Base URL of database
+ * @param[in] firebase_api_key Firebase API key for authentication
+ * 
+ * @return Allocated URL string, must be freed
+ * @retval NULL Allocation failed
+ * 
+ */
+char* make_url(const char* data_table_name, const char* firebase_url, 
+    const char* firebase_api_key);
+
 /**
  * @brief Configures HTTP client for Firebase communication
  * 
@@ -90,6 +252,105 @@ int post_data(esp_http_client_handle_t client, const char* json_data);
  */
 int patch_data(esp_http_client_handle_t client, const char* json_data);
 
+/**
+ * @brief Append data to a streamed request body
+ * 
+ * @param[in, out] writer Request body
+ * @param[in] data Data to append
+ * @param[in] len Length of data
+ * 
+ * @retval 0 Success
+ * @retval -1 Connection write failed
+ * 
+ */
+int rest_write(rest_writer* writer, const char* data, int len);
+
+/**
+ * @brief Append formatted text to a streamed request body
+ * 
+ * @param[in, out] writer Request body
+ * @param[in] format printf-style format string
+ * 
+ * @retval 0 Success
+ * @retval -1 Connection write failed
+ * 
+ */
+int rest_printf(rest_writer* writer, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Send a request with a streamed body
+ * 
+ * Opens the request with chunked transfer encoding and calls the producer,
+ * which writes the body with rest_write() and rest_printf(). Nothing but a
+ * small write buffer is kept in RAM, no matter how large the body is. With 
+ * REST_ENCODING_GZIP the body is compressed as it is written and sent with 
+ * "Content-Encoding: gzip".
+ * 
+ * A pooled connection that was dropped by the server while idle is reopened
+ * and the producer called again.
+ * 
+ * @param[in] client HTTP client handle
+ * @param[in] method Request method
+ * @param[in] content_type Content-Type of body
+ * @param[in] encoding Compression of body
+ * @param[in] producer Writes the body, may be called twice
+ * @param[in] ctx User context for producer
+ * 
+ * @retval 0 Request successful
+ * @retval -1 Request failed or rejected by the server
+ * 
+ * @note The server must accept chunked request bodies, and gzip request
+ * bodies if compression is used.
+ * 
+ * @see gzip_stream.h
+ * 
+ */
+int stream_request(esp_http_client_handle_t client, 
+    esp_http_client_method_t method, const char* content_type, 
+    rest_encoding encoding, body_producer producer, void* ctx);
+
+/**
+ * @brief Send a batch of sensor records with a codec
+ * 
+ * Encodes every record into one streamed request body, so the number of
+ * requests per cycle does not depend on the number of sensors and the batch
+ * size does not depend on free RAM.
+ * 
+ * @param[in] client HTTP client handle
+ * @param[in] codec Serializer for the server
+ * @param[in] records Array of sensor records
+ * @param[in] len Number of records
+ * @param[in] encoding Compression of the request body
+ * 
+ * @retval 0 Request successful
+ * @retval -1 Encoding or request failed, or server rejected the body
+ * 
+ * @see stream_request()
+ * 
+ */
+int send_records(esp_http_client_handle_t client, const telemetry_codec* codec,
+    const sensor_record* records, int len, rest_encoding encoding);
+
+/**
+ * @brief Send a batch of sensor records to Firebase
+ * 
+ * Writes every record with a single multi-path PATCH request on the client's
+ * table.
+ * 
+ * @param[in] client HTTP client handle
+ * @param[in] records Array of sensor records
+ * @param[in] len Number of records
+ * 
+ * @retval 0 PATCH request successful
+ * @retval -1 PATCH request failed
+ * 
+ * @see send_records(), json_codec
+ * 
+ */
+int patch_records(esp_http_client_handle_t client, 
+    const sensor_record* records, int len);
+
 /**
  * @brief Retrieve data from Firebase
  * 
@@ -107,6 +368,25 @@ int patch_data(esp_http_client_handle_t client, const char* json_data);
  */
 int get_data(esp_http_client_handle_t client, char* buffer, int len);
 
+/**
+ * @brief Retrieve data from Firebase in chunks
+ * 
+ * Performs HTTP GET request and passes the response body to the callback as
+ * it is received, without buffering the full response.
+ * 
+ * @param[in] client client handle
+ * @param[in] callback Consumer for response chunks
+ * @param[in] ctx User context for callback
+ * 
+ * @retval 0 GET request successful
+ * @retval -1 GET request failed or response rejected
+ * 
+ * @see setup_client()
+ * 
+ */
+int get_stream(esp_http_client_handle_t client, data_callback callback,
+    void* ctx);
+
 /**
  * @brief Clean up and close HTTP client
  * 
@@ -118,4 +398,50 @@ int get_data(esp_http_client_handle_t client, char* buffer, int len);
  */
 void close_client(esp_http_client_handle_t client);
 
+/**
+ * @brief Borrow a persistent HTTP client from the connection pool
+ * 
+ * Returns a long-lived client handle for the host in firebase_url, pointed at
+ * the given data table. The underlying TLS connection is kept alive between
+ * requests and only re-established when it fails, the server drops it or it
+ * has been idle for longer than REST_IDLE_CLOSE_MS.
+ * 
+ * @param[in] data_table_name Name of database table for data storage
+ * @param[in] firebase_url Base URL of database
+ * @param[in] firebase_api_key Firebase API key for authentication
+ * 
+ * @return esp_http_client_handle_t: Pooled HTTP client handle
+ * @retval NULL Client: Setup failed or firebase_url longer than the pool
+ * stores
+ * 
+ * @note Client must be returned with release_client() when done
+ * @note If every pooled handle is in use, a temporary client is created and
+ * cleaned up on release.
+ * 
+ * @see release_client()
+ * 
+ */
+esp_http_client_handle_t acquire_client(const char* data_table_name, 
+    const char* firebase_url, const char* firebase_api_key);
+
+/**
+ * @brief Return a client to the connection pool
+ * 
+ * @param[in] client Client handle from acquire_client()
+ * @param[in] failed Non-zero if a request on the client failed, which closes
+ * the connection so that the next request reconnects
+ * 
+ * @see acquire_client()
+ * 
+ */
+void release_client(esp_http_client_handle_t client, int failed);
+
+/**
+ * @brief Get connection pool counters
+ * 
+ * @return conn_stats: Snapshot of pool counters since boot
+ * 
+ */
+conn_stats get_conn_stats(void);
+
 #endif
\ No newline at end of file
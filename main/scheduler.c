@@ -0,0 +1,308 @@
+#include "scheduler.h"
+
+#include <string.h>
+#include <sys/time.h>
+
+#include "planter_utils.h"
+
+static sched_config config;
+static sched_event events[SCHED_MAX_EVENTS];
+static int num_events = 0;
+static TaskHandle_t sched_handle = NULL;
+static time_t last_run[SCHED_MAX_EVENTS];   // Deadline last run, 0 if none
+static time_t checked = 0;                  // Clock when due events last ran
+static portMUX_TYPE sched_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static time_t next_watering(int valve_id, time_t after) {
+    int times[MAX_WATERING_TIMES];
+    int num_times = get_watering_times(config.valves[valve_id].name, times);
+
+    struct tm today;
+    localtime_r(&after, &today);
+
+    time_t next = -1;
+    for (int i = 0; i < num_times; i++) {
+        if (times[i] < 0 || times[i] > 23) {
+            continue;
+        }
+
+        // Today if the hour is still ahead, tomorrow otherwise
+        for (int day = 0; day < 2; day++) {
+            struct tm when = today;
+            when.tm_mday += day;
+            when.tm_hour = times[i];
+            when.tm_min = 0;
+            when.tm_sec = 0;
+            when.tm_isdst = -1;
+
+            time_t deadline = mktime(&when);
+            if (deadline > after) {
+                if (next == -1 || deadline < next) {
+                    next = deadline;
+                }
+                break;
+            }
+        }
+    }
+
+    return next;
+}
+
+static time_t next_aligned(int interval, time_t after) {
+    return (after / interval + 1) * interval;
+}
+
+static time_t next_deadline(const sched_event* event, time_t after) {
+    switch (event->type) {
+        case SCHED_WATER:
+            return next_watering(event->valve_id, after);
+        case SCHED_REPORT:
+            return next_aligned(config.report_interval, after);
+        case SCHED_PARAM_SYNC:
+            return next_aligned(config.sync_interval, after);
+        default:
+            return -1;
+    }
+}
+
+static void add_event(const sched_event* event) {
+    if (event->deadline == -1 || num_events == SCHED_MAX_EVENTS) {
+        return;
+    }
+
+    // Insert in deadline order
+    int i = num_events;
+    while (i > 0 && events[i - 1].deadline > event->deadline) {
+        events[i] = events[i - 1];
+        i--;
+    }
+    events[i] = *event;
+    num_events++;
+}
+
+static int list_events(time_t after, sched_event* list) {
+    int count = 0;
+
+    for (int i = 0; i < config.num_valves; i++) {
+        list[count].type = SCHED_WATER;
+        list[count].valve_id = i;
+        count++;
+    }
+    if (config.report_interval > 0) {
+        list[count].type = SCHED_REPORT;
+        list[count].valve_id = -1;
+        count++;
+    }
+    if (config.sync_interval > 0) {
+        list[count].type = SCHED_PARAM_SYNC;
+        list[count].valve_id = -1;
+        count++;
+    }
+
+    for (int i = 0; i < count; i++) {
+        list[i].deadline = next_deadline(&list[i], after);
+    }
+
+    return count;
+}
+
+static int event_slot(const sched_event* event) {
+    switch (event->type) {
+        case SCHED_WATER:
+            return event->valve_id;
+        case SCHED_REPORT:
+            return SCHED_MAX_VALVES;
+        default:
+            return SCHED_MAX_VALVES + 1;
+    }
+}
+
+static void build_table(time_t now) {
+    sched_event list[SCHED_MAX_EVENTS];
+    int count = list_events(now, list);
+
+    // Deadlines a clock step passed over run once, those already run do not
+    // run again
+    for (int i = 0; i < count; i++) {
+        time_t from = last_run[event_slot(&list[i])];
+        if (checked > from) {
+            from = checked;
+        }
+        if (from > 0 && from != now && from - now <= SCHED_MAX_STEP &&
+            now - from <= SCHED_MAX_STEP) {
+                list[i].deadline = next_deadline(&list[i], from);
+        }
+    }
+
+    taskENTER_CRITICAL(&sched_lock);
+    num_events = 0;
+    for (int i = 0; i < count; i++) {
+        add_event(&list[i]);
+    }
+    taskEXIT_CRITICAL(&sched_lock);
+}
+
+static void run_event(const sched_event* event) {
+    switch (event->type) {
+        case SCHED_WATER:
+            // Valves are driven by the valve scheduler without blocking
+            scheduler_water(event->valve_id);
+            break;
+        case SCHED_REPORT:
+            if (config.report_task != NULL) {
+                xTaskNotifyGive(config.report_task);
+            }
+            break;
+        case SCHED_PARAM_SYNC:
+            if (config.sync_task != NULL) {
+                xTaskNotifyGive(config.sync_task);
+            }
+            break;
+    }
+}
+
+static void scheduler_task(void *pvParameters) {
+    bool rebuild = true;
+
+    while (1) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+
+        // Wait for SNTP before scheduling by wall clock
+        if (tv.tv_sec < SCHED_TIME_VALID) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+            continue;
+        }
+
+        if (rebuild) {
+            build_table(tv.tv_sec);
+            rebuild = false;
+        }
+
+        // Run due events and move each to its next deadline
+        while (1) {
+            taskENTER_CRITICAL(&sched_lock);
+            if (num_events == 0 || events[0].deadline > tv.tv_sec) {
+                taskEXIT_CRITICAL(&sched_lock);
+                break;
+            }
+            sched_event event = events[0];
+            num_events--;
+            memmove(events, events + 1, num_events * sizeof(sched_event));
+            taskEXIT_CRITICAL(&sched_lock);
+
+            run_event(&event);
+            last_run[event_slot(&event)] = event.deadline;
+            event.deadline = next_deadline(&event, tv.tv_sec);
+
+            taskENTER_CRITICAL(&sched_lock);
+            add_event(&event);
+            taskEXIT_CRITICAL(&sched_lock);
+        }
+        checked = tv.tv_sec;
+
+        // Sleep until the first deadline
+        int64_t wait = SCHED_MAX_SLEEP;
+        sched_event next;
+        if (scheduler_next(&next) == 0) {
+            int64_t remaining = (int64_t)next.deadline * 1000 - 
+                ((int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000);
+            if (remaining < wait) {
+                wait = remaining;
+            }
+        }
+
+        // Extra tick so the deadline has passed on wake up
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait) + 1) > 0) {
+            rebuild = true;
+        }
+    }
+}
+
+int scheduler_configure(const sched_config* sched) {
+    if (sched == NULL || sched->num_valves < 0 || sched->report_interval < 0 ||
+        sched->sync_interval < 0) {
+            return -1;
+    }
+
+    config = *sched;
+    if (config.num_valves > SCHED_MAX_VALVES) {
+        printf("ERROR scheduling more than %d valves.\n", SCHED_MAX_VALVES);
+        config.num_valves = SCHED_MAX_VALVES;
+    }
+
+    return 0;
+}
+
+int scheduler_due(time_t since, time_t now, sched_event* due, int max) {
+    sched_event list[SCHED_MAX_EVENTS];
+    int count = list_events(since, list);
+
+    int num_due = 0;
+    for (int i = 0; i < count && num_due < max; i++) {
+        if (list[i].deadline != -1 && list[i].deadline <= now) {
+            due[num_due] = list[i];
+            num_due++;
+        }
+    }
+
+    return num_due;
+}
+
+time_t scheduler_next_after(time_t after) {
+    sched_event list[SCHED_MAX_EVENTS];
+    int count = list_events(after, list);
+
+    time_t next = -1;
+    for (int i = 0; i < count; i++) {
+        if (list[i].deadline != -1 && (next == -1 || list[i].deadline < next)) {
+            next = list[i].deadline;
+        }
+    }
+
+    return next;
+}
+
+int scheduler_start(const sched_config* sched) {
+    if (sched_handle != NULL || scheduler_configure(sched) == -1) {
+        return -1;
+    }
+
+    if (xTaskCreate(scheduler_task, "SchedulerTask", 3072, NULL, 6, 
+        &sched_handle) != pdPASS) {
+            printf("ERROR starting scheduler.\n");
+            sched_handle = NULL;
+            return -1;
+    }
+
+    return 0;
+}
+
+void scheduler_recompute(void) {
+    if (sched_handle != NULL) {
+        xTaskNotifyGive(sched_handle);
+    }
+}
+
+int scheduler_water(int valve_id) {
+    // Band in percent, valves work in hundredths
+    if (moisture_high > 0) {
+        return valve_request_band(valve_id, water_duration*1000, 
+            moisture_low*100, moisture_high*100);
+    }
+
+    return valve_request(valve_id, water_duration*1000);
+}
+
+int scheduler_next(sched_event* event) {
+    int status = -1;
+
+    taskENTER_CRITICAL(&sched_lock);
+    if (num_events > 0) {
+        *event = events[0];
+        status = 0;
+    }
+    taskEXIT_CRITICAL(&sched_lock);
+
+    return status;
+}
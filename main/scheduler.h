@@ -0,0 +1,192 @@
+/**
+ * @file scheduler.h
+ * @brief Wall clock scheduler for watering, reporting and parameter sync
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Keeps a table of upcoming events sorted by deadline and sleeps
+ * until the first one is due, using the SNTP synchronized clock. Watering
+ * events request the valve scheduler, report and sync events wake the task
+ * that does the work. Deadlines come from the wall clock instead of a tick
+ * count, so a scheduled hour is neither skipped nor run twice when ticks
+ * drift. The table is recomputed when the watering parameters change.
+ *
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "solenoid.h"
+
+/**
+ * @def SCHED_MAX_VALVES
+ * @brief Maximum number of valves with watering events
+ *
+ */
+#define SCHED_MAX_VALVES 8
+
+/**
+ * @def SCHED_MAX_EVENTS
+ * @brief Size of the event table (one per valve, report and sync)
+ *
+ */
+#define SCHED_MAX_EVENTS (SCHED_MAX_VALVES + 2)
+
+/**
+ * @def SCHED_TIME_VALID
+ * @brief Earliest valid clock time (January 1, 2021)
+ *
+ * @note The clock is not set before the first SNTP sync.
+ *
+ */
+#define SCHED_TIME_VALID 1609459200
+
+/**
+ * @def SCHED_MAX_SLEEP
+ * @brief Longest sleep between clock checks (in ms)
+ *
+ * @note Bounds how late an event runs when SNTP corrects the clock.
+ *
+ */
+#define SCHED_MAX_SLEEP 600000
+
+/**
+ * @def SCHED_MAX_STEP
+ * @brief Largest clock step (in s) after which skipped deadlines still run
+ *
+ * @note A larger step, e.g. from a clock that was never right, starts the
+ * table over from the new time.
+ *
+ */
+#define SCHED_MAX_STEP 86400
+
+/**
+ * @brief Type of scheduled event
+ *
+ */
+typedef enum {
+    SCHED_WATER,                /**< Open a valve */
+    SCHED_REPORT,               /**< Read and upload sensors */
+    SCHED_PARAM_SYNC            /**< Poll watering parameters */
+} sched_type;
+
+/**
+ * @brief Entry of the event table
+ *
+ */
+typedef struct {
+    time_t deadline;            /**< Time the event is due */
+    sched_type type;            /**< Event type */
+    int valve_id;               /**< Index of valve, SCHED_WATER only */
+} sched_event;
+
+/**
+ * @brief Scheduler settings
+ *
+ * Report and sync events are aligned to multiples of their interval on the
+ * wall clock, e.g. the top of every hour for a 3600 second interval.
+ *
+ */
+typedef struct {
+    valve* valves;              /**< Array of valves, must stay valid */
+    int num_valves;             /**< Number of valves */
+    TaskHandle_t report_task;   /**< Task notified on report */
+    int report_interval;        /**< Time between reports (in s), 0 if unused */
+    TaskHandle_t sync_task;     /**< Task notified on sync */
+    int sync_interval;          /**< Time between polls (in s), 0 if unused */
+} sched_config;
+
+/**
+ * @brief Set scheduler settings without starting the task
+ *
+ * Used to query deadlines with scheduler_due() and scheduler_next_after()
+ * when the caller runs events itself, e.g. between deep sleep cycles.
+ *
+ * @param[in] config Scheduler settings
+ *
+ * @retval 0 Success
+ * @retval -1 Invalid settings
+ *
+ */
+int scheduler_configure(const sched_config* config);
+
+/**
+ * @brief List the events due in a time window
+ *
+ * @param[in] since Start of window (exclusive), e.g. time of last run
+ * @param[in] now End of window (inclusive)
+ * @param[out] due Destination for due events
+ * @param[in] max Size of due, at least SCHED_MAX_EVENTS
+ *
+ * @return Number of due events
+ *
+ */
+int scheduler_due(time_t since, time_t now, sched_event* due, int max);
+
+/**
+ * @brief Get the first deadline after a time
+ *
+ * @param[in] after Time to search from
+ *
+ * @return Deadline of the first event, or -1 if none is scheduled
+ *
+ */
+time_t scheduler_next_after(time_t after);
+
+/**
+ * @brief Start the scheduler task
+ *
+ * Events are only scheduled once the clock has been set by SNTP.
+ *
+ * @param[in] config Scheduler settings
+ *
+ * @retval 0 Success
+ * @retval -1 Fail
+ *
+ * @warning valve_scheduler_start() must be called before function call
+ *
+ */
+int scheduler_start(const sched_config* config);
+
+/**
+ * @brief Rebuild the event table
+ *
+ * Call after the watering parameters change or the clock is set. Returns
+ * immediately, the table is rebuilt by the scheduler task. Deadlines a
+ * forward clock step passed over run once, and deadlines already run before
+ * a backward step are not run again.
+ *
+ */
+void scheduler_recompute(void);
+
+/**
+ * @brief Request watering of a valve with the current parameters
+ * 
+ * Waters by moisture band when moisture_high is set, for water_duration
+ * otherwise. Returns immediately.
+ * 
+ * @param[in] valve_id Index of valve
+ * 
+ * @retval 0 Request queued
+ * @retval -1 Fail
+ * 
+ */
+int scheduler_water(int valve_id);
+
+/**
+ * @brief Get the next event due
+ *
+ * @param[out] event Next event
+ *
+ * @retval 0 Success
+ * @retval -1 No event scheduled
+ *
+ */
+int scheduler_next(sched_event* event);
+
+#endif
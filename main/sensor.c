@@ -1,92 +1,398 @@
 #include "sensor.h"
 
-adc_oneshot_unit_handle_t init_adc(adc_unit_t adc_unit, sensor* sensor_list, 
-    int len) {
-        adc_oneshot_unit_handle_t adc1_handle;
+#include "freertos/semphr.h"
 
-        adc_oneshot_unit_init_cfg_t unit_config = {
-            .unit_id = ADC_UNIT_1
-        };
-        adc_oneshot_new_unit(&unit_config, &adc1_handle);
+/**
+ * @brief ADC reader state
+ * 
+ */
+struct adc_reader {
+    sens_mode mode;
+    adc_oneshot_unit_handle_t oneshot[ADC_MAX_UNITS]; // NULL if unit unused
+    adc_continuous_handle_t continuous;
+    TaskHandle_t demux_task;
+    sensor* sensors;                        // Sensors fed by demux task
+    int num_sensors;
+    volatile int latest[ADC_MAX_UNITS][ADC_MAX_CHANNELS]; // Latest per channel
+    SemaphoreHandle_t lock[ADC_MAX_UNITS];  // Oneshot reads and their filters
+};
 
-        adc_oneshot_chan_cfg_t channel_config = {
-            .atten = ADC_ATTEN_DB_12,
-            .bitwidth = ADC_BITWIDTH_12
-        };
+static bool IRAM_ATTR on_conv_done(adc_continuous_handle_t handle, 
+    const adc_continuous_evt_data_t* edata, void* user_data) {
+        adc_reader* reader = (adc_reader*)user_data;
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(reader->demux_task, &woken);
 
-        for (int i = 0; i < len; i++) {
-            adc_oneshot_config_channel(adc1_handle, sensor_list[i].channel, 
-                &channel_config);
+        return woken == pdTRUE;
+}
+
+static void demux_task(void *pvParameters) {
+    adc_reader* reader = (adc_reader*)pvParameters;
+    uint8_t frame[ADC_FRAME_SIZE];
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Drain every finished frame
+        uint32_t len = 0;
+        while (adc_continuous_read(reader->continuous, frame, ADC_FRAME_SIZE, 
+            &len, 0) == ESP_OK) {
+                int sums[ADC_MAX_UNITS][ADC_MAX_CHANNELS] = {0};
+                int counts[ADC_MAX_UNITS][ADC_MAX_CHANNELS] = {0};
+
+                // Sort conversion results by unit and channel
+                for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; 
+                    i += SOC_ADC_DIGI_RESULT_BYTES) {
+                        adc_digi_output_data_t* result = 
+                            (adc_digi_output_data_t*)&frame[i];
+                        int unit = result->type2.unit;
+                        int chan = result->type2.channel;
+                        if (unit >= ADC_MAX_UNITS || chan >= ADC_MAX_CHANNELS) {
+                            continue;
+                        }
+                        sums[unit][chan] += result->type2.data;
+                        counts[unit][chan]++;
+
+                        // Every sample goes through the sensor's filter
+                        for (int j = 0; j < reader->num_sensors; j++) {
+                            sensor* sens = &reader->sensors[j];
+                            if ((int)sens->unit == unit && 
+                                (int)sens->channel == chan) {
+                                    filter_push(&sens->filter, 
+                                        result->type2.data);
+                            }
+                        }
+                }
+
+                // Frame average is the latest value of each channel
+                for (int unit = 0; unit < ADC_MAX_UNITS; unit++) {
+                    for (int chan = 0; chan < ADC_MAX_CHANNELS; chan++) {
+                        if (counts[unit][chan] > 0) {
+                            reader->latest[unit][chan] = sums[unit][chan] / 
+                                counts[unit][chan];
+                        }
+                    }
+                }
+        }
+    }
+}
+
+static int init_continuous(adc_reader* reader, sensor* sensor_list, int len) {
+    // Sensors past the end of the scan pattern would never be read
+    if (len > SOC_ADC_PATT_LEN_MAX) {
+        printf("ERROR %d sensors, continuous ADC scans at most %d.\n", len,
+            SOC_ADC_PATT_LEN_MAX);
+        return -1;
+    }
+
+    // DMA scans of ADC2 are not arbitrated with WiFi, which also uses it
+    for (int i = 0; i < len; i++) {
+        if (sensor_list[i].unit != ADC_UNIT_1) {
+            printf("ERROR %s is on ADC%d, continuous ADC scans only ADC1.\n",
+                sensor_list[i].name, sensor_list[i].unit + 1);
+            return -1;
+        }
+    }
+
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = ADC_FRAME_SIZE * 4,
+        .conv_frame_size = ADC_FRAME_SIZE
+    };
+    if (adc_continuous_new_handle(&handle_config, 
+        &reader->continuous) != ESP_OK) {
+            printf("ERROR creating continuous ADC handle.\n");
+            return -1;
+    }
+
+    // Scan pattern with one entry per sensor channel
+    adc_digi_pattern_config_t pattern[SOC_ADC_PATT_LEN_MAX] = {0};
+    for (int i = 0; i < len; i++) {
+        pattern[i].atten = ADC_ATTEN_DB_12;
+        pattern[i].channel = sensor_list[i].channel;
+        pattern[i].unit = sensor_list[i].unit;
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    adc_continuous_config_t dig_config = {
+        .pattern_num = len,
+        .adc_pattern = pattern,
+        .sample_freq_hz = ADC_SAMPLE_FREQ_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2
+    };
+    if (adc_continuous_config(reader->continuous, &dig_config) != ESP_OK) {
+        printf("ERROR configuring continuous ADC.\n");
+        return -1;
+    }
+
+    if (xTaskCreate(demux_task, "AdcDemuxTask", 3072, reader, 6, 
+        &reader->demux_task) != pdPASS) {
+            printf("ERROR starting ADC demux task.\n");
+            return -1;
+    }
+
+    adc_continuous_evt_cbs_t callbacks = {
+        .on_conv_done = on_conv_done
+    };
+    adc_continuous_register_event_callbacks(reader->continuous, &callbacks, 
+        reader);
+
+    if (adc_continuous_start(reader->continuous) != ESP_OK) {
+        printf("ERROR starting continuous ADC.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static void free_reader(adc_reader* reader) {
+    if (reader->continuous != NULL) {
+        adc_continuous_deinit(reader->continuous);
+    }
+    for (int unit = 0; unit < ADC_MAX_UNITS; unit++) {
+        if (reader->oneshot[unit] != NULL) {
+            adc_oneshot_del_unit(reader->oneshot[unit]);
+        }
+        if (reader->lock[unit] != NULL) {
+            vSemaphoreDelete(reader->lock[unit]);
+        }
+    }
+    free(reader);
+}
+
+static int init_oneshot(adc_reader* reader, sensor* sensor_list, int len) {
+    adc_oneshot_chan_cfg_t channel_config = {
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_12
+    };
+
+    for (int i = 0; i < len; i++) {
+        // One handle per unit, created by its first sensor
+        adc_unit_t unit = sensor_list[i].unit;
+        if (reader->oneshot[unit] == NULL) {
+            adc_oneshot_unit_init_cfg_t unit_config = {
+                .unit_id = unit
+            };
+            if (adc_oneshot_new_unit(&unit_config, 
+                &reader->oneshot[unit]) != ESP_OK) {
+                    printf("ERROR creating ADC%d handle.\n", unit + 1);
+                    return -1;
+            }
+
+            // Sensors are read by the report task and the valve task, units
+            // are read independently
+            reader->lock[unit] = xSemaphoreCreateMutex();
+            if (reader->lock[unit] == NULL) {
+                printf("ERROR creating ADC%d lock.\n", unit + 1);
+                return -1;
+            }
         }
 
-        return adc1_handle;
+        adc_oneshot_config_channel(reader->oneshot[unit], 
+            sensor_list[i].channel, &channel_config);
+    }
+
+    return 0;
 }
 
-void sens_calibrate(adc_oneshot_unit_handle_t adc_handle, 
-    sensor* sensors, int len) {
+adc_reader* init_adc(sensor* sensor_list, int len, sens_mode mode) {
+    for (int i = 0; i < len; i++) {
+        if (sensor_list[i].unit >= ADC_MAX_UNITS || 
+            sensor_list[i].channel >= ADC_MAX_CHANNELS) {
+                printf("ERROR invalid ADC unit or channel of %s.\n", 
+                    sensor_list[i].name);
+                return NULL;
+        }
+    }
+
+    adc_reader* reader = calloc(1, sizeof(adc_reader));
+    if (reader == NULL) {
+        printf("ERROR allocating ADC reader.\n");
+        return NULL;
+    }
+    reader->mode = mode;
+    reader->sensors = sensor_list;
+    reader->num_sensors = len;
+    for (int i = 0; i < len; i++) {
+        filter_reset(&sensor_list[i].filter);
+        sens_set_calibration(&sensor_list[i], sensor_list[i].mean_dry, 
+            sensor_list[i].mean_wet);
+    }
+    for (int unit = 0; unit < ADC_MAX_UNITS; unit++) {
+        for (int chan = 0; chan < ADC_MAX_CHANNELS; chan++) {
+            reader->latest[unit][chan] = -1;
+        }
+    }
+
+    int status = mode == SENS_MODE_CONTINUOUS ? 
+        init_continuous(reader, sensor_list, len) : 
+        init_oneshot(reader, sensor_list, len);
+    if (status == -1) {
+        free_reader(reader);
+        return NULL;
+    }
+
+    return reader;
+}
+
+void sens_calibrate(adc_reader* adc_handle, sensor* sensors, int len) {
         // Dry calibration
         button_interrupt("Press button to start DRY calibration.\n");
         for (int i = 0; i < len; i++) {
-            int output;
-            double dry_vals[CALIBRATION_X];
+            int dry_vals[CALIBRATION_X];
 
             printf("Starting DRY calibration for %s.\n", sensors[i].name);
             for (int j = 0; j < CALIBRATION_X; j++) {
-                adc_oneshot_read(adc_handle, sensors[i].channel, &output);
-                dry_vals[j] = (double)output;
-                printf("%f\n", dry_vals[j]);
+                dry_vals[j] = read_sens(adc_handle, sensors[i].unit, 
+                    sensors[i].channel);
+                printf("%d\n", dry_vals[j]);
                 vTaskDelay(500 / portTICK_PERIOD_MS);
             }
 
             sensors[i].mean_dry = arr_avg(dry_vals, CALIBRATION_X);
-            printf("MEAN_DRY: %f\n", sensors[i].mean_dry);
+            printf("MEAN_DRY: %d\n", sensors[i].mean_dry);
         }
 
         // Wet calibration
         button_interrupt("Press button to start WET calibration.\n");
         for (int i = 0; i < len; i++) {
-            int output;
-            double wet_vals[CALIBRATION_X];
+            int wet_vals[CALIBRATION_X];
 
             printf("Starting WET calibration for %s.\n", sensors[i].name);
             for (int j = 0; j < CALIBRATION_X; j++) {
-                adc_oneshot_read(adc_handle, sensors[i].channel, &output);
-                wet_vals[j] = (double)output;
-                printf("%f\n", wet_vals[j]);
+                wet_vals[j] = read_sens(adc_handle, sensors[i].unit, 
+                    sensors[i].channel);
+                printf("%d\n", wet_vals[j]);
                 vTaskDelay(500 / portTICK_PERIOD_MS);
             }
 
             sensors[i].mean_wet = arr_avg(wet_vals, CALIBRATION_X);
-            printf("MEAN_WET: %f\n", sensors[i].mean_wet);
+            printf("MEAN_WET: %d\n", sensors[i].mean_wet);
+        }
+
+        for (int i = 0; i < len; i++) {
+            sens_set_calibration(&sensors[i], sensors[i].mean_dry, 
+                sensors[i].mean_wet);
+        }
+}
+
+static int read_oneshot(adc_reader* handle, adc_unit_t unit, 
+    adc_channel_t chan) {
+        // ADC2 times out while WiFi holds it, try again once released
+        int reading;
+        esp_err_t err = adc_oneshot_read(handle->oneshot[unit], chan, 
+            &reading);
+        for (int i = 0; err == ESP_ERR_TIMEOUT && i < ADC2_READ_RETRIES; i++) {
+            vTaskDelay(pdMS_TO_TICKS(ADC2_RETRY_MS));
+            err = adc_oneshot_read(handle->oneshot[unit], chan, &reading);
+        }
+        if (err != ESP_OK) {
+            return -1;
         }
+
+        return reading;
 }
 
-int read_sens(adc_oneshot_unit_handle_t handle, adc_channel_t chan) {
-    int reading;
-    adc_oneshot_read(handle, chan, &reading);
+int read_sens(adc_reader* handle, adc_unit_t unit, adc_channel_t chan) {
+    if (handle == NULL || unit >= ADC_MAX_UNITS || chan >= ADC_MAX_CHANNELS) {
+        return -1;
+    }
+
+    // Latest value sorted by demux task
+    if (handle->mode == SENS_MODE_CONTINUOUS) {
+        return handle->latest[unit][chan];
+    }
+    if (handle->oneshot[unit] == NULL) {
+        return -1;
+    }
+
+    xSemaphoreTake(handle->lock[unit], portMAX_DELAY);
+    int reading = read_oneshot(handle, unit, chan);
+    xSemaphoreGive(handle->lock[unit]);
 
     return reading;
 }
 
-double map(sensor sens, double val) {
-    double mapped_val = ((val - sens.mean_dry) / (sens.mean_wet - 
-        sens.mean_dry));
-    
+int read_filtered(adc_reader* handle, sensor* sens) {
+    if (handle == NULL) {
+        return -1;
+    }
+
+    // Filtered in the background by demux task
+    if (handle->mode == SENS_MODE_CONTINUOUS) {
+        return sens->filter.output;
+    }
+
+    if (sens->unit >= ADC_MAX_UNITS || sens->channel >= ADC_MAX_CHANNELS ||
+        handle->oneshot[sens->unit] == NULL) {
+            return -1;
+    }
+
+    // Burst of readings to fill the filter, one caller per unit at a time
+    SemaphoreHandle_t lock = handle->lock[sens->unit];
+    xSemaphoreTake(lock, portMAX_DELAY);
+    filter_reset(&sens->filter);
+    int burst = filter_burst_len(&sens->filter);
+    int status = 0;
+    for (int i = 0; i < burst && status == 0; i++) {
+        int reading = read_oneshot(handle, sens->unit, sens->channel);
+        if (reading == -1) {
+            status = -1;
+        }
+        else {
+            filter_push(&sens->filter, reading);
+        }
+    }
+    int output = status == -1 ? -1 : sens->filter.output;
+    xSemaphoreGive(lock);
+
+    return output;
+}
+
+int sens_read_moisture(adc_reader* handle, sensor* sens) {
+    // Failed reads are -1, which map() would clamp to fully wet
+    int raw = read_filtered(handle, sens);
+    if (raw < 0) {
+        return -1;
+    }
+
+    return map(sens, raw);
+}
+
+void sens_set_calibration(sensor* sens, int dry, int wet) {
+    sens->mean_dry = dry;
+    sens->mean_wet = wet;
+
+    if (wet == dry) {
+        sens->scale = 0;
+        return;
+    }
+
+    // 10000 hundredths over the calibrated span, rounded to nearest
+    int64_t span = wet - dry;
+    int64_t full = (int64_t)10000 << 16;
+    sens->scale = (int32_t)((full + (span > 0 ? span : -span) / 2) / span);
+}
+
+int map(const sensor* sens, int val) {
+    int32_t mapped_val = (int32_t)(((int64_t)(val - sens->mean_dry) * 
+        sens->scale + (1 << 15)) >> 16);
+
     if (mapped_val < 0) {
-        mapped_val = 0.00;
+        mapped_val = 0;
     }
-    else if (mapped_val > 1) {
-        mapped_val = 1.00;
+    else if (mapped_val > 10000) {
+        mapped_val = 10000;
     }
 
     return mapped_val;
 }
 
-double arr_avg(double* arr, int len) {
-    double total = 0;
+int arr_avg(const int* arr, int len) {
+    int total = 0;
     for (int i = 0; i < len; i++) {
         total += arr[i];
     }
 
-    return total / (double)len;
-}
\ No newline at end of file
+    return (total + len / 2) / len;
+}
@@ -16,9 +16,12 @@
 #define SENSOR_H
 
 #include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_continuous.h"
+#include "filter.h"
 #include "planter_utils.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_attr.h"
 #include "esp_mac.h"
 
 /**
@@ -60,6 +63,65 @@
  */
 #define DEFAULT_WET 1000
 
+/**
+ * @def ADC_SAMPLE_FREQ_HZ
+ * @brief Conversion rate of continuous sampling (in Hz)
+ * 
+ * Conversions are shared between all configured channels.
+ * 
+ */
+#define ADC_SAMPLE_FREQ_HZ 1000
+
+/**
+ * @def ADC_FRAME_SIZE
+ * @brief Bytes of conversion results handled per DMA frame
+ * 
+ */
+#define ADC_FRAME_SIZE 256
+
+/**
+ * @def ADC_MAX_CHANNELS
+ * @brief Number of channels on one ADC unit
+ * 
+ */
+#define ADC_MAX_CHANNELS 10
+
+/**
+ * @def ADC_MAX_UNITS
+ * @brief Number of ADC units (ADC1 and ADC2)
+ * 
+ */
+#define ADC_MAX_UNITS 2
+
+/**
+ * @def ADC2_READ_RETRIES
+ * @brief Retries of an ADC2 oneshot read while WiFi holds the unit
+ * 
+ */
+#define ADC2_READ_RETRIES 5
+
+/**
+ * @def ADC2_RETRY_MS
+ * @brief Delay between ADC2 oneshot read retries (in ms)
+ * 
+ */
+#define ADC2_RETRY_MS 10
+
+/**
+ * @brief ADC sampling mode
+ * 
+ */
+typedef enum {
+    SENS_MODE_ONESHOT,          /**< Blocking driver read per reading */
+    SENS_MODE_CONTINUOUS        /**< DMA scan of all channels in background */
+} sens_mode;
+
+/**
+ * @brief ADC reader returned by init_adc()
+ * 
+ */
+typedef struct adc_reader adc_reader;
+
 /**
  * @brief Soil moisture sensor configuration structure
  * 
@@ -69,32 +131,43 @@
  */
 typedef struct {
     char name[50];              /**< Sensor identification string */
+    adc_unit_t unit;            /**< ADC unit (ADC_UNIT_1 if not set) */
     adc_channel_t channel;      /**< ADC channel number (e.g. ADC_CHANNEL_3) */
-    double mean_dry;            /**< Calibrated dry ADC reading */
-    double mean_wet;            /**< Calibrated wet ADC reading */
+    int mean_dry;               /**< Calibrated dry ADC reading */
+    int mean_wet;               /**< Calibrated wet ADC reading */
+    int32_t scale;              /**< Q16 hundredths of a percent per count */
+    sens_filter filter;         /**< Filter settings and state of channel */
 } sensor;
 
 /**
  * @brief Initialize ADC pins on ESP32
  * 
- * Configures specified ADC unit(s) and channel(s) for soil moisture sensors.
- * ADC pins are setup with appropriate bit width and attenuation for accurate
- * moisture level measurements.
+ * Configures the ADC unit and channel of every sensor for soil moisture
+ * sensors. ADC pins are setup with appropriate bit width and attenuation for
+ * accurate moisture level measurements. Sensors can be spread over ADC1 and
+ * ADC2, each unit in use gets its own driver handle.
+ * 
+ * In SENS_MODE_CONTINUOUS, every sensor channel is scanned by DMA at
+ * ADC_SAMPLE_FREQ_HZ and results are sorted per channel by a background task,
+ * so read_sens() only looks up the latest value. The scan pattern holds at
+ * most SOC_ADC_PATT_LEN_MAX channels, more sensors than that are rejected.
+ * 
+ * ADC2 is shared with the WiFi driver, which has priority. Oneshot reads of
+ * ADC2 are retried while WiFi holds the unit. DMA scans have no such
+ * arbitration, so continuous mode rejects sensors on ADC2.
  * 
- * @param[in] adc_unit ADC pin unit (e.g. ADC_UNIT_1)
  * @param[in] sensor_list Array of sensor strctures
  * @param[in] len Number of sensors in array
+ * @param[in] mode Sampling mode
  * 
- * @return adc_oneshot_unit_handle_t: Configured ADC unit handle, or NULL on
- * failure
+ * @return adc_reader*: Configured ADC reader, or NULL on failure
  * 
  * @note Must be called before sensor readings
  * @warning Ensure all sensor units and channels are valid
  * @see read_sens()
  * 
  */
-adc_oneshot_unit_handle_t init_adc(adc_unit_t adc_unit, sensor* sensor_list, 
-    int len);
+adc_reader* init_adc(sensor* sensor_list, int len, sens_mode mode);
 
 /**
  * @brief Calibrate moisture sensors
@@ -103,23 +176,25 @@ adc_oneshot_unit_handle_t init_adc(adc_unit_t adc_unit, sensor* sensor_list,
  * conditions. Calculates and stores mean calibration values for each sensor
  * for accurate sensor mapping.
  * 
- * @param[in] adc_handle ADC unit handle
+ * @param[in] adc_handle ADC reader
  * @param[in, out] sensors Array of sensor structures
  * @param[in] len Number of sensors
  * 
  * @warning init_adc() must be called before function call
  * 
  */
-void sens_calibrate(adc_oneshot_unit_handle_t adc_handle, 
-    sensor* sensors, int len);
+void sens_calibrate(adc_reader* adc_handle, sensor* sensors, int len);
 
 /**
  * @brief Read raw ADC value from moisture sensor
  * 
  * Performs a single shot ADC reading from a specified sensor channel and
- * returns the raw digital value. Should be used with map() function.
+ * returns the raw digital value. In continuous mode, returns the latest
+ * averaged value of the channel without a driver call. Should be used with
+ * map() function.
  * 
- * @param[in] handle ADC unit handle
+ * @param[in] handle ADC reader
+ * @param[in] unit ADC unit
  * @param[in] chan ADC channel
  * 
  * @return Raw sensor reading
@@ -129,37 +204,91 @@ void sens_calibrate(adc_oneshot_unit_handle_t adc_handle,
  * @see init_adc()
  * 
  */
-int read_sens(adc_oneshot_unit_handle_t handle, adc_channel_t chan);
+int read_sens(adc_reader* handle, adc_unit_t unit, adc_channel_t chan);
+
+/**
+ * @brief Read filtered ADC value from moisture sensor
+ * 
+ * Returns the output of the sensor's filter stage. In continuous mode, every
+ * sample of the channel is filtered in the background and the latest value is
+ * returned. In oneshot mode, a burst of readings is taken to fill the filter.
+ * Bursts on a unit are taken one at a time, so tasks can read sensors of the
+ * same reader. ADC1 is not held up by ADC2 reads that wait for WiFi.
+ * 
+ * @param[in] handle ADC reader
+ * @param[in, out] sens Sensor structure with filter state
+ * 
+ * @return Filtered sensor reading
+ * @retval -1 Reading failed
+ * 
+ * @see map()
+ * @see filter_push()
+ * 
+ */
+int read_filtered(adc_reader* handle, sensor* sens);
+
+/**
+ * @brief Read the moisture of a sensor
+ * 
+ * Maps the output of read_filtered(). A sensor without a reading, e.g. before
+ * the first continuous frame, reports failure instead of a mapped value.
+ * 
+ * @param[in] handle ADC reader
+ * @param[in, out] sens Sensor structure with filter state
+ * 
+ * @return Moisture in hundredths of a percent (0 - 10000)
+ * @retval -1 Reading failed
+ * 
+ * @see read_filtered()
+ * @see map()
+ * 
+ */
+int sens_read_moisture(adc_reader* handle, sensor* sens);
+
+/**
+ * @brief Precompute mapping scale from calibration readings
+ * 
+ * Stores the dry and wet readings and the fixed-point scale used by map(), so
+ * a reading is mapped with a single multiply and shift.
+ * 
+ * @param[in, out] sens Sensor structure
+ * @param[in] dry Calibrated dry ADC reading
+ * @param[in] wet Calibrated wet ADC reading
+ * 
+ * @note Called by init_adc() and sens_calibrate(). Call again after changing
+ * mean_dry or mean_wet directly.
+ * 
+ */
+void sens_set_calibration(sensor* sens, int dry, int wet);
 
 /**
  * @brief Converts raw sensor reading to a moisture percentage
  * 
- * Maps raw sensor reading to moisture percentage (0 - 1) using calibrated
- * data.
+ * Maps raw sensor reading to moisture in hundredths of a percent
+ * (0 - 10000) using calibrated data.
  * 
  * @param[in] sens Sensor structure
  * @param[in] val Raw ADC reading value
  * 
- * @return Moisture percentage (0.0 - 1.0)
- * @warning Mapped values are clamped from 0 to 1
- * @note Return value must be multiplied by 100 for percentage
+ * @return Moisture in hundredths of a percent (0 - 10000)
+ * @warning Mapped values are clamped from 0 to 10000
  * 
- * @see sens_calibrate()
+ * @see sens_set_calibration()
  * 
  */
-double map(sensor sens, double val);
+int map(const sensor* sens, int val);
 
 /**
  * @brief Calculate average of array values
  * 
- * Utility function to compute the mean of an array of double values.
+ * Utility function to compute the rounded mean of an array of ADC readings.
  * 
- * @param[in] arr Array of double values
+ * @param[in] arr Array of readings
  * @param[in] len Number of elements in array
  * 
  * @return Mean of array values
  * 
  */
-double arr_avg(double* arr, int len);
+int arr_avg(const int* arr, int len);
 
 #endif
\ No newline at end of file
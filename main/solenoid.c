@@ -1,5 +1,7 @@
 #include "solenoid.h"
 
+#include <stdlib.h>
+
 int setup_valve(const valve *valve_obj, int len) {
     for (int i = 0; i < len; i++) {
         if (gpio_set_direction(valve_obj[i].pin, GPIO_MODE_OUTPUT) != ESP_OK) {
@@ -16,6 +18,9 @@ int setup_valve(const valve *valve_obj, int len) {
             printf("ERROR setting gpio level.\n");
             return -1;
         }
+
+        // Pin may still be held from deep sleep
+        gpio_hold_dis(valve_obj[i].pin);
     }
 
     return 0;
@@ -33,4 +38,289 @@ int set_valve_position(valve valve_obj, valve_level level) {
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Watering request sent to the scheduler task
+ * 
+ */
+typedef struct {
+    int valve_id;
+    TickType_t duration;        // Open time, longest total for a band
+    int low;                    // Moisture band, -1 for timed watering
+    int high;
+} valve_command;
+
+/**
+ * @brief Scheduler state of one valve
+ * 
+ */
+typedef struct {
+    bool open;
+    bool pending;
+    bool soaking;
+    TickType_t duration;        // Open time of the next opening
+    TickType_t close_at;
+    TickType_t budget;          // Open time left for the band
+    TickType_t check_at;        // End of soak
+    int high;                   // Target moisture, -1 for timed watering
+    int pulses;
+} valve_state;
+
+static QueueHandle_t valve_queue = NULL;
+static valve* valves = NULL;
+static valve_state* states = NULL;
+static int num_valves = 0;
+static TickType_t* slot_free_at = NULL;
+static int num_slots = 0;
+static adc_reader* reader = NULL;
+static volatile int active = 0;
+static volatile int in_flight = 0;     // Requests sent but not yet scheduled
+static portMUX_TYPE flight_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Tick comparison that survives counter overflow
+static bool tick_reached(TickType_t now, TickType_t target) {
+    return (int32_t)(now - target) >= 0;
+}
+
+static int read_moisture(int valve_id) {
+    sensor* sens = valves[valve_id].sensor_obj;
+    if (reader == NULL || sens == NULL) {
+        return -1;
+    }
+
+    return sens_read_moisture(reader, sens);
+}
+
+static void queue_pulse(valve_state* state) {
+    TickType_t pulse = pdMS_TO_TICKS(VALVE_PULSE_MS);
+    state->duration = state->budget < pulse ? state->budget : pulse;
+    state->pending = true;
+}
+
+static void check_soak(int valve_id, TickType_t now) {
+    valve_state* state = &states[valve_id];
+    if (!state->soaking || !tick_reached(now, state->check_at)) {
+        return;
+    }
+    state->soaking = false;
+
+    // Pulse again until the band is reached or the budget is used
+    int moisture = read_moisture(valve_id);
+    if (moisture == -1) {
+        printf("ERROR reading sensor of %s.\n", valves[valve_id].name);
+        return;
+    }
+    if (moisture < state->high && state->budget > 0) {
+        queue_pulse(state);
+        return;
+    }
+    printf("%s watered in %d pulses, moisture %d.%02d%%.\n", 
+        valves[valve_id].name, state->pulses, moisture / 100, 
+        moisture % 100);
+}
+
+static void start_request(const valve_command* command) {
+    valve_state* state = &states[command->valve_id];
+    if (state->open || state->pending || state->soaking) {
+        return;
+    }
+
+    state->high = -1;
+    state->pulses = 0;
+    if (command->low >= 0) {
+        int moisture = read_moisture(command->valve_id);
+        if (moisture >= command->low) {
+            printf("%s skipped, moisture %d.%02d%%.\n", 
+                valves[command->valve_id].name, moisture / 100, 
+                moisture % 100);
+            return;
+        }
+
+        // Without a reading the valve is watered for the full time
+        if (moisture != -1) {
+            state->high = command->high;
+            state->budget = command->duration;
+            queue_pulse(state);
+            return;
+        }
+    }
+
+    state->pending = true;
+    state->duration = command->duration;
+}
+
+static TickType_t run_schedule(void) {
+    TickType_t now = xTaskGetTickCount();
+    TickType_t wait = portMAX_DELAY;
+    int count = 0;
+
+    // Close valves that are done, a pulse is followed by a soak
+    for (int i = 0; i < num_valves; i++) {
+        if (states[i].open && tick_reached(now, states[i].close_at)) {
+            set_valve_position(valves[i], VALVE_HIGH);
+            states[i].open = false;
+            if (states[i].high != -1) {
+                states[i].soaking = true;
+                states[i].check_at = now + pdMS_TO_TICKS(VALVE_SOAK_MS);
+            }
+        }
+        check_soak(i, now);
+    }
+
+    // Open waiting valves in order while slots are free
+    for (int i = 0; i < num_valves; i++) {
+        if (!states[i].pending) {
+            continue;
+        }
+        for (int j = 0; j < num_slots; j++) {
+            if (!tick_reached(now, slot_free_at[j])) {
+                continue;
+            }
+            if (set_valve_position(valves[i], VALVE_LOW) == 0) {
+                states[i].open = true;
+                states[i].close_at = now + states[i].duration;
+                states[i].budget -= states[i].high != -1 ? 
+                    states[i].duration : 0;
+                states[i].pulses++;
+                slot_free_at[j] = states[i].close_at + 
+                    states[i].duration * VALVE_REST_FACTOR;
+            }
+            states[i].pending = false;
+            break;
+        }
+    }
+
+    // Sleep until the next valve closes, soak ends or slot frees up
+    for (int i = 0; i < num_valves; i++) {
+        if (states[i].open) {
+            TickType_t remaining = states[i].close_at - now;
+            if (remaining < wait) {
+                wait = remaining;
+            }
+        }
+        if (states[i].soaking) {
+            TickType_t remaining = states[i].check_at - now;
+            if (remaining < wait) {
+                wait = remaining;
+            }
+        }
+        if (states[i].open || states[i].pending || states[i].soaking) {
+            count++;
+        }
+    }
+    for (int j = 0; j < num_slots && count > 0; j++) {
+        if (!tick_reached(now, slot_free_at[j])) {
+            TickType_t remaining = slot_free_at[j] - now;
+            if (remaining < wait) {
+                wait = remaining;
+            }
+        }
+    }
+    active = count;
+
+    return wait;
+}
+
+static void add_in_flight(int count) {
+    taskENTER_CRITICAL(&flight_lock);
+    in_flight += count;
+    taskEXIT_CRITICAL(&flight_lock);
+}
+
+static void valve_task(void *pvParameters) {
+    int started = 0;
+
+    while (1) {
+        TickType_t wait = run_schedule();
+
+        // Request stays in flight until active counts it
+        if (started > 0) {
+            add_in_flight(-started);
+            started = 0;
+        }
+
+        valve_command command;
+        if (xQueueReceive(valve_queue, &command, wait) == pdTRUE) {
+            start_request(&command);
+            started++;
+        }
+    }
+}
+
+int valve_scheduler_start(valve* valve_list, int len, int max_open,
+    adc_reader* adc_handle) {
+        if (valve_queue != NULL || len <= 0 || max_open <= 0) {
+            return -1;
+        }
+
+        states = calloc(len, sizeof(valve_state));
+        slot_free_at = calloc(max_open, sizeof(TickType_t));
+        valve_queue = xQueueCreate(VALVE_QUEUE_LEN, sizeof(valve_command));
+        if (states == NULL || slot_free_at == NULL || valve_queue == NULL) {
+            printf("ERROR allocating valve scheduler.\n");
+            return -1;
+        }
+
+        valves = valve_list;
+        num_valves = len;
+        num_slots = max_open;
+        reader = adc_handle;
+
+        // All slots free at start
+        TickType_t now = xTaskGetTickCount();
+        for (int j = 0; j < num_slots; j++) {
+            slot_free_at[j] = now;
+        }
+
+        if (xTaskCreate(valve_task, "ValveTask", 3072, NULL, 6, 
+            NULL) != pdPASS) {
+                printf("ERROR starting valve scheduler.\n");
+                return -1;
+        }
+
+        return 0;
+}
+
+static int send_command(const valve_command* command) {
+    if (valve_queue == NULL || command->valve_id < 0 || 
+        command->valve_id >= num_valves) {
+            return -1;
+    }
+
+    // Counted before it is queued so no reader sees it missing
+    add_in_flight(1);
+    if (xQueueSend(valve_queue, command, 0) != pdTRUE) {
+        add_in_flight(-1);
+        printf("ERROR valve queue full.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int valve_request(int valve_id, int duration_ms) {
+    valve_command command = {
+        .valve_id = valve_id,
+        .duration = pdMS_TO_TICKS(duration_ms),
+        .low = -1,
+        .high = -1
+    };
+
+    return send_command(&command);
+}
+
+int valve_request_band(int valve_id, int max_ms, int low, int high) {
+    valve_command command = {
+        .valve_id = valve_id,
+        .duration = pdMS_TO_TICKS(max_ms),
+        .low = low,
+        .high = high
+    };
+
+    return send_command(&command);
+}
+
+int valves_active(void) {
+    return active + in_flight;
+}
@@ -11,6 +11,8 @@
 #define SOLENOID_H
 
 #include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include "sensor.h"
 
 #define VALVE_HIGH_NUM 1
@@ -56,4 +58,108 @@ int setup_valve(const valve *valve_obj, int len);
  */
 int set_valve_position(valve valve_obj, valve_level level);
 
+/**
+ * @def VALVE_QUEUE_LEN
+ * @brief Maximum number of watering requests waiting for a free valve slot
+ * 
+ */
+#define VALVE_QUEUE_LEN 16
+
+/**
+ * @def VALVE_REST_FACTOR
+ * @brief Rest time after a valve closes, as a multiple of its open time
+ * 
+ * A valve slot is only reused after the rest time, so water pressure can
+ * recover before the next valve opens.
+ * 
+ */
+#define VALVE_REST_FACTOR 2
+
+/**
+ * @def VALVE_PULSE_MS
+ * @brief Longest open time of one pulse in closed-loop watering (in ms)
+ * 
+ */
+#define VALVE_PULSE_MS 15000
+
+/**
+ * @def VALVE_SOAK_MS
+ * @brief Wait after a pulse before the sensor is read again (in ms)
+ * 
+ * Gives the water time to reach the sensor.
+ * 
+ */
+#define VALVE_SOAK_MS 60000
+
+/**
+ * @brief Start the valve scheduler task
+ * 
+ * The scheduler opens valves for requested durations without blocking the
+ * caller. Several valves can be open at once, up to max_open.
+ * 
+ * @param[in] valve_list Array of valves, must stay valid
+ * @param[in] len Number of valves
+ * @param[in] max_open Maximum number of valves open at once (pump/pressure
+ * limit)
+ * @param[in] reader ADC reader of the valve sensors, NULL if closed-loop
+ * watering is not used
+ * 
+ * @retval 0 Success
+ * @retval -1 Fail
+ * 
+ * @warning setup_valve() must be called before function call
+ * 
+ */
+int valve_scheduler_start(valve* valve_list, int len, int max_open,
+    adc_reader* reader);
+
+/**
+ * @brief Request watering with a valve
+ * 
+ * Queues the valve to be opened for the given duration as soon as a valve slot
+ * is free. Returns immediately. A request for a valve that is already open or
+ * waiting is ignored.
+ * 
+ * @param[in] valve_id Index of valve in valve_list
+ * @param[in] duration_ms Open time (in ms)
+ * 
+ * @retval 0 Request queued
+ * @retval -1 Queue full or scheduler not started
+ * 
+ */
+int valve_request(int valve_id, int duration_ms);
+
+/**
+ * @brief Request watering of a valve until its soil is moist
+ * 
+ * Nothing is done if the valve's sensor reads low or more. Otherwise the
+ * valve is opened in pulses of up to VALVE_PULSE_MS, each followed by
+ * VALVE_SOAK_MS before the sensor is read again, until it reads high or the
+ * valve was open for max_ms in total. Valves without a sensor, or whose
+ * sensor cannot be read, are opened once for max_ms. Returns immediately.
+ * 
+ * @param[in] valve_id Index of valve in valve_list
+ * @param[in] max_ms Longest total open time (in ms)
+ * @param[in] low Moisture below which watering starts (in hundredths of a
+ * percent)
+ * @param[in] high Moisture at which watering stops (in hundredths of a
+ * percent)
+ * 
+ * @retval 0 Request queued
+ * @retval -1 Queue full or scheduler not started
+ * 
+ */
+int valve_request_band(int valve_id, int max_ms, int low, int high);
+
+/**
+ * @brief Number of valves open, waiting to open or soaking
+ * 
+ * Requests count from the moment they are sent, so a caller waiting for 0
+ * never sees one that is still on its way to the valve task.
+ * 
+ * @return Count of active valve requests
+ * 
+ */
+int valves_active(void);
+
 #endif
\ No newline at end of file
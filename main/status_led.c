@@ -0,0 +1,86 @@
+#include "status_led.h"
+
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "led_strip.h"
+
+static led_strip_handle_t led_strip = NULL;
+static QueueHandle_t led_queue = NULL;
+
+static void led_task(void *pvParameters) {
+    led_pattern pattern;
+
+    while (1) {
+        if (xQueueReceive(led_queue, &pattern, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        for (int i = 0; i < pattern.count; i++) {
+            led_strip_set_pixel(led_strip, 0, pattern.r, pattern.g, pattern.b);
+            led_strip_refresh(led_strip);
+            vTaskDelay(pdMS_TO_TICKS(pattern.on_ms));
+
+            led_strip_clear(led_strip);
+            if (pattern.off_ms > 0) {
+                vTaskDelay(pdMS_TO_TICKS(pattern.off_ms));
+            }
+        }
+    }
+}
+
+int led_start(void) {
+    if (led_queue != NULL) {
+        return 0;
+    }
+
+    // Configure strip to include RGB pin on board
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = RGB_PIN,
+        .max_leds = 1
+    };
+    led_strip_rmt_config_t rmt_config = {
+        .resolution_hz = 10 * 1000 * 1000
+    };
+    if (led_strip_new_rmt_device(&strip_config, &rmt_config, 
+        &led_strip) != ESP_OK) {
+            printf("ERROR creating LED strip.\n");
+            return -1;
+    }
+    led_strip_clear(led_strip);
+
+    led_queue = xQueueCreate(LED_QUEUE_LEN, sizeof(led_pattern));
+    if (led_queue == NULL) {
+        printf("ERROR allocating LED queue.\n");
+        return -1;
+    }
+
+    if (xTaskCreate(led_task, "StatusLedTask", 2048, NULL, 1, NULL) != pdPASS) {
+        printf("ERROR starting LED task.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int led_show(const led_pattern* pattern) {
+    if (led_queue == NULL || xQueueSend(led_queue, pattern, 0) != pdTRUE) {
+        return -1;
+    }
+
+    return 0;
+}
+
+void display_rgb(const int r, const int g, const int b, const int delay) {
+    led_pattern pattern = {
+        .r = r,
+        .g = g,
+        .b = b,
+        .on_ms = delay,
+        .off_ms = 0,
+        .count = 1
+    };
+    led_show(&pattern);
+}
@@ -0,0 +1,89 @@
+/**
+ * @file status_led.h
+ * @brief Asynchronous RGB status LED
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Owns a single LED strip device for the on-board RGB LED, created
+ * once at start. Callers queue blink patterns and return immediately, a low
+ * priority task plays them in order.
+ *
+ */
+
+#ifndef STATUS_LED_H
+#define STATUS_LED_H
+
+#include <stdint.h>
+
+/**
+ * @def RGB_PIN
+ * @brief GPIO pin number for RGB control
+ * 
+ * @note This pin number can be different for every development board. Please
+ * check to make sure this matches your boards.
+ * 
+ */
+#define RGB_PIN 38
+
+/**
+ * @def LED_QUEUE_LEN
+ * @brief Maximum number of patterns waiting to be shown
+ *
+ */
+#define LED_QUEUE_LEN 8
+
+/**
+ * @brief Blink pattern
+ *
+ */
+typedef struct {
+    uint8_t r;                  /**< Red color intensity (0-255) */
+    uint8_t g;                  /**< Green color intensity (0-255) */
+    uint8_t b;                  /**< Blue color intensity (0-255) */
+    uint16_t on_ms;             /**< Time LED is on per blink (in ms) */
+    uint16_t off_ms;            /**< Time LED is off after each blink (in ms) */
+    uint8_t count;              /**< Number of blinks */
+} led_pattern;
+
+/**
+ * @brief Start the status LED task
+ *
+ * Creates the LED strip device on RGB_PIN and the task that shows patterns.
+ *
+ * @retval 0 Success
+ * @retval -1 Fail
+ *
+ */
+int led_start(void);
+
+/**
+ * @brief Queue a blink pattern
+ *
+ * Returns immediately, the pattern is shown after the ones queued before it.
+ *
+ * @param[in] pattern Pattern to show
+ *
+ * @retval 0 Pattern queued
+ * @retval -1 Queue full or LED not started
+ *
+ */
+int led_show(const led_pattern* pattern);
+
+/**
+ * @brief Display RGB value on ESP32
+ * 
+ * Queues the specified color value to be kept on for a given duration before
+ * turning it off. Does not block.
+ * 
+ * @param[in] r Red color intensity (0-255)
+ * @param[in] g Green color intensity (0-255)
+ * @param[in] b Blue color intensity (0-255)
+ * @param[in] delay Duration to keep RGB on (in ms)
+ * 
+ * @warning led_start() must be called before function call
+ * 
+ */
+void display_rgb(const int r, const int g, const int b, const int delay);
+
+#endif
@@ -0,0 +1,107 @@
+#include "telemetry.h"
+
+static int put_varint(uint8_t* out, uint32_t value) {
+    int len = 0;
+    while (value >= 0x80) {
+        out[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[len++] = (uint8_t)value;
+
+    return len;
+}
+
+static int get_varint(const uint8_t* data, int len, uint32_t* value) {
+    uint32_t result = 0;
+    for (int i = 0; i < len && i < 5; i++) {
+        result |= (uint32_t)(data[i] & 0x7F) << (7 * i);
+        if (!(data[i] & 0x80)) {
+            *value = result;
+            return i + 1;
+        }
+    }
+
+    return -1;
+}
+
+void pack_init(telemetry_packer* packer, uint8_t* buffer, int size) {
+    packer->buffer = buffer;
+    packer->size = size;
+    packer->len = 0;
+    packer->count = 0;
+    packer->last = 0;
+}
+
+int pack_record(telemetry_packer* packer, const telemetry_record* record) {
+    uint8_t entry[TELEMETRY_HEADER_SIZE + TELEMETRY_RECORD_MAX];
+    int len = 0;
+    uint32_t last = packer->last;
+
+    // First reading sets the base timestamp
+    if (packer->count == 0) {
+        entry[len++] = TELEMETRY_VERSION;
+        for (int i = 0; i < 4; i++) {
+            entry[len++] = (uint8_t)(record->timestamp >> (8 * i));
+        }
+        last = record->timestamp;
+    }
+
+    // Zigzag keeps small negative deltas short
+    int32_t delta = (int32_t)(record->timestamp - last);
+    len += put_varint(entry + len,
+        ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+    entry[len++] = record->sensor_id;
+    entry[len++] = (uint8_t)record->moisture;
+    entry[len++] = (uint8_t)(record->moisture >> 8);
+
+    if (packer->len + len > packer->size) {
+        return -1;
+    }
+
+    for (int i = 0; i < len; i++) {
+        packer->buffer[packer->len + i] = entry[i];
+    }
+    packer->len += len;
+    packer->count++;
+    packer->last = record->timestamp;
+
+    return 0;
+}
+
+int unpack_records(const uint8_t* data, int len, telemetry_record* records,
+    int max) {
+        if (max <= 0 || len == 0) {
+            return 0;
+        }
+        if (len < TELEMETRY_HEADER_SIZE || data[0] != TELEMETRY_VERSION) {
+            return -1;
+        }
+
+        uint32_t last = 0;
+        for (int i = 0; i < 4; i++) {
+            last |= (uint32_t)data[1 + i] << (8 * i);
+        }
+
+        int pos = TELEMETRY_HEADER_SIZE;
+        int count = 0;
+        while (count < max && pos < len) {
+            uint32_t zigzag;
+            int used = get_varint(data + pos, len - pos, &zigzag);
+            if (used < 0 || pos + used + 3 > len) {
+                return -1;
+            }
+            pos += used;
+
+            int32_t delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            last += (uint32_t)delta;
+
+            records[count].timestamp = last;
+            records[count].sensor_id = data[pos];
+            records[count].moisture = data[pos + 1] | (data[pos + 2] << 8);
+            records[count].reserved = 0;
+            pos += 3;
+            count++;
+        }
+
+        return count;
+}
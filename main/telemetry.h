@@ -0,0 +1,120 @@
+/**
+ * @file telemetry.h
+ * @brief Packed binary encoding of sensor readings
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Encodes sensor readings into a dense byte stream for local storage
+ * and for transports that do not need JSON. A stream starts with a version
+ * byte and a base timestamp, followed by one entry per reading:
+ *
+ * | Field      | Encoding                                      |
+ * |------------|-----------------------------------------------|
+ * | Time delta | Zigzag varint, seconds since previous reading |
+ * | Sensor     | 1 byte, index of sensor in sensor array       |
+ * | Moisture   | 2 bytes little endian, hundredths of a percent |
+ *
+ * Readings of one cycle share a timestamp, so most entries are 4 bytes.
+ *
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+/**
+ * @def TELEMETRY_VERSION
+ * @brief Format version written at the start of every stream
+ *
+ */
+#define TELEMETRY_VERSION 1
+
+/**
+ * @def TELEMETRY_HEADER_SIZE
+ * @brief Size of the stream header (version and base timestamp, in bytes)
+ *
+ */
+#define TELEMETRY_HEADER_SIZE 5
+
+/**
+ * @def TELEMETRY_RECORD_MIN
+ * @brief Smallest encoded reading (in bytes)
+ *
+ */
+#define TELEMETRY_RECORD_MIN 4
+
+/**
+ * @def TELEMETRY_RECORD_MAX
+ * @brief Largest encoded reading (in bytes)
+ *
+ */
+#define TELEMETRY_RECORD_MAX 8
+
+/**
+ * @brief Compact binary sensor record (8 bytes)
+ *
+ */
+typedef struct {
+    uint32_t timestamp;         /**< Time of reading (epoch seconds) */
+    uint16_t moisture;          /**< Moisture in hundredths of a percent */
+    uint8_t sensor_id;          /**< Index of sensor in sensor array */
+    uint8_t reserved;           /**< Unused, kept for alignment */
+} telemetry_record;
+
+/**
+ * @brief Stream being written
+ *
+ */
+typedef struct {
+    uint8_t* buffer;            /**< Destination of stream */
+    int size;                   /**< Size of buffer */
+    int len;                    /**< Bytes written */
+    int count;                  /**< Readings written */
+    uint32_t last;              /**< Timestamp of previous reading */
+} telemetry_packer;
+
+/**
+ * @brief Start a stream
+ *
+ * The header is written with the first reading.
+ *
+ * @param[out] packer Stream state
+ * @param[out] buffer Destination of stream
+ * @param[in] size Size of buffer
+ *
+ */
+void pack_init(telemetry_packer* packer, uint8_t* buffer, int size);
+
+/**
+ * @brief Append a reading to a stream
+ *
+ * @param[in, out] packer Stream state
+ * @param[in] record Reading to append
+ *
+ * @retval 0 Success
+ * @retval -1 Not enough room, stream is left unchanged
+ *
+ */
+int pack_record(telemetry_packer* packer, const telemetry_record* record);
+
+/**
+ * @brief Decode readings from a stream
+ *
+ * Stops after max readings or at the end of the data, whichever comes first,
+ * so a stream followed by padding can be read with a known count.
+ *
+ * @param[in] data Encoded stream
+ * @param[in] len Length of data
+ * @param[out] records Destination for readings
+ * @param[in] max Size of records
+ *
+ * @return Number of readings decoded
+ * @retval -1 Unknown version or truncated reading
+ *
+ */
+int unpack_records(const uint8_t* data, int len, telemetry_record* records,
+    int max);
+
+#endif
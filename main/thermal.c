@@ -0,0 +1,144 @@
+#include "thermal.h"
+
+#include <stdio.h>
+
+#include "driver/temperature_sensor.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static temperature_sensor_handle_t temp_handle = NULL;
+static SemaphoreHandle_t sensor_lock = NULL;
+static portMUX_TYPE history_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static float history[THERMAL_HISTORY];
+static int history_pos = 0;
+static int history_len = 0;
+
+// Current reporting window
+static float window_min;
+static float window_max;
+static float window_sum;
+static int window_count = 0;
+
+int thermal_init(void) {
+    if (temp_handle != NULL) {
+        return 0;
+    }
+
+    sensor_lock = xSemaphoreCreateMutex();
+    if (sensor_lock == NULL) {
+        printf("ERROR creating temperature sensor lock.\n");
+        return -1;
+    }
+
+    temperature_sensor_config_t temp_sensor_config_low = 
+        TEMPERATURE_SENSOR_CONFIG_DEFAULT(-10, 80);
+    if (temperature_sensor_install(&temp_sensor_config_low, 
+        &temp_handle) != ESP_OK) {
+            printf("ERROR installing temperature sensor.\n");
+            temp_handle = NULL;
+            return -1;
+    }
+    if (temperature_sensor_enable(temp_handle) != ESP_OK) {
+        printf("ERROR enabling temperature sensor.\n");
+        temperature_sensor_uninstall(temp_handle);
+        temp_handle = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+float get_chip_temp(void) {
+    if (temp_handle == NULL) {
+        return -1.00;
+    }
+
+    float tsens_out = -1;
+    xSemaphoreTake(sensor_lock, portMAX_DELAY);
+    if (temperature_sensor_get_celsius(temp_handle, &tsens_out) != ESP_OK) {
+        tsens_out = -1;
+    }
+    xSemaphoreGive(sensor_lock);
+
+    return tsens_out;
+}
+
+int thermal_sample(void) {
+    if (temp_handle == NULL) {
+        return -1;
+    }
+
+    float temp;
+    xSemaphoreTake(sensor_lock, portMAX_DELAY);
+    esp_err_t err = temperature_sensor_get_celsius(temp_handle, &temp);
+    xSemaphoreGive(sensor_lock);
+    if (err != ESP_OK) {
+        return -1;
+    }
+
+    taskENTER_CRITICAL(&history_lock);
+    history[history_pos] = temp;
+    history_pos = (history_pos + 1) % THERMAL_HISTORY;
+    if (history_len < THERMAL_HISTORY) {
+        history_len++;
+    }
+
+    if (window_count == 0 || temp < window_min) {
+        window_min = temp;
+    }
+    if (window_count == 0 || temp > window_max) {
+        window_max = temp;
+    }
+    window_sum += temp;
+    window_count++;
+    taskEXIT_CRITICAL(&history_lock);
+
+    return 0;
+}
+
+thermal_window thermal_take_window(void) {
+    thermal_window window = { 0 };
+
+    taskENTER_CRITICAL(&history_lock);
+    if (window_count > 0) {
+        window.min = window_min;
+        window.max = window_max;
+        window.avg = window_sum / window_count;
+        window.count = window_count;
+    }
+    window_sum = 0;
+    window_count = 0;
+    taskEXIT_CRITICAL(&history_lock);
+
+    return window;
+}
+
+void thermal_restore_window(const thermal_window* window) {
+    if (window->count == 0) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&history_lock);
+    if (window_count == 0 || window->min < window_min) {
+        window_min = window->min;
+    }
+    if (window_count == 0 || window->max > window_max) {
+        window_max = window->max;
+    }
+    window_sum += window->avg * window->count;
+    window_count += window->count;
+    taskEXIT_CRITICAL(&history_lock);
+}
+
+int thermal_history(float* samples, int max) {
+    taskENTER_CRITICAL(&history_lock);
+    int count = history_len < max ? history_len : max;
+    int start = (history_pos - count + THERMAL_HISTORY) % THERMAL_HISTORY;
+    for (int i = 0; i < count; i++) {
+        samples[i] = history[(start + i) % THERMAL_HISTORY];
+    }
+    taskEXIT_CRITICAL(&history_lock);
+
+    return count;
+}
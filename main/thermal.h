@@ -0,0 +1,96 @@
+/**
+ * @file thermal.h
+ * @brief Chip temperature telemetry
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Installs the internal temperature sensor once and samples it as a
+ * regular telemetry channel. Samples are kept in a history ring buffer and
+ * summarized (min/max/avg) per reporting window. All functions can be called
+ * from several tasks at once.
+ *
+ */
+
+#ifndef THERMAL_H
+#define THERMAL_H
+
+#include <stdint.h>
+
+/**
+ * @def THERMAL_HISTORY
+ * @brief Number of samples kept in the history ring buffer
+ *
+ */
+#define THERMAL_HISTORY 60
+
+/**
+ * @brief Summary of the samples in a reporting window
+ *
+ */
+typedef struct {
+    float min;                  /**< Lowest temperature (in C) */
+    float max;                  /**< Highest temperature (in C) */
+    float avg;                  /**< Mean temperature (in C) */
+    int count;                  /**< Number of samples, 0 if none */
+} thermal_window;
+
+/**
+ * @brief Install and enable the temperature sensor
+ *
+ * @retval 0 Success
+ * @retval -1 Fail
+ *
+ * @note Must be called once before the other functions.
+ *
+ */
+int thermal_init(void);
+
+/**
+ * @brief Get ESP32 chip temperature
+ * 
+ * @return Current chip temperature as float, -1.00 on failure
+ * 
+ */
+float get_chip_temp(void);
+
+/**
+ * @brief Read the chip temperature and add it to the history
+ *
+ * @retval 0 Success
+ * @retval -1 Read failed
+ *
+ */
+int thermal_sample(void);
+
+/**
+ * @brief Summarize the current reporting window and start a new one
+ *
+ * @return Summary of the samples since the last call
+ *
+ */
+thermal_window thermal_take_window(void);
+
+/**
+ * @brief Put a taken window back, e.g. after a failed upload
+ *
+ * Merges the summary with the samples taken since, so the next
+ * thermal_take_window() covers both.
+ *
+ * @param[in] window Summary returned by thermal_take_window()
+ *
+ */
+void thermal_restore_window(const thermal_window* window);
+
+/**
+ * @brief Copy the sample history
+ *
+ * @param[out] samples Destination, oldest sample first
+ * @param[in] max Size of samples
+ *
+ * @return Number of samples copied
+ *
+ */
+int thermal_history(float* samples, int max);
+
+#endif
@@ -0,0 +1,242 @@
+#include "time_sync.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "esp_attr.h"
+#include "esp_sntp.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "scheduler.h"
+
+#define TIME_MAGIC 0x54494D45
+#define TIME_SYNCED_BIT (1 << 0)
+#define TIME_NVS_NAMESPACE "time"
+
+// Known time is saved at least this often for power loss (in s)
+#define TIME_SAVE_INTERVAL 3600
+
+// Shortest time between syncs used to measure drift (in s)
+#define TIME_DRIFT_MIN_SPAN 600
+
+/**
+ * @brief Clock state kept in RTC memory across deep sleep
+ * 
+ */
+typedef struct {
+    uint32_t magic;             // TIME_MAGIC once initialized
+    time_t last_sync;
+    time_t last_correction;     // Time drift was last corrected
+    int64_t corrected_ms;       // Drift corrections since last sync
+    int32_t drift_ppm;
+} time_state;
+
+RTC_DATA_ATTR static time_state rtc;
+static EventGroupHandle_t time_events = NULL;
+static bool synced = false;
+static bool estimated = false;
+static volatile bool unsaved = false;
+static time_t saved_at = 0;
+
+static int64_t to_ms(const struct timeval* tv) {
+    return (int64_t)tv->tv_sec * 1000 + tv->tv_usec / 1000;
+}
+
+static void set_clock_ms(int64_t ms) {
+    struct timeval tv = {
+        .tv_sec = ms / 1000,
+        .tv_usec = (ms % 1000) * 1000
+    };
+    settimeofday(&tv, NULL);
+}
+
+static void load_saved(time_t* last_time) {
+    nvs_handle_t handle;
+    if (nvs_open(TIME_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+
+    int64_t value;
+    if (nvs_get_i64(handle, "last_time", &value) == ESP_OK) {
+        *last_time = (time_t)value;
+    }
+    if (nvs_get_i64(handle, "last_sync", &value) == ESP_OK) {
+        rtc.last_sync = (time_t)value;
+    }
+    if (nvs_get_i64(handle, "drift", &value) == ESP_OK &&
+        value >= -TIME_DRIFT_MAX && value <= TIME_DRIFT_MAX) {
+            rtc.drift_ppm = (int32_t)value;
+    }
+    nvs_close(handle);
+}
+
+int time_restore(void) {
+    setenv("TZ", TIME_ZONE, 1);
+    tzset();
+
+    if (time_events == NULL) {
+        time_events = xEventGroupCreate();
+    }
+
+    // RTC memory is cleared by a power loss
+    time_t last_time = 0;
+    if (rtc.magic != TIME_MAGIC) {
+        memset(&rtc, 0, sizeof(time_state));
+        rtc.magic = TIME_MAGIC;
+        nvs_flash_init();
+        load_saved(&last_time);
+    }
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    if (now.tv_sec >= SCHED_TIME_VALID) {
+        // Clock kept running, remove the drift since the last correction
+        if (rtc.last_correction > 0 && now.tv_sec > rtc.last_correction) {
+            int64_t error_ms = (int64_t)(now.tv_sec - rtc.last_correction) *
+                rtc.drift_ppm / 1000;
+            set_clock_ms(to_ms(&now) + error_ms);
+            rtc.corrected_ms += error_ms;
+        }
+        rtc.last_correction = time(NULL);
+        return 0;
+    }
+
+    // Clock lost, the last known time is the best estimate
+    if (last_time >= SCHED_TIME_VALID) {
+        set_clock_ms((int64_t)last_time * 1000);
+        estimated = true;
+        rtc.last_correction = last_time;
+        printf("Clock lost, estimated from last known time.\n");
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Apply a time received by SNTP
+ * 
+ * Replaces the weak default in ESP-IDF so the offset of the local clock can be
+ * measured before it is overwritten. Runs in the TCP/IP task.
+ * 
+ */
+void sntp_sync_time(struct timeval* tv) {
+    struct timeval local;
+    gettimeofday(&local, NULL);
+    int64_t offset_ms = to_ms(tv) - to_ms(&local);
+
+    settimeofday(tv, NULL);
+    sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+
+    // Drift is the offset left plus the corrections already made
+    time_t span = tv->tv_sec - rtc.last_sync;
+    if (!estimated && rtc.last_sync >= SCHED_TIME_VALID &&
+        local.tv_sec >= SCHED_TIME_VALID && span >= TIME_DRIFT_MIN_SPAN) {
+            int64_t drift = (offset_ms + rtc.corrected_ms) * 1000 / span;
+            if (drift > TIME_DRIFT_MAX) {
+                drift = TIME_DRIFT_MAX;
+            }
+            else if (drift < -TIME_DRIFT_MAX) {
+                drift = -TIME_DRIFT_MAX;
+            }
+            rtc.drift_ppm = (int32_t)drift;
+    }
+
+    rtc.last_sync = tv->tv_sec;
+    rtc.last_correction = tv->tv_sec;
+    rtc.corrected_ms = 0;
+    synced = true;
+    estimated = false;
+    unsaved = true;
+
+    if (time_events != NULL) {
+        xEventGroupSetBits(time_events, TIME_SYNCED_BIT);
+    }
+
+    // Clock may have stepped, deadlines must be recomputed
+    scheduler_recompute();
+}
+
+int calibrate_time(void) {
+    if (time_events == NULL) {
+        time_events = xEventGroupCreate();
+        if (time_events == NULL) {
+            printf("ERROR creating time event group.\n");
+            return -1;
+        }
+    }
+    xEventGroupClearBits(time_events, TIME_SYNCED_BIT);
+
+    // Client is started once and keeps syncing in the background
+    if (!esp_sntp_enabled()) {
+        sntp_set_sync_interval(TIME_SYNC_INTERVAL);
+        esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+        esp_sntp_setservername(0, TIME_SERVER);
+        esp_sntp_init();
+    }
+    else {
+        sntp_restart();
+    }
+
+    // Wait until the first response, not a fixed delay
+    EventBits_t bits = xEventGroupWaitBits(time_events, TIME_SYNCED_BIT, 
+        pdFALSE, pdTRUE, pdMS_TO_TICKS(TIME_SYNC_TIMEOUT));
+    if (!(bits & TIME_SYNCED_BIT)) {
+        printf("ERROR no SNTP response.\n");
+        return -1;
+    }
+
+    time_persist();
+
+    return 0;
+}
+
+bool time_needs_sync(int max_age) {
+    time_t now = time(NULL);
+
+    return estimated || rtc.last_sync < SCHED_TIME_VALID || 
+        now < rtc.last_sync || now - rtc.last_sync > max_age;
+}
+
+void time_persist(void) {
+    time_t now = time(NULL);
+    if (now < SCHED_TIME_VALID || estimated || 
+        (!unsaved && now - saved_at < TIME_SAVE_INTERVAL)) {
+            return;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(TIME_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        printf("ERROR opening time storage.\n");
+        return;
+    }
+
+    unsaved = false;
+    if (nvs_set_i64(handle, "last_time", now) != ESP_OK ||
+        nvs_set_i64(handle, "last_sync", rtc.last_sync) != ESP_OK ||
+        nvs_set_i64(handle, "drift", rtc.drift_ppm) != ESP_OK ||
+        nvs_commit(handle) != ESP_OK) {
+            printf("ERROR saving time.\n");
+            unsaved = true;
+    }
+    else {
+        saved_at = now;
+    }
+    nvs_close(handle);
+}
+
+time_status get_time_status(void) {
+    time_status status = {
+        .synced = synced,
+        .estimated = estimated,
+        .last_sync = rtc.last_sync,
+        .drift_ppm = rtc.drift_ppm
+    };
+
+    return status;
+}
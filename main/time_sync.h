@@ -0,0 +1,130 @@
+/**
+ * @file time_sync.h
+ * @brief System time bring-up, SNTP synchronization and persistence
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Restores the clock at boot before the network is up, so scheduling
+ * can start right away. The RTC clock keeps running across deep sleep and
+ * software resets, after a power loss the last known time is loaded from NVS
+ * as an estimate until SNTP corrects it.
+ *
+ * Every SNTP sync measures the drift of the RTC clock since the previous sync.
+ * The drift is kept in RTC memory and NVS and applied when waking up, which
+ * keeps the clock close between syncs.
+ *
+ */
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * @def TIME_SERVER
+ * @brief SNTP server name or address
+ *
+ * @note Can be pointed at a local NTP server for testing.
+ *
+ */
+#define TIME_SERVER "pool.ntp.org"
+
+/**
+ * @def TIME_ZONE
+ * @brief POSIX time zone of the planter (Los Angeles)
+ *
+ */
+#define TIME_ZONE "PST8PDT,M3.2.0,M11.1.0"
+
+/**
+ * @def TIME_SYNC_TIMEOUT
+ * @brief Longest wait for the first SNTP response (in ms)
+ *
+ */
+#define TIME_SYNC_TIMEOUT 10000
+
+/**
+ * @def TIME_SYNC_INTERVAL
+ * @brief Time between SNTP syncs while awake (in ms)
+ *
+ */
+#define TIME_SYNC_INTERVAL 10800000
+
+/**
+ * @def TIME_DRIFT_MAX
+ * @brief Largest drift correction accepted (in ppm)
+ *
+ */
+#define TIME_DRIFT_MAX 50000
+
+/**
+ * @brief State of the system clock
+ *
+ */
+typedef struct {
+    bool synced;                /**< Set by SNTP since boot or deep sleep */
+    bool estimated;             /**< Loaded from NVS after a power loss */
+    time_t last_sync;           /**< Time of last SNTP sync, 0 if none */
+    int32_t drift_ppm;          /**< RTC correction (in ppm), < 0 if fast */
+} time_status;
+
+/**
+ * @brief Restore the system clock at boot
+ *
+ * Sets the time zone, corrects the RTC drift since the last correction and
+ * loads the last known time from NVS if the clock was lost.
+ *
+ * @retval 0 Clock is set
+ * @retval -1 Time unknown until SNTP sync
+ *
+ * @note Call before the scheduler starts. Does not need WiFi.
+ *
+ */
+int time_restore(void);
+
+/**
+ * @brief Synchronize system time using SNTP
+ *
+ * Starts the SNTP client on the first call and waits until a sync is
+ * received. The client keeps syncing every TIME_SYNC_INTERVAL.
+ *
+ * @retval 0 Time synchronized
+ * @retval -1 No response within TIME_SYNC_TIMEOUT
+ *
+ * @note WiFi must be initialized before calibration.
+ *
+ */
+int calibrate_time(void);
+
+/**
+ * @brief Check if the clock needs an SNTP sync
+ *
+ * @param[in] max_age Longest time since the last sync (in s)
+ *
+ * @retval true Never synced, estimated or older than max_age
+ * @retval false Clock is recent enough
+ *
+ */
+bool time_needs_sync(int max_age);
+
+/**
+ * @brief Save the last sync to NVS
+ *
+ * Only writes if a sync happened since the last save, so it can be called
+ * every cycle.
+ *
+ */
+void time_persist(void);
+
+/**
+ * @brief Get state of the system clock
+ *
+ * @return Copy of the clock state
+ *
+ */
+time_status get_time_status(void);
+
+#endif
@@ -0,0 +1,229 @@
+#include "wifi_manager.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "nvs_flash.h"
+#include "secrets.h"
+
+#define WIFI_CONNECTED_BIT (1 << 0)
+#define WIFI_FAIL_BIT (1 << 1)
+
+/**
+ * @brief Access point of the last connection
+ * 
+ */
+typedef struct {
+    bool valid;
+    uint8_t bssid[6];
+    uint8_t channel;
+} ap_cache;
+
+RTC_DATA_ATTR static ap_cache last_ap;
+static EventGroupHandle_t wifi_events = NULL;
+static esp_netif_t* sta_netif = NULL;
+static bool handlers_registered = false;
+static bool initialized = false;        // Whole setup succeeded
+static bool cache_used = false;
+static int retries = 0;
+
+static int apply_config(bool use_cache) {
+    wifi_config_t wifi_config = {
+        .sta = {
+            .ssid = USER_SSID,
+            .password = USER_PASS,
+            .sae_pwe_h2e = WPA3_SAE_PWE_HUNT_AND_PECK,
+            .failure_retry_cnt = 3
+        }
+    };
+
+    // Skip the scan of every channel when the access point is known
+    cache_used = use_cache && last_ap.valid;
+    if (cache_used) {
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+        wifi_config.sta.channel = last_ap.channel;
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, last_ap.bssid, sizeof(last_ap.bssid));
+    }
+    else {
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    }
+
+    if (esp_wifi_set_config(WIFI_IF_STA, &wifi_config) != ESP_OK) {
+        printf("ERROR setting WiFi config.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static void wifi_event_handler(void* arg, esp_event_base_t base, int32_t id,
+    void* data) {
+        if (base == WIFI_EVENT && id == WIFI_EVENT_STA_CONNECTED) {
+            const wifi_event_sta_connected_t* event = data;
+            memcpy(last_ap.bssid, event->bssid, sizeof(last_ap.bssid));
+            last_ap.channel = event->channel;
+            last_ap.valid = true;
+        }
+        else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
+            xEventGroupClearBits(wifi_events, WIFI_CONNECTED_BIT);
+
+            // Access point may have moved, fall back to a full scan
+            if (cache_used) {
+                last_ap.valid = false;
+                apply_config(false);
+            }
+
+            if (retries < WIFI_MAX_RETRY) {
+                retries++;
+                esp_wifi_connect();
+            }
+            else {
+                xEventGroupSetBits(wifi_events, WIFI_FAIL_BIT);
+            }
+        }
+        else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+            retries = 0;
+            xEventGroupClearBits(wifi_events, WIFI_FAIL_BIT);
+            xEventGroupSetBits(wifi_events, WIFI_CONNECTED_BIT);
+        }
+}
+
+static int start_driver(void) {
+    if (esp_wifi_set_mode(WIFI_MODE_STA) != ESP_OK) {
+        printf("ERROR setting WiFi mode.\n");
+        return -1;
+    }
+    if (apply_config(true) == -1) {
+        return -1;
+    }
+
+    // Start WiFi
+    if (esp_wifi_start() != ESP_OK) {
+        printf("ERROR starting WiFi.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int setup_driver(void) {
+    // Initialize NVS partition
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || 
+        err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+            nvs_flash_erase();
+            err = nvs_flash_init();
+    }
+    if (err != ESP_OK) {
+        printf("ERROR initializing NVS flash.\n");
+        return -1;
+    }
+
+    // Initialize TCP/IP stack
+    if (esp_netif_init() != ESP_OK) {
+        printf("ERROR initializing NETIF.\n");
+        return -1;
+    }
+
+    // Initialize event loop for creating wifi station, steps done by an
+    // earlier failed attempt are kept
+    err = esp_event_loop_create_default();
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        printf("ERROR creating event loop.\n");
+        return -1;
+    }
+    if (sta_netif == NULL) {
+        sta_netif = esp_netif_create_default_wifi_sta();
+    }
+
+    if (wifi_events == NULL) {
+        wifi_events = xEventGroupCreate();
+        if (wifi_events == NULL) {
+            printf("ERROR creating WiFi event group.\n");
+            return -1;
+        }
+    }
+    if (!handlers_registered) {
+        if (esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, 
+            wifi_event_handler, NULL) != ESP_OK) {
+                printf("ERROR registering WiFi events.\n");
+                return -1;
+        }
+        if (esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, 
+            wifi_event_handler, NULL) != ESP_OK) {
+                printf("ERROR registering WiFi events.\n");
+                esp_event_handler_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, 
+                    wifi_event_handler);
+                return -1;
+        }
+        handlers_registered = true;
+    }
+
+    // Initialize WiFi with default config
+    wifi_init_config_t default_config = WIFI_INIT_CONFIG_DEFAULT();
+    if (esp_wifi_init(&default_config) != ESP_OK) {
+        printf("ERROR initializing WiFi.\n");
+        return -1;
+    }
+    if (start_driver() == -1) {
+        esp_wifi_deinit();
+        return -1;
+    }
+
+    return 0;
+}
+
+static int connect_and_wait(void) {
+    xEventGroupClearBits(wifi_events, WIFI_FAIL_BIT);
+    retries = 0;
+    if (esp_wifi_connect() != ESP_OK) {
+        // Attempt may already be running from another task
+        printf("WiFi connect unsuccessful.\n");
+    }
+
+    // Wait exactly until an IP is received or every attempt failed
+    EventBits_t bits = xEventGroupWaitBits(wifi_events, 
+        WIFI_CONNECTED_BIT | WIFI_FAIL_BIT, pdFALSE, pdFALSE, 
+        pdMS_TO_TICKS(WIFI_CONNECT_TIMEOUT));
+
+    return (bits & WIFI_CONNECTED_BIT) ? 0 : -1;
+}
+
+int init_wifi(void) {
+    // One time setup, retried until it succeeds, later calls only reconnect
+    if (!initialized) {
+        if (setup_driver() == -1) {
+            return -1;
+        }
+        initialized = true;
+    }
+
+    if (wifi_connected()) {
+        return 0;
+    }
+
+    return connect_and_wait() == 0 ? 0 : 1;
+}
+
+int check_wifi(void) {
+    if (!initialized) {
+        return -1;
+    }
+    if (wifi_connected()) {
+        return 0;
+    }
+
+    return connect_and_wait() == 0 ? 1 : -1;
+}
+
+bool wifi_connected(void) {
+    return initialized && 
+        (xEventGroupGetBits(wifi_events) & WIFI_CONNECTED_BIT);
+}
@@ -0,0 +1,77 @@
+/**
+ * @file wifi_manager.h
+ * @brief Event driven WiFi station management
+ * @author Nathan Lieu
+ * @date August 10, 2025
+ * @version 1.0
+ *
+ * @details Tracks the connection with WIFI_EVENT and IP_EVENT handlers and an
+ * event group, so callers wait exactly until an IP address is received
+ * instead of a fixed delay. Driver setup runs once, later calls only
+ * reconnect. The channel and BSSID of the last access point are kept in RTC
+ * memory and used for a fast scan on the next connection, also after deep
+ * sleep. A full scan is used when the cached access point cannot be reached.
+ *
+ */
+
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <stdbool.h>
+
+/**
+ * @def WIFI_CONNECT_TIMEOUT
+ * @brief Longest wait for an IP address (in ms)
+ *
+ */
+#define WIFI_CONNECT_TIMEOUT 15000
+
+/**
+ * @def WIFI_MAX_RETRY
+ * @brief Connection attempts after a disconnect before giving up
+ *
+ * @note check_wifi() starts a new round of attempts.
+ *
+ */
+#define WIFI_MAX_RETRY 3
+
+/**
+ * @brief Initialize WiFi module on ESP32
+ *
+ * Initializes NVS flash, the TCP/IP stack, the event loop and the WiFi driver
+ * on the first call, then connects using credentials specified in secrets.h
+ * file and waits until an IP address is received.
+ *
+ * @retval 0 WiFi connection successful
+ * @retval 1 WiFi connection unsuccessful
+ * @retval -1 Initialization failed
+ *
+ * @note WiFi credentials must be defined in secrets.h
+ * @warning Must be called before communicating with Firebase servers
+ *
+ */
+int init_wifi(void);
+
+/**
+ * @brief Check WiFi connection and reconnect if necessary.
+ *
+ * Checks the WiFi connection on the ESP32 and reconnects to the AP if
+ * connection is dropped.
+ *
+ * @retval 0 Connection valid
+ * @retval 1 Reconnected
+ * @retval -1 Reconnection fail
+ *
+ */
+int check_wifi(void);
+
+/**
+ * @brief Check if WiFi has an IP address
+ *
+ * @retval true Connected
+ * @retval false Not connected
+ *
+ */
+bool wifi_connected(void);
+
+#endif